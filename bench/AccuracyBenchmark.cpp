@@ -0,0 +1,334 @@
+/**
+ * @file    AccuracyBenchmark.cpp
+ * @brief   Measures how much accuracy the approximate modes of HyLoRD trade
+ * for speed and memory, writing a table with the Pareto optimal modes marked.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ *
+ * Usage: hylord_accuracy [CpG sites (20000)] [mixtures (3)] [threads (1)]
+ *        [outpath (stdout)]
+ *
+ * Mixtures of six cell types with known proportions are generated (with read
+ * sampling noise) and deconvolved exactly and under every mode below. Each
+ * run happens in a child process, so that its runtime and peak memory are
+ * its own. Errors are those of the proportions against the truth, pooled
+ * over the mixtures.
+ */
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SyntheticData.hpp"
+#include "cli.hpp"
+#include "core/hylord.hpp"
+#include "types.hpp"
+
+namespace {
+using Hylord::CMD::HylordConfig;
+
+constexpr int number_of_cell_types{6};
+constexpr int min_depth{10};
+constexpr int max_depth{60};
+constexpr std::array<int, 3> subsample_strides{2, 4, 8};
+constexpr std::array<double, 2> quantisation_steps{1, 10};
+
+/// An approximate mode, as a change to the exact configuration.
+struct Mode {
+   std::string name;
+   std::string parameter;
+   std::function<void(HylordConfig&)> apply;
+};
+
+struct Measurement {
+   double runtime_ms{};
+   double peak_memory_mb{};
+   double rmse{};
+   double max_absolute_error{};
+   bool pareto_optimal{};
+};
+
+/**
+ * Modes trading exactness for speed or memory. Early stopping withholds the
+ * last cell type from the reference, so it has to be learned as a novel cell
+ * type (see --additional-cell-types).
+ */
+auto approximateModes() -> std::vector<Mode> {
+   std::vector<Mode> modes{{"exact", "-", [](HylordConfig&) {}}};
+   for (const int stride : subsample_strides) {
+      modes.push_back({"subsample_cpgs",
+                       "1/" + std::to_string(stride),
+                       [stride](HylordConfig& config) {
+                          config.cpg_list_file =
+                              "cpgs_every_" + std::to_string(stride) + ".bed";
+                       }});
+   }
+   for (const int min_read_depth : {20, 40}) {
+      modes.push_back({"min_read_depth",
+                       std::to_string(min_read_depth),
+                       [min_read_depth](HylordConfig& config) {
+                          config.min_read_depth = min_read_depth;
+                       }});
+   }
+   for (const double step : quantisation_steps) {
+      const std::string suffix{"_q" + std::to_string(static_cast<int>(step))};
+      modes.push_back({"quantise",
+                       std::to_string(static_cast<int>(step)) + "%",
+                       [suffix](HylordConfig& config) {
+                          config.reference_matrix_file =
+                              "reference" + suffix + ".bed";
+                          config.bedmethyl_file =
+                              "bedmethyl" + suffix + ".bed";
+                       }});
+   }
+   for (const int bin_size : {1000, 5000, 20000}) {
+      modes.push_back({"bin",
+                       std::to_string(bin_size) + "bp",
+                       [bin_size](HylordConfig& config) {
+                          config.bin_size = bin_size;
+                       }});
+   }
+   modes.push_back({"signal", "m", [](HylordConfig& config) {
+                       config.use_only_methylation_signal = true;
+                    }});
+   for (const int max_iterations : {0, 1, 5}) {
+      modes.push_back({"early_stop",
+                       std::to_string(max_iterations),
+                       [max_iterations](HylordConfig& config) {
+                          config.reference_matrix_file =
+                              "reference_withheld.bed";
+                          config.additional_cell_types = 1;
+                          config.max_iterations = max_iterations;
+                       }});
+   }
+   return modes;
+}
+
+/// Writes the inputs of every mode for one mixture into `directory`.
+void writeMixture(const std::filesystem::path& directory,
+                  int cpg_sites,
+                  const Hylord::Vector& proportions,
+                  std::mt19937& generator) {
+   using namespace Hylord::Bench;
+   std::filesystem::create_directories(directory);
+   const Hylord::Matrix reference{
+       generateReference(cpg_sites, number_of_cell_types, generator)};
+   writeReference(directory / "reference.bed", reference, reference.cols());
+   writeReference(directory / "reference_withheld.bed",
+                  reference,
+                  reference.cols() - 1);
+   // Quantised bulk profiles share the reads drawn for the exact one
+   const std::mt19937 reads{generator};
+   writeBedmethyl(directory / "bedmethyl.bed",
+                  reference,
+                  proportions,
+                  generator,
+                  min_depth,
+                  max_depth,
+                  true);
+   for (const double step : quantisation_steps) {
+      const std::string suffix{"_q" + std::to_string(static_cast<int>(step))};
+      std::mt19937 same_reads{reads};
+      writeReference(directory / ("reference" + suffix + ".bed"),
+                     reference,
+                     reference.cols(),
+                     step);
+      writeBedmethyl(directory / ("bedmethyl" + suffix + ".bed"),
+                     reference,
+                     proportions,
+                     same_reads,
+                     min_depth,
+                     max_depth,
+                     true,
+                     step);
+   }
+   for (const int stride : subsample_strides) {
+      writeCpGList(
+          directory / ("cpgs_every_" + std::to_string(stride) + ".bed"),
+          reference.rows(),
+          stride);
+   }
+}
+
+/// Proportions written by a run (one "<cell type>\t<percentage>" per line).
+auto readProportions(const std::filesystem::path& path)
+    -> std::vector<double> {
+   std::ifstream file(path);
+   std::vector<double> proportions{};
+   std::string cell_type;
+   double percentage{};
+   while (file >> cell_type >> percentage) {
+      proportions.push_back(percentage / 100);
+   }
+   return proportions;
+}
+
+struct Run {
+   double runtime_ms{};
+   double peak_memory_mb{};
+   std::vector<double> proportions{};
+};
+
+/**
+ * Runs HyLoRD under the mode in a child process (from the directory of the
+ * mixture), with its standard output discarded. Returns false if it fails.
+ */
+auto runMode(const std::filesystem::path& directory,
+             const Mode& mode,
+             int threads,
+             Run& run) -> bool {
+   const std::filesystem::path out_path{directory / "proportions.tsv"};
+   std::filesystem::remove(out_path);
+   const auto start{std::chrono::steady_clock::now()};
+   const pid_t child{fork()};
+   if (child == -1) return false;
+   if (child == 0) {
+      const int null_file{open("/dev/null", O_WRONLY)};
+      if (chdir(directory.c_str()) != 0 || null_file == -1) _exit(1);
+      dup2(null_file, STDOUT_FILENO);
+      HylordConfig config{};
+      config.bedmethyl_file = "bedmethyl.bed";
+      config.reference_matrix_file = "reference.bed";
+      config.out_file_path = out_path.filename().string();
+      config.num_threads = threads;
+      mode.apply(config);
+      _exit(Hylord::run(config));
+   }
+   int status{};
+   rusage usage{};
+   if (wait4(child, &status, 0, &usage) == -1) return false;
+   run.runtime_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+   // ru_maxrss is in KiB on Linux
+   run.peak_memory_mb = static_cast<double>(usage.ru_maxrss) / 1024;
+   if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return false;
+   run.proportions = readProportions(out_path);
+   return run.proportions.size() == number_of_cell_types;
+}
+
+/// Marks measurements that no other is at least as good as in runtime, peak
+/// memory and RMSE (and better in one of them).
+void markParetoOptimal(std::vector<Measurement>& measurements) {
+   for (auto& measurement : measurements) {
+      measurement.pareto_optimal = std::ranges::none_of(
+          measurements, [&measurement](const Measurement& other) {
+             const bool no_worse{
+                 other.runtime_ms <= measurement.runtime_ms &&
+                 other.peak_memory_mb <= measurement.peak_memory_mb &&
+                 other.rmse <= measurement.rmse};
+             const bool better{
+                 other.runtime_ms < measurement.runtime_ms ||
+                 other.peak_memory_mb < measurement.peak_memory_mb ||
+                 other.rmse < measurement.rmse};
+             return no_worse && better;
+          });
+   }
+}
+
+auto median(std::vector<double> values) -> double {
+   std::ranges::sort(values);
+   return values[values.size() / 2];
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+   try {
+      const int cpg_sites{argc > 1 ? std::stoi(argv[1]) : 20000};
+      const int mixtures{argc > 2 ? std::stoi(argv[2]) : 3};
+      const int threads{argc > 3 ? std::stoi(argv[3]) : 1};
+      const std::string out_path{argc > 4 ? argv[4] : ""};
+      if (cpg_sites < 1 || mixtures < 1 || threads < 1) {
+         std::cerr << "CpG sites, mixtures and threads must be positive.\n";
+         return 1;
+      }
+
+      const std::filesystem::path directory{
+          std::filesystem::temp_directory_path() /
+          ("hylord_accuracy_" + std::to_string(getpid()))};
+      std::mt19937 generator{42};
+      std::vector<Hylord::Vector> truths{};
+      for (int mixture{}; mixture < mixtures; ++mixture) {
+         truths.push_back(Hylord::Bench::generateProportions(
+             number_of_cell_types, generator));
+         writeMixture(directory / std::to_string(mixture),
+                      cpg_sites,
+                      truths.back(),
+                      generator);
+      }
+
+      const std::vector<Mode> modes{approximateModes()};
+      std::vector<Measurement> measurements(modes.size());
+      for (std::size_t i{}; i < modes.size(); ++i) {
+         std::vector<double> runtimes{};
+         double squared_error{};
+         for (int mixture{}; mixture < mixtures; ++mixture) {
+            Run run{};
+            if (!runMode(directory / std::to_string(mixture),
+                         modes[i],
+                         threads,
+                         run)) {
+               std::cerr << "Mode " << modes[i].name << " ("
+                         << modes[i].parameter << ") failed.\n";
+               std::filesystem::remove_all(directory);
+               return 1;
+            }
+            runtimes.push_back(run.runtime_ms);
+            Measurement& measurement{measurements[i]};
+            measurement.peak_memory_mb =
+                std::max(measurement.peak_memory_mb, run.peak_memory_mb);
+            for (int cell_type{}; cell_type < number_of_cell_types;
+                 ++cell_type) {
+               const double error{
+                   run.proportions[static_cast<std::size_t>(cell_type)] -
+                   truths[static_cast<std::size_t>(mixture)](cell_type)};
+               squared_error += error * error;
+               measurement.max_absolute_error =
+                   std::max(measurement.max_absolute_error, std::abs(error));
+            }
+         }
+         measurements[i].runtime_ms = median(runtimes);
+         measurements[i].rmse = std::sqrt(
+             squared_error / (mixtures * number_of_cell_types));
+      }
+      std::filesystem::remove_all(directory);
+      markParetoOptimal(measurements);
+
+      std::stringstream table;
+      table << "mode\tparameter\truntime_ms\tpeak_memory_mb\trmse\t"
+               "max_abs_error\tpareto_optimal\n";
+      for (std::size_t i{}; i < modes.size(); ++i) {
+         const Measurement& measurement{measurements[i]};
+         table << modes[i].name << '\t' << modes[i].parameter << '\t'
+               << measurement.runtime_ms << '\t'
+               << measurement.peak_memory_mb << '\t' << measurement.rmse
+               << '\t' << measurement.max_absolute_error << '\t'
+               << (measurement.pareto_optimal ? "yes" : "no") << '\n';
+      }
+      if (out_path.empty()) {
+         std::cout << table.str();
+      } else {
+         std::ofstream(out_path) << table.str();
+      }
+      return 0;
+   } catch (const std::exception& e) {
+      std::cerr << "Benchmark failed: " << e.what() << '\n';
+      return 1;
+   }
+}
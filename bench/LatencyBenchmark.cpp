@@ -0,0 +1,130 @@
+/**
+ * @file    LatencyBenchmark.cpp
+ * @brief   Measures the end-to-end latency of HyLoRD on a synthetic targeted
+ * panel, reporting the median (p50) and tail (p99) over many runs.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ *
+ * Usage: hylord_latency [CpG sites (10000)] [runs (200)] [threads (1)]
+ *
+ * Each run parses the command line and calls Hylord::run() exactly as the
+ * hylord executable does, so only process startup is left out.
+ */
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CLI/CLI.hpp"
+#include "SyntheticData.hpp"
+#include "cli.hpp"
+#include "core/hylord.hpp"
+#include "types.hpp"
+
+namespace {
+/**
+ * Writes a reference matrix (five cell types) and a bedmethyl file mixed from
+ * it, for a panel of the given number of CpG sites.
+ */
+void writePanel(const std::filesystem::path& directory, int cpg_sites) {
+   std::mt19937 generator{42};
+   const Hylord::Matrix reference{
+       Hylord::Bench::generateReference(cpg_sites, 5, generator)};
+   Hylord::Vector proportions(5);
+   proportions << 0.4, 0.25, 0.15, 0.1, 0.1;
+   Hylord::Bench::writeReference(
+       directory / "reference.bed", reference, reference.cols());
+   Hylord::Bench::writeBedmethyl(directory / "bedmethyl.bed",
+                                 reference,
+                                 proportions,
+                                 generator,
+                                 30,
+                                 30,
+                                 false);
+}
+
+/// Nearest-rank percentile of sorted latencies.
+auto percentile(const std::vector<double>& sorted, double fraction)
+    -> double {
+   const auto rank{static_cast<std::size_t>(
+       fraction * static_cast<double>(sorted.size() - 1) + 0.5)};
+   return sorted[std::min(rank, sorted.size() - 1)];
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+   try {
+      const int cpg_sites{argc > 1 ? std::stoi(argv[1]) : 10000};
+      const int runs{argc > 2 ? std::stoi(argv[2]) : 200};
+      const std::string threads{argc > 3 ? argv[3] : "1"};
+      if (cpg_sites < 1 || runs < 1) {
+         std::cerr << "CpG sites and runs must be positive.\n";
+         return 1;
+      }
+
+      const std::filesystem::path directory{
+          std::filesystem::temp_directory_path() /
+          ("hylord_latency_" + std::to_string(getpid()))};
+      std::filesystem::create_directories(directory);
+      writePanel(directory, cpg_sites);
+      const std::filesystem::path out_path{directory / "proportions.tsv"};
+      const std::vector<std::string> arguments{
+          "hylord",
+          (directory / "bedmethyl.bed").string(),
+          "-r",
+          (directory / "reference.bed").string(),
+          "-t",
+          threads,
+          "-o",
+          out_path.string()};
+
+      std::vector<double> latencies{};
+      latencies.reserve(static_cast<std::size_t>(runs));
+      // Silences the objective printed by every run
+      std::cout.setstate(std::ios::failbit);
+      for (int run{}; run < runs; ++run) {
+         const auto start{std::chrono::steady_clock::now()};
+         CLI::App hylord_cli;
+         Hylord::CMD::HylordConfig config;
+         Hylord::CMD::setupCLI(hylord_cli, config);
+         std::vector<std::string> reversed{arguments.rbegin(),
+                                           arguments.rend() - 1};
+         hylord_cli.parse(reversed);
+         if (Hylord::run(config) != 0) {
+            std::cerr << "Run " << run << " failed.\n";
+            std::filesystem::remove_all(directory);
+            return 1;
+         }
+         latencies.push_back(std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count());
+         std::filesystem::remove(out_path);
+      }
+      std::filesystem::remove_all(directory);
+      std::cout.clear();
+
+      std::ranges::sort(latencies);
+      std::printf(
+          "%d CpG sites, %d runs, %s thread(s): p50 %.3f ms, p99 %.3f ms, "
+          "max %.3f ms\n",
+          cpg_sites,
+          runs,
+          threads.c_str(),
+          percentile(latencies, 0.5),
+          percentile(latencies, 0.99),
+          latencies.back());
+      return 0;
+   } catch (const std::exception& e) {
+      std::cerr << "Benchmark failed: " << e.what() << '\n';
+      return 1;
+   }
+}
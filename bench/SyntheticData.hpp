@@ -0,0 +1,134 @@
+#ifndef SYNTHETIC_DATA_H_
+#define SYNTHETIC_DATA_H_
+
+/**
+ * @file    SyntheticData.hpp
+ * @brief   Generates reference matrices, and bedmethyl files mixed from them
+ * with known proportions, for the benchmarks.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "types.hpp"
+
+namespace Hylord::Bench {
+/**
+ * Rows of the generated files alternate between the hydroxymethylation and
+ * methylation of a CpG site. Sites are spaced out along chr1, so that bins
+ * (see --bin-size) pool a predictable number of them.
+ */
+constexpr int site_spacing{200};
+inline auto siteStart(Eigen::Index row) -> Eigen::Index {
+   return 100 + ((row / 2) * site_spacing);
+}
+inline auto siteMark(Eigen::Index row) -> char {
+   return row % 2 == 0 ? 'h' : 'm';
+}
+
+/// Rounds a percentage to a multiple of step (left alone for a step of 0).
+inline auto quantise(double percentage, double step) -> double {
+   return step > 0 ? std::round(percentage / step) * step : percentage;
+}
+
+/**
+ * Reference percentages of every cell type. Methylation is bimodal (most
+ * sites are close to 0% or 100%) and hydroxymethylation is low, as in real
+ * panels.
+ */
+inline auto generateReference(int cpg_sites,
+                              int cell_types,
+                              std::mt19937& generator) -> Matrix {
+   std::bernoulli_distribution methylated{0.6};
+   std::uniform_real_distribution<double> offset{0.0, 20.0};
+   std::uniform_real_distribution<double> hydroxymethylation{0.0, 10.0};
+   Matrix reference(Eigen::Index{2} * cpg_sites, cell_types);
+   for (Eigen::Index row{}; row < reference.rows(); ++row) {
+      for (Eigen::Index col{}; col < reference.cols(); ++col) {
+         if (siteMark(row) == 'h') {
+            reference(row, col) = hydroxymethylation(generator);
+         } else {
+            reference(row, col) =
+                methylated(generator) ? 100 - offset(generator)
+                                      : offset(generator);
+         }
+      }
+   }
+   return reference;
+}
+
+/// Draws proportions uniformly from the simplex.
+inline auto generateProportions(int cell_types, std::mt19937& generator)
+    -> Vector {
+   std::exponential_distribution<double> weight{1.0};
+   Vector proportions(cell_types);
+   for (double& proportion : proportions) proportion = weight(generator);
+   return proportions / proportions.sum();
+}
+
+/// Writes the first `columns` columns of the reference matrix (BED4+X).
+inline void writeReference(const std::filesystem::path& path,
+                           const Matrix& reference,
+                           Eigen::Index columns,
+                           double step = 0) {
+   std::ofstream file(path);
+   for (Eigen::Index row{}; row < reference.rows(); ++row) {
+      file << "chr1\t" << siteStart(row) << '\t' << siteStart(row) + 1 << '\t'
+           << siteMark(row);
+      for (Eigen::Index col{}; col < columns; ++col) {
+         file << '\t' << quantise(reference(row, col), step);
+      }
+      file << '\n';
+   }
+}
+
+/**
+ * Writes a bedmethyl file (BED9+9) mixed from the reference with the given
+ * proportions. Read depths are drawn from [min_depth, max_depth]. If
+ * `sample_reads` is set, the fraction modified is that of reads drawn at
+ * that depth (so shallow sites are noisy), otherwise it is exact.
+ */
+inline void writeBedmethyl(const std::filesystem::path& path,
+                           const Matrix& reference,
+                           const Vector& proportions,
+                           std::mt19937& generator,
+                           int min_depth,
+                           int max_depth,
+                           bool sample_reads,
+                           double step = 0) {
+   std::uniform_int_distribution<int> depths{min_depth, max_depth};
+   std::ofstream file(path);
+   for (Eigen::Index row{}; row < reference.rows(); ++row) {
+      const int depth{depths(generator)};
+      double percentage{reference.row(row).dot(proportions)};
+      if (sample_reads) {
+         std::binomial_distribution<int> reads{
+             depth, std::clamp(percentage / 100, 0.0, 1.0)};
+         percentage = 100.0 * reads(generator) / depth;
+      }
+      file << "chr1\t" << siteStart(row) << '\t' << siteStart(row) + 1 << '\t'
+           << siteMark(row) << '\t' << depth << "\t+\t" << siteStart(row)
+           << '\t' << siteStart(row) + 1 << "\t255,0,0\t" << depth << '\t'
+           << quantise(percentage, step) << "\t0\t0\t0\t0\t0\t0\t0\n";
+   }
+}
+
+/// Writes a CpG list (BED4) holding every `stride`-th CpG site.
+inline void writeCpGList(const std::filesystem::path& path,
+                         Eigen::Index rows,
+                         int stride) {
+   std::ofstream file(path);
+   for (Eigen::Index row{}; row < rows; ++row) {
+      if ((row / 2) % stride != 0) continue;
+      file << "chr1\t" << siteStart(row) << '\t' << siteStart(row) + 1 << '\t'
+           << siteMark(row) << '\n';
+   }
+}
+}  // namespace Hylord::Bench
+
+#endif
@@ -7,20 +7,333 @@
 
 #include "cli.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdlib>
 #include <limits>
 #include <sstream>
 #include <string>
-#include <thread>
+#include <utility>
+#include <vector>
 
 #include "CLI/CLI.hpp"
+#include "parallel/Affinity.hpp"
+#include "simd/Dispatch.hpp"
 
 namespace Hylord::CMD {
+namespace {
+/**
+ * Copies the first reference matrix and cell type list to the fields used by
+ * single panel runs. Several panels only support plain deconvolution, so the
+ * options for other modes are rejected alongside them.
+ */
+void checkReferencePanels(HylordConfig& config) {
+   if (!config.reference_matrix_files.empty()) {
+      config.reference_matrix_file = config.reference_matrix_files.front();
+   }
+   if (!config.cell_type_list_files.empty()) {
+      config.cell_type_list_file = config.cell_type_list_files.front();
+   }
+   // A single cell type list can also name novel cell types, without a
+   // reference matrix
+   const std::size_t panels{
+       std::max<std::size_t>(config.reference_matrix_files.size(), 1)};
+   if (!config.cell_type_list_files.empty() &&
+       config.cell_type_list_files.size() != panels) {
+      throw CLI::ValidationError(
+          "--cell-type-list",
+          "Give one cell type list per reference matrix.");
+   }
+   if (panels < 2) return;
+
+   const std::vector<std::pair<bool, std::string>> unsupported{
+       {config.additional_cell_types > 0, "--additional-cell-types"},
+       {!config.selected_cell_types.empty(), "--cell-types"},
+       {!config.shared_reference_name.empty(), "--shared-reference"},
+       {!config.reference_out_file.empty(), "--write-reference"},
+       {!config.residuals_out_file.empty(), "--write-residuals"},
+       {!config.bulk_matrix_file.empty(), "--bulk-matrix"},
+       {config.bin_size > 0 || !config.bin_regions_file.empty(),
+        "--bin-size/--bin-regions"},
+       {!config.sweep_min_read_depths.empty() ||
+            !config.sweep_max_read_depths.empty() ||
+            !config.sweep_signals.empty(),
+        "--sweep-*"}};
+   for (const auto& [given, option] : unsupported) {
+      if (given) {
+         throw CLI::ValidationError(
+             "--reference-matrix",
+             option + " can't be used with several reference matrices.");
+      }
+   }
+}
+
+/**
+ * Sets up the `index` subcommand, which writes a sidecar offset index for a
+ * sorted BED file (bedmethyl, reference matrix or CpG list).
+ */
+void setupIndexCommand(CLI::App& app, HylordConfig& config) {
+   CLI::App* index_command{app.add_subcommand(
+       "index",
+       "Write a sidecar offset index (<file>.hli) for a BED file. Later runs "
+       "use it to split the file into chunks and to only read the parts of "
+       "it that overlap the CpG list. The index is ignored once the file is "
+       "modified.")};
+   index_command->callback([&config]() { config.command = Command::index; });
+
+   index_command
+       ->add_option("file",
+                    config.index_file,
+                    "The BED file to index (bedmethyl file, reference matrix "
+                    "or CpG list).")
+       ->required()
+       ->check(CLI::ExistingFile);
+
+   index_command
+       ->add_option("--stride",
+                    config.index_stride,
+                    "Number of rows between index entries (the first row of "
+                    "every chromosome is always indexed).")
+       ->capture_default_str()
+       ->check(CLI::Range(std::size_t{1},
+                          std::numeric_limits<std::size_t>::max()));
+}
+
+/**
+ * Sets up the `assign-reads` subcommand, which assigns individual reads to
+ * the cell types of a reference matrix using modkit's per-read calls.
+ */
+void setupAssignReadsCommand(CLI::App& app, HylordConfig& config) {
+   CLI::App* assign_command{app.add_subcommand(
+       "assign-reads",
+       "Assign each read to its most likely cell type using the per-read "
+       "modification calls from `modkit extract calls`. Calls of a read must "
+       "be contiguous in the table (as written by modkit).")};
+   assign_command->callback(
+       [&config]() { config.command = Command::assign_reads; });
+
+   assign_command
+       ->add_option("read_calls_file",
+                    config.read_calls_file,
+                    "Per-read calls table from `modkit extract calls`.")
+       ->required()
+       ->check(CLI::ExistingFile);
+
+   assign_command
+       ->add_option("-r,--reference-matrix",
+                    config.reference_matrix_file,
+                    "Bed4+x file containing a matrix of reference "
+                    "methylation signals (see main command).")
+       ->required()
+       ->check(CLI::ExistingFile);
+
+   assign_command
+       ->add_option("-l,--cell-type-list",
+                    config.cell_type_list_file,
+                    "List of cell types (newline separated) corresponding "
+                    "with each column of the reference matrix.")
+       ->check(CLI::ExistingFile);
+
+   assign_command
+       ->add_option("-a,--assignments",
+                    config.read_assignments_file,
+                    "A file path to write the assignment of each read to "
+                    "(read_id, cell type, posterior and number of calls).")
+       ->required();
+
+   assign_command->add_option(
+       "-o,--outpath",
+       config.out_file_path,
+       "A file path to write the number of reads assigned to each cell type "
+       "to. By default, this is written to the standard output stream.");
+
+   assign_command
+       ->add_option("-t,--threads",
+                    config.num_threads,
+                    "Number of threads to use when reading and scoring.")
+       ->capture_default_str()
+       ->check(CLI::Range(0, Parallel::availableCores()));
+
+   assign_command
+       ->add_option("--min-calls",
+                    config.min_calls_per_read,
+                    "Reads with fewer calls at reference CpG sites are left "
+                    "unassigned.")
+       ->capture_default_str()
+       ->check(CLI::Range(1, std::numeric_limits<int>::max()));
+
+   assign_command
+       ->add_option("--batch-size",
+                    config.batch_size_mb,
+                    "Approximate amount of the calls table (in MB) processed "
+                    "at once. Bounds memory usage for large tables.")
+       ->capture_default_str()
+       ->check(CLI::Range(std::size_t{1}, std::size_t{1} << 20U));
+}
+
+/**
+ * Sets up the `batch` subcommand, which deconvolves every sample of a
+ * manifest against one reference matrix, keeping a journal of the finished
+ * samples so that an interrupted run can be resumed.
+ */
+void setupBatchCommand(CLI::App& app, HylordConfig& config) {
+   CLI::App* batch_command{app.add_subcommand(
+       "batch",
+       "Deconvolve every sample of a manifest (a line per sample: name and "
+       "bedmethyl file, tab separated) against a reference matrix, which is "
+       "read once. The proportions of each sample are written to "
+       "<out-dir>/<sample>.tsv. Finished samples are recorded in a journal, "
+       "and skipped when the run is restarted (unless their inputs or "
+       "outputs have changed since).")};
+   batch_command->callback([&config]() { config.command = Command::batch; });
+
+   batch_command
+       ->add_option("manifest",
+                    config.batch_manifest_file,
+                    "Manifest of the samples to deconvolve. Relative paths "
+                    "are taken from the directory of the manifest.")
+       ->required()
+       ->check(CLI::ExistingFile);
+
+   batch_command
+       ->add_option("-r,--reference-matrix",
+                    config.reference_matrix_file,
+                    "Bed4+x file containing a matrix of reference "
+                    "methylation signals (see main command).")
+       ->required()
+       ->check(CLI::ExistingFile);
+
+   batch_command
+       ->add_option("-l,--cell-type-list",
+                    config.cell_type_list_file,
+                    "List of cell types (newline separated) corresponding "
+                    "with each column of the reference matrix.")
+       ->check(CLI::ExistingFile);
+
+   batch_command
+       ->add_option("-c,--cpg-list",
+                    config.cpg_list_file,
+                    "List of CpG sites (BED4 format) to use with "
+                    "deconvolution algorithm (see main command).")
+       ->check(CLI::ExistingFile);
+
+   batch_command
+       ->add_option("-d,--out-dir",
+                    config.batch_out_directory,
+                    "Directory to write the proportions of each sample to.")
+       ->required();
+
+   batch_command->add_option(
+       "--journal",
+       config.batch_journal_file,
+       "Journal of finished samples. Give the same journal to resume an "
+       "interrupted run. Defaults to <out-dir>/hylord_journal.tsv.");
+
+   batch_command
+       ->add_option("-t,--threads",
+                    config.num_threads,
+                    "Number of threads to use when reading files.")
+       ->capture_default_str()
+       ->check(CLI::Range(0, Parallel::availableCores()));
+
+   batch_command
+       ->add_option("--min-read-depth",
+                    config.min_read_depth,
+                    "Minimum read depth of the CpG sites of each sample "
+                    "(see main command).")
+       ->capture_default_str()
+       ->check(CLI::Range(0, std::numeric_limits<int>::max()));
+
+   batch_command
+       ->add_option("--max-read-depth",
+                    config.max_read_depth,
+                    "Maximum read depth of the CpG sites of each sample (see "
+                    "main command). Not set by default.")
+       ->check(CLI::Range(0, std::numeric_limits<int>::max()));
+
+   batch_command->add_flag("--only-methylation-signal",
+                           config.use_only_methylation_signal,
+                           "Only use methylation signals (see main command).");
+
+   batch_command->add_flag(
+       "--only-hydroxy-signal",
+       config.use_only_hydroxy_signal,
+       "Only use hydroxymethylation signals (see main command).");
+}
+
+/**
+ * Sets up the `fit-cdf` subcommand, which fits the CDFs that novel cell type
+ * profiles are drawn from to the methylation of bedmethyl files.
+ */
+void setupFitCdfCommand(CLI::App& app, HylordConfig& config) {
+   CLI::App* fit_cdf_command{app.add_subcommand(
+       "fit-cdf",
+       "Fit the distributions (CDFs) that the profiles of novel cell types "
+       "are drawn from to the methylation of your own samples. The "
+       "bedmethyl files are streamed, so can be larger than memory. Give "
+       "the result to --cdf in place of the built in CDFs.")};
+   fit_cdf_command->callback(
+       [&config]() { config.command = Command::fit_cdf; });
+
+   fit_cdf_command
+       ->add_option("bedmethyl_files",
+                    config.cdf_bedmethyl_files,
+                    "bedMethyl files from modkit (BED9+9). Rows of every "
+                    "file are pooled.")
+       ->required()
+       ->check(CLI::ExistingFile);
+
+   fit_cdf_command->add_option(
+       "-o,--outpath",
+       config.out_file_path,
+       "A file path to write the CDFs to. By default, these are written to "
+       "the standard output stream.");
+
+   fit_cdf_command
+       ->add_option("--bins",
+                    config.cdf_bins,
+                    "Number of (evenly sized) methylation bins of each CDF. "
+                    "The built in CDFs use 10.")
+       ->capture_default_str()
+       ->check(CLI::Range(1, 100));
+
+   fit_cdf_command
+       ->add_option("-t,--threads",
+                    config.num_threads,
+                    "Number of threads to use when reading.")
+       ->capture_default_str()
+       ->check(CLI::Range(0, Parallel::availableCores()));
+
+   fit_cdf_command
+       ->add_option("--min-read-depth",
+                    config.min_read_depth,
+                    "Minimum read depth of the CpG sites counted.")
+       ->capture_default_str()
+       ->check(CLI::Range(0, std::numeric_limits<int>::max()));
+
+   fit_cdf_command
+       ->add_option("--max-read-depth",
+                    config.max_read_depth,
+                    "Maximum read depth of the CpG sites counted. Not set by "
+                    "default.")
+       ->check(CLI::Range(0, std::numeric_limits<int>::max()));
+
+   fit_cdf_command
+       ->add_option("--batch-size",
+                    config.batch_size_mb,
+                    "Approximate amount of each file (in MB) processed at "
+                    "once. Bounds memory usage for large files.")
+       ->capture_default_str()
+       ->check(CLI::Range(std::size_t{1}, std::size_t{1} << 20U));
+}
+}  // namespace
+
 /**
  * Sets up CLI11 command-line interface with all configuration options for
  * Hylord. Organizes parameters into logical groups (file paths, row filters,
  * hyperparameters). Includes validation checks and default values for all
- * optional parameters. Marks bedmethyl file path as required input.
+ * optional parameters. Marks bedmethyl file path as required input (unless a
+ * subcommand is used).
  */
 void setupCLI(CLI::App& app, HylordConfig& config) {
    std::stringstream hylord_description;
@@ -35,6 +348,8 @@ void setupCLI(CLI::App& app, HylordConfig& config) {
       std::cout << "HyLoRD " << GIT_TAG << '\n';
       std::cout << "Commit hash: " << GIT_HASH << '\n';
       std::cout << "Build type: " << BUILD_TYPE << '\n';
+      std::cout << "SIMD kernels: " << Simd::isaName(Simd::selectedIsa())
+                << '\n';
       std::exit(0);
    }};
    app.add_flag("--version", print_version, "Print HyLoRD version");
@@ -43,8 +358,14 @@ void setupCLI(CLI::App& app, HylordConfig& config) {
                   config.num_threads,
                   "Number of threads to use when reading files.")
        ->capture_default_str()
-       ->check(CLI::Range(
-           0, static_cast<int>(std::thread::hardware_concurrency())));
+       ->check(CLI::Range(0, Parallel::availableCores()));
+
+   app.add_flag("--pin-threads",
+                config.pin_threads,
+                "Set this flag to pin each worker thread to its own CPU (of "
+                "those HyLoRD may use). Keeps threads, and the memory they "
+                "first write to, on the same NUMA node on multi-socket "
+                "machines.");
 
    app.add_option("--additional-cell-types",
                   config.additional_cell_types,
@@ -85,6 +406,27 @@ void setupCLI(CLI::App& app, HylordConfig& config) {
                 "vastly different hydroxymethylation profiles, like brain).")
        ->group("Row filters");
 
+   auto* bin_size_option{app.add_option(
+       "--bin-size",
+       config.bin_size,
+       "Pools the CpG sites shared by the bedmethyl file and reference "
+       "matrix into bins of this many bases before deconvolution (one row "
+       "per bin and signal). Bulk values are weighted by read depth and "
+       "reference values averaged. Useful for low coverage samples, "
+       "alongside a lower --min-read-depth. Not set by default.")};
+   bin_size_option->group("Binning")->check(
+       CLI::Range(1, std::numeric_limits<int>::max()));
+
+   auto* bin_regions_option{app.add_option(
+       "--bin-regions",
+       config.bin_regions_file,
+       "BED3+ file of (non-overlapping) regions, e.g. CpG islands, to pool "
+       "CpG sites into instead of fixed size bins (see --bin-size). CpG "
+       "sites outside of every region are dropped.")};
+   bin_regions_option->group("Binning")
+       ->check(CLI::ExistingFile)
+       ->excludes(bin_size_option);
+
    app.add_option("--max-iterations",
                   config.max_iterations,
                   "The maximum number of iterations of main deconvolution "
@@ -103,6 +445,25 @@ void setupCLI(CLI::App& app, HylordConfig& config) {
        ->group("Deconvolution hyperparameters")
        ->check(CLI::Range(0.0, std::numeric_limits<double>::max()));
 
+   app.add_option("--scratch-dir",
+                  config.scratch_directory,
+                  "Directory to hold the reference matrix (and bulk profile) "
+                  "in a temporary memory mapped file during the "
+                  "deconvolution loop, so that they don't need to fit in "
+                  "memory. Useful for whole genome runs with many cell "
+                  "types. Note: Does nothing if additional-cell-types is not "
+                  "set.")
+       ->group("File paths")
+       ->check(CLI::ExistingDirectory);
+
+   app.add_option("--cdf",
+                  config.cdf_file,
+                  "CDFs written by the fit-cdf subcommand, used in place of "
+                  "the built in ones when drawing the starting profiles of "
+                  "additional cell types.")
+       ->group("File paths")
+       ->check(CLI::ExistingFile);
+
    app.add_option("-c,--cpg-list",
                   config.cpg_list_file,
                   "List of CpG sites (BED4 format) to use with "
@@ -111,21 +472,48 @@ void setupCLI(CLI::App& app, HylordConfig& config) {
        ->group("File paths")
        ->check(CLI::ExistingFile);
 
-   app.add_option("-r,--reference-matrix",
-                  config.reference_matrix_file,
-                  "Bed4+x file containing a matrix of reference methylation "
-                  "signals where x is the number of cell "
-                  "types.\ne.g. chr start end name cell_one cell_two...")
-       ->group("File paths")
-       ->check(CLI::ExistingFile);
+   auto* reference_matrix_option{app.add_option(
+       "-r,--reference-matrix",
+       config.reference_matrix_files,
+       "Bed4+x file containing a matrix of reference methylation "
+       "signals where x is the number of cell "
+       "types.\ne.g. chr start end name cell_one cell_two...\nGive more "
+       "than once to deconvolve against several reference panels, parsing "
+       "the bedmethyl file once. A block of proportions is written per "
+       "panel.")};
+   reference_matrix_option->group("File paths")->check(CLI::ExistingFile);
 
-   app.add_option("-l,--cell-type-list",
-                  config.cell_type_list_file,
-                  "If a reference matrix is given, one can provide a list of "
-                  "cell types (newline separated) corresponding with each "
-                  "column of the reference matrix (starting from 5th field).")
+   app.add_option("--shared-reference",
+                  config.shared_reference_name,
+                  "Name of a shared memory segment to share the parsed "
+                  "reference matrix through, for many runs on one node "
+                  "using the same reference. The first run parses the "
+                  "reference matrix and publishes it, later runs (with the "
+                  "same reference matrix, cell types, CpG list and signal) "
+                  "use it in place instead of parsing their own copy. "
+                  "Segments persist until removed from /dev/shm.")
        ->group("File paths")
-       ->check(CLI::ExistingFile);
+       ->needs(reference_matrix_option);
+
+   auto* cell_type_list_option{app.add_option(
+       "-l,--cell-type-list",
+       config.cell_type_list_files,
+       "If a reference matrix is given, one can provide a list of "
+       "cell types (newline separated) corresponding with each "
+       "column of the reference matrix (starting from 5th field). With "
+       "several reference matrices, give one list per reference matrix (in "
+       "the same order).")};
+   cell_type_list_option->group("File paths")->check(CLI::ExistingFile);
+
+   app.add_option("--cell-types",
+                  config.selected_cell_types,
+                  "Comma separated names of the cell types (from the cell "
+                  "type list) to deconvolve against. The other columns of "
+                  "the reference matrix are not loaded. Defaults to all cell "
+                  "types.")
+       ->delimiter(',')
+       ->needs(reference_matrix_option)
+       ->needs(cell_type_list_option);
 
    app.add_option("-o,--outpath",
                   config.out_file_path,
@@ -134,12 +522,148 @@ void setupCLI(CLI::App& app, HylordConfig& config) {
                   "is written to the standard output stream.")
        ->group("File paths");
 
-   app.add_option("bedmethyl_file_path",
-                  config.bedmethyl_file,
-                  "The bedMethyl file for your long read dataset obtained "
-                  "from modkit (BED9+9).")
-       ->required()
-       ->check(CLI::ExistingFile);
+   app.add_option("--write-reference",
+                  config.reference_out_file,
+                  "A file path to write the final reference matrix to (BED4+X "
+                  "with methylation percentages, including the profiles of "
+                  "any additional cell types). This can be given to "
+                  "--reference-matrix when deconvolving similar samples, "
+                  "skipping the deconvolution loop.")
+       ->group("File paths");
+
+   app.add_option("--write-residuals",
+                  config.residuals_out_file,
+                  "A file path to write the bulk signal, fitted value and "
+                  "residual (bulk - fitted) of every CpG used in "
+                  "deconvolution to (BED4+3 with percentages). Useful for "
+                  "quality control.")
+       ->group("File paths");
+
+   for (auto* bin_option : {bin_size_option, bin_regions_option}) {
+      bin_option->needs(reference_matrix_option)
+          ->excludes(app.get_option("--scratch-dir"))
+          ->excludes(app.get_option("--write-reference"))
+          ->excludes(app.get_option("--write-residuals"));
+   }
+
+   const std::vector<CLI::Option*> sweep_options{
+       app.add_option("--sweep-min-read-depth",
+                      config.sweep_min_read_depths,
+                      "Comma separated minimum read depths (see "
+                      "--min-read-depth) to deconvolve with. If any --sweep-* "
+                      "option is given, the inputs are read once and "
+                      "deconvolved with every combination of the swept "
+                      "filters (the others keep their set value). A table "
+                      "with a row per combination is written instead of the "
+                      "usual output.")
+           ->check(CLI::Range(0, std::numeric_limits<int>::max())),
+       app.add_option("--sweep-max-read-depth",
+                      config.sweep_max_read_depths,
+                      "Comma separated maximum read depths (see "
+                      "--max-read-depth) to deconvolve with.")
+           ->check(CLI::Range(0, std::numeric_limits<int>::max())),
+       app.add_option("--sweep-signal",
+                      config.sweep_signals,
+                      "Comma separated signals to deconvolve with: m "
+                      "(methylation only), h (hydroxymethylation only) or "
+                      "both.")
+           ->check(CLI::IsMember({"m", "h", "both"}))};
+   for (auto* sweep_option : sweep_options) {
+      sweep_option->group("Sweep")
+          ->delimiter(',')
+          ->needs(reference_matrix_option)
+          ->excludes(app.get_option("--additional-cell-types"))
+          ->excludes(app.get_option("--write-reference"))
+          ->excludes(app.get_option("--write-residuals"))
+          ->excludes(bin_size_option)
+          ->excludes(bin_regions_option);
+   }
+
+   auto* bulk_matrix_option{app.add_option(
+       "--bulk-matrix",
+       config.bulk_matrix_file,
+       "Bed4+x file containing a methylation percentage per sample (in the "
+       "format of the reference matrix), given instead of a bedmethyl "
+       "file. The file is read and joined with the reference matrix once, "
+       "every sample is deconvolved against it and a table with a row per "
+       "sample is written instead of the usual output. The row filters "
+       "(other than the signal) do not apply.")};
+   bulk_matrix_option->group("File paths")
+       ->check(CLI::ExistingFile)
+       ->needs(reference_matrix_option)
+       ->excludes(app.get_option("--additional-cell-types"))
+       ->excludes(app.get_option("--write-reference"))
+       ->excludes(app.get_option("--write-residuals"))
+       ->excludes(bin_size_option)
+       ->excludes(bin_regions_option);
+   for (auto* sweep_option : sweep_options) {
+      bulk_matrix_option->excludes(sweep_option);
+   }
+
+   app.add_option("--sample-list",
+                  config.sample_list_file,
+                  "A list of sample names (newline separated) corresponding "
+                  "with each sample column of the bulk matrix (starting from "
+                  "5th field).")
+       ->group("File paths")
+       ->check(CLI::ExistingFile)
+       ->needs(bulk_matrix_option);
+
+   auto* bedmethyl_option{app.add_option(
+       "bedmethyl_file_path",
+       config.bedmethyl_file,
+       "The bedMethyl file for your long read dataset obtained from modkit "
+       "(BED9+9).")};
+   bedmethyl_option->check(CLI::ExistingFile)->excludes(bulk_matrix_option);
+
+   const std::vector<CLI::Option*> bedgraph_options{
+       app.add_option("--methylation-bedgraph",
+                      config.methylation_bedgraph_file,
+                      "bedGraph file of the methylation (5mC) signal from "
+                      "`modkit pileup --bedgraph`, given instead of a "
+                      "bedmethyl file. These are much smaller, so quicker "
+                      "to read. Give --hydroxy-bedgraph as well to use both "
+                      "signals."),
+       app.add_option("--hydroxy-bedgraph",
+                      config.hydroxy_bedgraph_file,
+                      "bedGraph file of the hydroxymethylation (5hmC) signal "
+                      "from `modkit pileup --bedgraph`, given instead of a "
+                      "bedmethyl file.")};
+   for (auto* bedgraph_option : bedgraph_options) {
+      bedgraph_option->group("File paths")
+          ->check(CLI::ExistingFile)
+          ->excludes(bedmethyl_option)
+          ->excludes(bulk_matrix_option);
+   }
+
+   app.add_option("--qc-report",
+                  config.qc_report_file,
+                  "A file path to write depth and methylation histograms "
+                  "(per mark) of the bedmethyl or bedGraph rows to. These "
+                  "are gathered whilst the file is parsed and count every "
+                  "row, including those the read depth filters drop, so "
+                  "can be used to pick --min-read-depth and "
+                  "--max-read-depth.")
+       ->group("File paths")
+       ->excludes(bulk_matrix_option);
+
+   setupIndexCommand(app, config);
+   setupAssignReadsCommand(app, config);
+   setupBatchCommand(app, config);
+   setupFitCdfCommand(app, config);
+
+   // The bedmethyl file can't be marked as required directly, as it isn't
+   // needed by subcommands or when a bulk matrix or bedGraph files are
+   // given.
+   app.callback([&app, &config]() {
+      if (app.get_subcommands().empty() && config.bedmethyl_file.empty() &&
+          config.bulk_matrix_file.empty() &&
+          config.methylation_bedgraph_file.empty() &&
+          config.hydroxy_bedgraph_file.empty()) {
+         throw CLI::RequiredError("bedmethyl_file_path");
+      }
+      checkReferencePanels(config);
+   });
 }
 
 }  // namespace Hylord::CMD
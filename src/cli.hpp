@@ -8,27 +8,81 @@
  * file in the repository root or https://mit-license.org)
  */
 
+#include <cstddef>
 #include <limits>
+#include <string>
+#include <vector>
 
 #include "CLI/App.hpp"
 
 /// CLI handling for HyLoRD
 namespace Hylord::CMD {
+/// What HyLoRD has been asked to do (deconvolution unless a subcommand is
+/// given)
+enum class Command { deconvolve, index, assign_reads, batch, fit_cdf };
+
 /// Container for HyLoRD CLI options
 struct HylordConfig {
+   Command command{Command::deconvolve};
    int num_threads{0};
+   bool pin_threads{false};
    std::string cpg_list_file;
    std::string reference_matrix_file;
+   std::string shared_reference_name;
    std::string cell_type_list_file;
+   // Every --reference-matrix and --cell-type-list given. The first of each
+   // is copied to the fields above, further ones are extra panels that the
+   // bedmethyl file is also deconvolved against.
+   std::vector<std::string> reference_matrix_files;
+   std::vector<std::string> cell_type_list_files;
+   std::vector<std::string> selected_cell_types;
    int additional_cell_types{0};
    std::string out_file_path;
+   std::string reference_out_file;
+   std::string residuals_out_file;
+   std::string qc_report_file;
    int max_iterations{5};
    double convergence_threshold{1e-8};
+   std::string scratch_directory;
+   // CDFs of novel cell type profiles (see the fit-cdf subcommand)
+   std::string cdf_file;
    std::string bedmethyl_file;
+   // Per mark bedGraph files from modkit (replace the bedmethyl file)
+   std::string methylation_bedgraph_file;
+   std::string hydroxy_bedgraph_file;
+   // Bulk matrix mode (replaces the bedmethyl file)
+   std::string bulk_matrix_file;
+   std::string sample_list_file;
    int min_read_depth{10};
    int max_read_depth{std::numeric_limits<int>::max()};
    bool use_only_methylation_signal{false};
    bool use_only_hydroxy_signal{false};
+   // Binning (see Binning::isRequested)
+   int bin_size{0};
+   std::string bin_regions_file;
+   // Sweep mode (see Sweep::isRequested)
+   std::vector<int> sweep_min_read_depths;
+   std::vector<int> sweep_max_read_depths;
+   std::vector<std::string> sweep_signals;
+
+   // index subcommand
+   std::string index_file;
+   std::size_t index_stride{4096};
+
+   // assign-reads subcommand
+   std::string read_calls_file;
+   std::string read_assignments_file;
+   int min_calls_per_read{5};
+   std::size_t batch_size_mb{256};
+
+   // batch subcommand
+   std::string batch_manifest_file;
+   std::string batch_out_directory;
+   std::string batch_journal_file;
+
+   // fit-cdf subcommand
+   std::vector<std::string> cdf_bedmethyl_files;
+   int cdf_bins{10};
 };
 
 /**
@@ -8,6 +8,9 @@
  * file in the repository root or https://mit-license.org)
  */
 
+#include <concepts>
+#include <type_traits>
+
 #include "types.hpp"
 
 /// Holds concept and template for working with TSVRecords
@@ -52,6 +55,35 @@ concept TSVRecord = requires(const Fields& fields) {
    requires !std::is_member_function_pointer_v<decltype(&T::fromFields)>;
 };
 
+template <typename T>
+/**
+ * @concept GenomicRecord
+ * @brief Records that can be placed on the genome via a packed key.
+ *
+ * Used by TSVFileReader to check whether a file is sorted whilst parsing it
+ * and by the join stage to pick an appropriate algorithm.
+ *
+ * @see BedRecords::packKey
+ */
+concept GenomicRecord = requires(const T& record) {
+   { record.key() } -> std::same_as<GenomicKey>;
+};
+
+template <typename T>
+/**
+ * @concept MethylationRecord
+ * @brief Records holding the mark, read depth and methylation proportion of
+ * a CpG.
+ *
+ * TSVFileReader can gather histograms of these whilst parsing (see
+ * IO::ParseStatistics).
+ */
+concept MethylationRecord = requires(const T& record) {
+   { record.name } -> std::convertible_to<char>;
+   { record.read_depth } -> std::convertible_to<int>;
+   { record.methylation_proportion } -> std::convertible_to<double>;
+};
+
 template <TSVRecord T>
 using Collection = std::vector<T>;
 }  // namespace Hylord::Records
@@ -0,0 +1,90 @@
+/**
+ * @file    BatchSolver.cpp
+ * @brief   Defines deconvolution of many bulk profiles against the same
+ * reference matrix.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "core/BatchSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "Eigen/Cholesky"
+#include "HylordException.hpp"
+#include "maths/LinearAlgebra.hpp"
+#include "parallel/ParallelFor.hpp"
+#include "qpmad/solver.h"
+#include "types.hpp"
+
+namespace Hylord::Deconvolution {
+/**
+ * Objectives are found from the QPP terms, as
+ * ||b - Rx||^2 = b^T b + 2 g^T x + x^T R^T R x (g being the linear terms),
+ * instead of another pass over the reference matrix per profile.
+ */
+auto solveBatch(const Eigen::Ref<const Matrix>& reference_matrix,
+                const Eigen::Ref<const Matrix>& bulk_profiles,
+                int threads) -> BatchResult {
+   const LinearAlgebra::BatchQuadraticTerms terms{
+       LinearAlgebra::batchQuadraticTerms(
+           reference_matrix, bulk_profiles, threads)};
+   const Eigen::LLT<Matrix> cholesky{terms.hessian};
+   if (cholesky.info() != Eigen::Success) {
+      throw DeconvolutionException(
+          "Batch Hessian Factorisation",
+          "Hessian of the reference matrix is not positive definite.");
+   }
+   const Matrix cholesky_factor{cholesky.matrixL()};
+   Matrix gram_matrix{terms.hessian};
+   gram_matrix.diagonal().array() -= LinearAlgebra::gram_regularisation;
+
+   const Eigen::Index num_cell_types{reference_matrix.cols()};
+   const Eigen::Index num_profiles{bulk_profiles.cols()};
+   BatchResult result{.cell_proportions = Matrix(num_cell_types, num_profiles),
+                      .objectives = Vector(num_profiles)};
+   const Vector lower_bound{Vector::Zero(num_cell_types)};
+   const Vector upper_bound{Vector::Ones(num_cell_types)};
+   const Matrix inequality_matrix{
+       Vector::Ones(num_cell_types).transpose()};
+   const Vector sum_bound{Vector::Ones(1)};
+   qpmad::SolverParameters parameters{};
+   parameters.hessian_type_ = qpmad::SolverParameters::HESSIAN_CHOLESKY_FACTOR;
+
+   Parallel::forEachBlock(
+       static_cast<std::size_t>(num_profiles),
+       threads,
+       [&](const Parallel::Block& block) {
+          qpmad::Solver qpp_solver;
+          Matrix factor(num_cell_types, num_cell_types);
+          Vector linear_terms(num_cell_types);
+          Vector cell_proportions(num_cell_types);
+          for (auto profile{static_cast<Eigen::Index>(block.begin)};
+               profile < static_cast<Eigen::Index>(block.end);
+               ++profile) {
+             // qpmad takes the Hessian by reference, so it gets a copy
+             factor = cholesky_factor;
+             linear_terms = terms.linear_terms.col(profile);
+             qpp_solver.solve(cell_proportions,
+                              factor,
+                              linear_terms,
+                              lower_bound,
+                              upper_bound,
+                              inequality_matrix,
+                              sum_bound,
+                              sum_bound,
+                              parameters);
+             result.cell_proportions.col(profile) = cell_proportions;
+             const double squared_objective{
+                 bulk_profiles.col(profile).squaredNorm() +
+                 2 * linear_terms.dot(cell_proportions) +
+                 cell_proportions.dot(gram_matrix * cell_proportions)};
+             result.objectives(profile) =
+                 std::sqrt(std::max(squared_objective, 0.0));
+          }
+       });
+   return result;
+}
+}  // namespace Hylord::Deconvolution
@@ -0,0 +1,41 @@
+#ifndef BATCH_SOLVER_H_
+#define BATCH_SOLVER_H_
+
+/**
+ * @file    BatchSolver.hpp
+ * @brief   Declares deconvolution of many bulk profiles against the same
+ * reference matrix.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "types.hpp"
+
+namespace Hylord::Deconvolution {
+/// Solutions of solveBatch(), with a column (or entry) per bulk profile.
+struct BatchResult {
+   Matrix cell_proportions;
+   /// ||bulk - reference * proportions|| of each bulk profile.
+   Vector objectives;
+};
+
+/**
+ * Solves the QPP (see Deconvolver) of each bulk profile (columns of
+ * `bulk_profiles`, rows following `reference_matrix`).
+ *
+ * The Hessian only depends on the reference matrix, so it is computed and
+ * factorised once (see LinearAlgebra::batchQuadraticTerms), and the linear
+ * terms of every profile are formed by a single matrix product. Each QPP is
+ * then given the shared Cholesky factor, so solving one only costs the
+ * active set iterations. Blocks of profiles are solved concurrently, each
+ * reusing one solver.
+ *
+ * @throws DeconvolutionException if the rows don't match or the Hessian
+ * isn't positive definite
+ */
+auto solveBatch(const Eigen::Ref<const Matrix>& reference_matrix,
+                const Eigen::Ref<const Matrix>& bulk_profiles,
+                int threads) -> BatchResult;
+}  // namespace Hylord::Deconvolution
+
+#endif
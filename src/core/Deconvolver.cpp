@@ -20,14 +20,16 @@ namespace Hylord::Deconvolution {
  */
 auto Deconvolver::runQpmad(const Matrix& reference_matrix)
     -> qpmad::Solver::ReturnStatus {
-   Matrix hessian{LinearAlgebra::gramMatrix(reference_matrix)};
-   Vector linear_terms{LinearAlgebra::generateCoefficientVector(
-       reference_matrix, m_bulk_profile)};
+   return runQpmad(
+       LinearAlgebra::quadraticTerms(reference_matrix, m_bulk_profile));
+}
 
+auto Deconvolver::runQpmad(LinearAlgebra::QuadraticTerms terms)
+    -> qpmad::Solver::ReturnStatus {
    qpmad::Solver qpp_solver;
    return qpp_solver.solve(m_cell_proportions,
-                           hessian,
-                           linear_terms,
+                           terms.hessian,
+                           terms.linear_terms,
                            m_proportions_lower_bound,
                            m_proportions_upper_bound,
                            m_inequality_matrix,
@@ -35,10 +37,10 @@ auto Deconvolver::runQpmad(const Matrix& reference_matrix)
                            m_sum_upper_bound);
 }
 
+/// Evaluates ||h - R x|| without forming the residual vector.
 auto Deconvolver::evaluateObjectiveFunctionL2Norm(const Matrix& reference)
     -> double {
-   Vector objective_function{m_bulk_profile.transpose() -
-                             (reference * m_cell_proportions)};
-   return objective_function.norm();
+   return LinearAlgebra::residualNorm(
+       reference, m_cell_proportions, m_bulk_profile);
 }
 }  // namespace Hylord::Deconvolution
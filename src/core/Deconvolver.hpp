@@ -10,6 +10,7 @@
 
 #include <utility>
 
+#include "maths/LinearAlgebra.hpp"
 #include "qpmad/solver.h"
 #include "types.hpp"
 
@@ -30,9 +31,21 @@ class Deconvolver {
        m_bulk_profile{std::move(bulk_profile)} {
       initialise();
    }
+   /// For callers that compute the QPP terms themselves (see
+   /// runQpmad(LinearAlgebra::QuadraticTerms)), so that the bulk profile
+   /// isn't copied.
+   explicit Deconvolver(int num_cell_types) :
+       m_num_cell_types(num_cell_types) {
+      initialise();
+   }
 
    /// Performs quadratic programming deconvolution using qpmad solver.
    auto runQpmad(const Matrix& reference) -> qpmad::Solver::ReturnStatus;
+   /// Performs the deconvolution with precomputed QPP terms (see
+   /// LinearAlgebra::updateReferenceMatrix). qpmad factorises the Hessian in
+   /// place, so the terms are taken by value.
+   auto runQpmad(LinearAlgebra::QuadraticTerms terms)
+       -> qpmad::Solver::ReturnStatus;
    [[nodiscard]] auto cellProportions() const -> Vector {
       return m_cell_proportions;
    }
@@ -0,0 +1,213 @@
+/**
+ * @file    ReadAssigner.cpp
+ * @brief   Defines assignment of individual reads to cell types using their
+ * modification calls.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "core/ReadAssigner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "data/BedData.hpp"
+#include "data/BedRecords.hpp"
+#include "parallel/ParallelFor.hpp"
+#include "types.hpp"
+
+namespace Hylord::ReadAssignment {
+namespace {
+constexpr char no_name{'\0'};
+
+auto siteKey(int chromosome, int start) -> GenomicKey {
+   return BedRecords::packKey(chromosome, start, no_name);
+}
+
+auto clampedLog(double probability) -> double {
+   return std::log(std::clamp(probability,
+                              ReadAssigner::min_probability,
+                              1.0 - ReadAssigner::min_probability));
+}
+}  // namespace
+
+/**
+ * Sites are the distinct (chromosome, start) pairs of the reference. Sites
+ * without an 'm' row are dropped, as canonical calls can't be scored there.
+ */
+ReadAssigner::ReadAssigner(const BedData::ReferenceMatrixData& reference,
+                           int min_calls) :
+    m_num_cell_types{static_cast<std::size_t>(reference.numberOfCellTypes())},
+    m_min_calls{min_calls} {
+   const auto& records{reference.records()};
+   const Matrix& proportions{reference.getAsEigenMatrix()};
+
+   for (const auto& record : records) {
+      if (record.name == 'm') {
+         m_site_keys.push_back(siteKey(record.chromosome, record.start));
+      }
+   }
+   std::ranges::sort(m_site_keys);
+   const auto [first_duplicate, last] = std::ranges::unique(m_site_keys);
+   m_site_keys.erase(first_duplicate, last);
+
+   const std::size_t table_size{m_site_keys.size() * m_num_cell_types};
+   Matrix methylated{Matrix::Zero(static_cast<Eigen::Index>(m_num_cell_types),
+                                  std::ssize(m_site_keys))};
+   Matrix hydroxymethylated{methylated};
+   std::vector<bool> has_hydroxy(m_site_keys.size(), false);
+   for (std::size_t row{}; row < records.size(); ++row) {
+      const auto& record{records[row]};
+      const auto site{std::ranges::lower_bound(
+          m_site_keys, siteKey(record.chromosome, record.start))};
+      if (site == m_site_keys.end() ||
+          *site != siteKey(record.chromosome, record.start)) {
+         continue;
+      }
+      const auto site_index{std::distance(m_site_keys.begin(), site)};
+      if (record.name == 'm') {
+         methylated.col(site_index) =
+             proportions.row(static_cast<Eigen::Index>(row)).transpose();
+      } else if (record.name == 'h') {
+         hydroxymethylated.col(site_index) =
+             proportions.row(static_cast<Eigen::Index>(row)).transpose();
+         has_hydroxy[static_cast<std::size_t>(site_index)] = true;
+      }
+   }
+
+   m_log_probabilities.assign(3, std::vector<double>(table_size));
+   for (std::size_t site{}; site < m_site_keys.size(); ++site) {
+      for (std::size_t cell_type{}; cell_type < m_num_cell_types;
+           ++cell_type) {
+         const std::size_t i{site * m_num_cell_types + cell_type};
+         const double p_m{methylated(static_cast<Eigen::Index>(cell_type),
+                                     static_cast<Eigen::Index>(site))};
+         const double p_h{
+             hydroxymethylated(static_cast<Eigen::Index>(cell_type),
+                               static_cast<Eigen::Index>(site))};
+         m_log_probabilities[methylated_call][i] = clampedLog(p_m);
+         m_log_probabilities[hydroxymethylated_call][i] =
+             has_hydroxy[site] ? clampedLog(p_h)
+                               : std::numeric_limits<double>::quiet_NaN();
+         m_log_probabilities[canonical_call][i] = clampedLog(1.0 - p_m - p_h);
+      }
+   }
+}
+
+/**
+ * Calls on the reverse strand are reported on the G of the CpG, so the
+ * preceding position (the C, as used by bedmethyl files) is tried as well.
+ */
+auto ReadAssigner::findSite(const BedRecords::ReadCall& call) const
+    -> RowIndex {
+   auto lookup{[this](GenomicKey key) -> RowIndex {
+      const auto site{std::ranges::lower_bound(m_site_keys, key)};
+      if (site == m_site_keys.end() || *site != key) return -1;
+      return std::distance(m_site_keys.begin(), site);
+   }};
+   const RowIndex site{lookup(siteKey(call.chromosome, call.start))};
+   if (site >= 0 || call.strand != '-') return site;
+   return lookup(siteKey(call.chromosome, call.start - 1));
+}
+
+/**
+ * The posterior is a softmax of the log likelihoods (uniform prior), computed
+ * relative to the maximum to avoid underflow on long reads.
+ */
+auto ReadAssigner::scoreRead(
+    std::span<const BedRecords::ReadCall> read_calls) const -> Assignment {
+   Assignment assignment{.read_id = read_calls.front().read_id};
+   std::vector<double> log_likelihoods(m_num_cell_types, 0.0);
+
+   for (const auto& call : read_calls) {
+      CallType call_type{};
+      switch (call.name) {
+         case 'm':
+            call_type = methylated_call;
+            break;
+         case 'h':
+            call_type = hydroxymethylated_call;
+            break;
+         case '-':
+            call_type = canonical_call;
+            break;
+         default:
+            continue;
+      }
+      const RowIndex site{findSite(call)};
+      if (site < 0) continue;
+      const double* log_probabilities{
+          m_log_probabilities[call_type].data() +
+          static_cast<std::size_t>(site) * m_num_cell_types};
+      if (std::isnan(log_probabilities[0])) continue;
+      for (std::size_t cell_type{}; cell_type < m_num_cell_types;
+           ++cell_type) {
+         log_likelihoods[cell_type] += log_probabilities[cell_type];
+      }
+      ++assignment.calls;
+   }
+
+   if (assignment.calls < m_min_calls || m_num_cell_types == 0) {
+      return assignment;
+   }
+   const auto best{std::ranges::max_element(log_likelihoods)};
+   double normaliser{};
+   for (const double log_likelihood : log_likelihoods) {
+      normaliser += std::exp(log_likelihood - *best);
+   }
+   assignment.cell_type =
+       static_cast<int>(std::distance(log_likelihoods.begin(), best));
+   assignment.posterior = 1.0 / normaliser;
+   return assignment;
+}
+
+/**
+ * Read boundaries are found serially (one comparison per call), then reads
+ * are split into blocks that are scored concurrently.
+ */
+auto ReadAssigner::assign(std::span<const BedRecords::ReadCall> calls,
+                          int threads) const -> std::vector<Assignment> {
+   std::vector<std::size_t> read_starts{};
+   for (std::size_t i{}; i < calls.size(); ++i) {
+      if (i == 0 || calls[i].read_id != calls[i - 1].read_id) {
+         read_starts.push_back(i);
+      }
+   }
+   read_starts.push_back(calls.size());
+
+   const std::size_t num_reads{read_starts.size() - 1};
+   std::vector<Assignment> assignments(num_reads);
+   Parallel::forEachBlock(
+       num_reads, threads, [&](const Parallel::Block& block) {
+          for (std::size_t read{block.begin}; read < block.end; ++read) {
+             assignments[read] = scoreRead(
+                 calls.subspan(read_starts[read],
+                               read_starts[read + 1] - read_starts[read]));
+          }
+       });
+   return assignments;
+}
+
+auto splitOffLastRead(std::vector<BedRecords::ReadCall>& calls)
+    -> std::vector<BedRecords::ReadCall> {
+   if (calls.empty()) return {};
+   const auto& last_read_id{calls.back().read_id};
+   // base() of the last call of the previous read is the first call of the
+   // last read (or the beginning if there is only one read)
+   const auto split{std::find_if(calls.rbegin(),
+                                 calls.rend(),
+                                 [&](const BedRecords::ReadCall& call) {
+                                    return call.read_id != last_read_id;
+                                 })
+                        .base()};
+   std::vector<BedRecords::ReadCall> last_read(
+       std::make_move_iterator(split), std::make_move_iterator(calls.end()));
+   calls.erase(split, calls.end());
+   return last_read;
+}
+}  // namespace Hylord::ReadAssignment
@@ -0,0 +1,99 @@
+#ifndef READ_ASSIGNER_H_
+#define READ_ASSIGNER_H_
+
+/**
+ * @file    ReadAssigner.hpp
+ * @brief   Declares assignment of individual reads to cell types using their
+ * modification calls.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "data/BedData.hpp"
+#include "data/BedRecords.hpp"
+#include "types.hpp"
+
+/// Handles read level cell type assignment for HyLoRD
+namespace Hylord::ReadAssignment {
+/// The most likely cell type of a single read
+struct Assignment {
+   static constexpr int unassigned{-1};
+
+   std::string read_id;
+   int cell_type{unassigned};  // column of the reference matrix
+   double posterior{};         // posterior probability of cell_type
+   int calls{};                // calls that overlapped the reference
+};
+
+/**
+ * @brief Scores reads against the methylation profiles of a reference matrix.
+ *
+ * Each call on a read is treated as an independent draw from the cell type's
+ * profile at that CpG site: 'm' with probability p_m, 'h' with probability
+ * p_h and canonical ('-') with probability 1 - p_m - p_h. The log likelihoods
+ * of a read are summed over its calls and turned into posteriors with a
+ * uniform prior over cell types.
+ *
+ * Log probabilities are precomputed per site and stored row-major (site by
+ * cell type), so scoring a call is one binary search followed by a
+ * contiguous add over the cell types.
+ */
+class ReadAssigner {
+  public:
+   /**
+    * @param reference Reference matrix with 'm' rows (and optionally 'h'
+    * rows). Needn't be sorted.
+    * @param min_calls Reads with fewer calls overlapping the reference are
+    * left unassigned.
+    */
+   ReadAssigner(const BedData::ReferenceMatrixData& reference, int min_calls);
+
+   /**
+    * Assigns every read in `calls`. Calls of a read must be contiguous and
+    * reads must be complete (see splitOffLastRead()). Reads are scored in
+    * parallel and returned in the order they appear.
+    */
+   [[nodiscard]] auto assign(std::span<const BedRecords::ReadCall> calls,
+                             int threads) const -> std::vector<Assignment>;
+   [[nodiscard]] auto numberOfCellTypes() const -> std::size_t {
+      return m_num_cell_types;
+   }
+
+   /// Probabilities are clamped to [min_probability, 1 - min_probability], so
+   /// a single call can't rule out a cell type.
+   static constexpr double min_probability{0.01};
+
+  private:
+   enum CallType : std::size_t {
+      methylated_call,
+      hydroxymethylated_call,
+      canonical_call
+   };
+   /// Finds the site of a call, or -1 if it isn't in the reference.
+   [[nodiscard]] auto findSite(const BedRecords::ReadCall& call) const
+       -> RowIndex;
+   [[nodiscard]] auto scoreRead(
+       std::span<const BedRecords::ReadCall> read_calls) const -> Assignment;
+
+   std::size_t m_num_cell_types{};
+   int m_min_calls{};
+   GenomicKeys m_site_keys{};  // sorted packKey(chromosome, start, 0)
+   /// log probability of each call type, indexed [call type][site * cell
+   /// types + cell type]. NaN where the reference has no 'h' row.
+   std::vector<std::vector<double>> m_log_probabilities{};
+};
+
+/**
+ * Moves the calls of the last read in `calls` out and returns them. Used when
+ * streaming, as the last read of a batch may continue in the next one.
+ */
+auto splitOffLastRead(std::vector<BedRecords::ReadCall>& calls)
+    -> std::vector<BedRecords::ReadCall>;
+}  // namespace Hylord::ReadAssignment
+
+#endif
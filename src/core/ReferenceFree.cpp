@@ -0,0 +1,157 @@
+/**
+ * @file    ReferenceFree.cpp
+ * @brief   Defines deconvolution without a reference matrix.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "core/ReferenceFree.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "core/Deconvolver.hpp"
+#include "data/BedData.hpp"
+#include "data/BedRecords.hpp"
+#include "parallel/ParallelFor.hpp"
+#include "types.hpp"
+
+namespace Hylord::ReferenceFree {
+namespace {
+/// Rows updated at once, so the fitted values of a block stay in L1 whilst
+/// each column of the block is updated.
+constexpr Eigen::Index row_block_size{256};
+/// Rows fitted to within this are left alone.
+constexpr double fit_tolerance{1e-12};
+
+/// Fitted values (profiles * proportions) of rows [begin, begin + size).
+void fitRows(const Matrix& profiles,
+             const Vector& cell_proportions,
+             Eigen::Index begin,
+             Eigen::Index size,
+             std::span<double> fitted) {
+   std::ranges::fill(fitted, 0.0);
+   for (Eigen::Index col{}; col < profiles.cols(); ++col) {
+      const double* column{profiles.col(col).data() + begin};
+      const double proportion{cell_proportions(col)};
+      for (Eigen::Index i{}; i < size; ++i) {
+         fitted[static_cast<std::size_t>(i)] += proportion * column[i];
+      }
+   }
+}
+}  // namespace
+
+/// Nothing but the matrix is allocated (the old path built a reference
+/// record per row before copying it into a matrix).
+auto initialProfiles(std::span<const BedRecords::Bed9Plus9> rows,
+                     int num_cell_types) -> Matrix {
+   Matrix profiles(std::ssize(rows), num_cell_types);
+   BedData::drawNovelProfiles(rows, profiles);
+   return profiles;
+}
+
+/**
+ * With the proportions fixed, each row of profiles is a separate least
+ * squares problem with a single equation. Rows are given the smallest change
+ * (along the proportions) that fits their bulk value whilst staying in
+ * [0, 1], so profiles remain valid methylation levels. Each sweep spreads the
+ * remaining misfit over the entries that can still move, so every row is
+ * fitted after at most one sweep per cell type. Unlike multiplicative
+ * (Lee-Seung) updates, this also moves entries that are exactly zero, which
+ * the CDFs produce often. Rows are independent, so blocks of rows are updated
+ * concurrently.
+ */
+auto updateProfiles(Matrix& profiles,
+                    const Vector& cell_proportions,
+                    const Vector& bulk_profile,
+                    int threads) -> double {
+   const auto rows{static_cast<std::size_t>(profiles.rows())};
+   const Eigen::Index cols{profiles.cols()};
+   std::vector<double> block_residuals(
+       Parallel::numberOfBlocks(rows, threads), 0.0);
+
+   Parallel::forEachBlock(rows, threads, [&](const Parallel::Block& block) {
+      std::array<double, row_block_size> misfits{};
+      std::array<double, row_block_size> movable_norms{};
+      double residual{};
+      for (auto begin{static_cast<Eigen::Index>(block.begin)};
+           begin < static_cast<Eigen::Index>(block.end);
+           begin += row_block_size) {
+         const Eigen::Index size{std::min(
+             row_block_size, static_cast<Eigen::Index>(block.end) - begin)};
+         const std::span<double> misfit{misfits.data(),
+                                        static_cast<std::size_t>(size)};
+         const std::span<double> movable_norm{movable_norms.data(),
+                                              misfit.size()};
+         for (Eigen::Index sweep{};; ++sweep) {
+            fitRows(profiles, cell_proportions, begin, size, misfit);
+            bool fitted{true};
+            for (Eigen::Index i{}; i < size; ++i) {
+               auto& row_misfit{misfit[static_cast<std::size_t>(i)]};
+               row_misfit = bulk_profile(begin + i) - row_misfit;
+               fitted = fitted && std::abs(row_misfit) < fit_tolerance;
+            }
+            if (fitted || sweep == cols) break;
+
+            std::ranges::fill(movable_norm, 0.0);
+            for (Eigen::Index col{}; col < cols; ++col) {
+               const double* column{profiles.col(col).data() + begin};
+               const double proportion{cell_proportions(col)};
+               for (Eigen::Index i{}; i < size; ++i) {
+                  const auto row{static_cast<std::size_t>(i)};
+                  const bool movable{misfit[row] > 0 ? column[i] < 1.0
+                                                     : column[i] > 0.0};
+                  if (movable) movable_norm[row] += proportion * proportion;
+               }
+            }
+            for (Eigen::Index i{}; i < size; ++i) {
+               const auto row{static_cast<std::size_t>(i)};
+               const bool needs_step{std::abs(misfit[row]) >= fit_tolerance &&
+                                     movable_norm[row] > 0.0};
+               misfit[row] =
+                   needs_step ? misfit[row] / movable_norm[row] : 0.0;
+            }
+            for (Eigen::Index col{}; col < cols; ++col) {
+               double* column{profiles.col(col).data() + begin};
+               const double proportion{cell_proportions(col)};
+               for (Eigen::Index i{}; i < size; ++i) {
+                  column[i] = std::clamp(
+                      column[i] +
+                          proportion * misfit[static_cast<std::size_t>(i)],
+                      0.0,
+                      1.0);
+               }
+            }
+         }
+         for (const double row_misfit : misfit) {
+            residual += row_misfit * row_misfit;
+         }
+      }
+      block_residuals[block.index] = residual;
+   });
+   return std::accumulate(block_residuals.begin(), block_residuals.end(), 0.0);
+}
+
+auto factorise(Deconvolution::Deconvolver& deconvolver,
+               Matrix& profiles,
+               const Vector& bulk_profile,
+               const Options& options) -> Result {
+   Result result{};
+   while (result.iterations < std::max(options.max_iterations, 1)) {
+      ++result.iterations;
+      deconvolver.runQpmad(profiles);
+      result.objective = std::sqrt(
+          updateProfiles(profiles,
+                         deconvolver.cellProportions(),
+                         bulk_profile,
+                         options.threads));
+      if (result.objective < options.convergence_threshold) break;
+   }
+   return result;
+}
+}  // namespace Hylord::ReferenceFree
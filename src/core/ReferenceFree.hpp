@@ -0,0 +1,63 @@
+#ifndef REFERENCE_FREE_H_
+#define REFERENCE_FREE_H_
+
+/**
+ * @file    ReferenceFree.hpp
+ * @brief   Declares deconvolution without a reference matrix, where every
+ * cell type profile is estimated alongside the proportions.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <span>
+
+#include "core/Deconvolver.hpp"
+#include "data/BedRecords.hpp"
+#include "types.hpp"
+
+/// Factorises the bulk profile into cell type profiles and proportions
+namespace Hylord::ReferenceFree {
+/// Stopping criteria of factorise().
+struct Options {
+   int max_iterations{};
+   double convergence_threshold{};
+   int threads{1};
+};
+
+struct Result {
+   int iterations{};
+   /// ||bulk - profiles * proportions|| after the last profile update.
+   double objective{};
+};
+
+/**
+ * Draws the starting profiles (n x num_cell_types, rows follow `rows`)
+ * straight into the matrix, using the methylation or hydroxymethylation CDF
+ * (see RNG) depending on each row's name.
+ */
+auto initialProfiles(std::span<const BedRecords::Bed9Plus9> rows,
+                     int num_cell_types) -> Matrix;
+
+/**
+ * Moves each profile row towards the bulk profile (an alternating least
+ * squares step for the profiles), clamping the result to [0, 1].
+ *
+ * @return Squared residual norm of the updated profiles.
+ */
+auto updateProfiles(Matrix& profiles,
+                    const Vector& cell_proportions,
+                    const Vector& bulk_profile,
+                    int threads) -> double;
+
+/**
+ * Alternates between solving for sum-to-one proportions (see
+ * Deconvolution::Deconvolver) and updating the profiles, until the objective
+ * drops below the convergence threshold or the iterations run out.
+ */
+auto factorise(Deconvolution::Deconvolver& deconvolver,
+               Matrix& profiles,
+               const Vector& bulk_profile,
+               const Options& options) -> Result;
+}  // namespace Hylord::ReferenceFree
+
+#endif
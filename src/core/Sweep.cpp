@@ -0,0 +1,166 @@
+/**
+ * @file    Sweep.cpp
+ * @brief   Defines deconvolution with many combinations of the bedmethyl row
+ * filters.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "core/Sweep.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "cli.hpp"
+#include "core/Deconvolver.hpp"
+#include "data/BedRecords.hpp"
+#include "maths/LinearAlgebra.hpp"
+#include "parallel/ParallelFor.hpp"
+#include "types.hpp"
+
+namespace Hylord::Sweep {
+namespace {
+/// Deconvolves against the given rows only, filling in the proportions and
+/// objective of `result`.
+void solveRows(const Matrix& reference_matrix,
+               const Vector& bulk_profile,
+               const RowIndexes& rows,
+               Result& result) {
+   const auto num_rows{std::ssize(rows)};
+   Matrix reference(num_rows, reference_matrix.cols());
+   Vector bulk(num_rows);
+   for (Eigen::Index col{}; col < reference_matrix.cols(); ++col) {
+      for (Eigen::Index i{}; i < num_rows; ++i) {
+         reference(i, col) =
+             reference_matrix(rows[static_cast<std::size_t>(i)], col);
+      }
+   }
+   for (Eigen::Index i{}; i < num_rows; ++i) {
+      bulk(i) = bulk_profile(rows[static_cast<std::size_t>(i)]);
+   }
+
+   Deconvolution::Deconvolver deconvolver{
+       static_cast<int>(reference_matrix.cols())};
+   deconvolver.runQpmad(LinearAlgebra::quadraticTerms(reference, bulk));
+   result.cell_proportions = deconvolver.cellProportions();
+   result.objective =
+       LinearAlgebra::residualNorm(reference, result.cell_proportions, bulk);
+}
+}  // namespace
+
+auto isRequested(const CMD::HylordConfig& config) -> bool {
+   return !config.sweep_min_read_depths.empty() ||
+          !config.sweep_max_read_depths.empty() ||
+          !config.sweep_signals.empty();
+}
+
+auto configurations(const CMD::HylordConfig& config)
+    -> std::vector<Configuration> {
+   const std::vector<int> min_read_depths{
+       config.sweep_min_read_depths.empty()
+           ? std::vector<int>{config.min_read_depth}
+           : config.sweep_min_read_depths};
+   const std::vector<int> max_read_depths{
+       config.sweep_max_read_depths.empty()
+           ? std::vector<int>{config.max_read_depth}
+           : config.sweep_max_read_depths};
+   std::vector<char> signals{};
+   for (const std::string& signal : config.sweep_signals) {
+      signals.push_back(signal == "both" ? '\0' : signal[0]);
+   }
+   if (signals.empty()) {
+      signals.push_back(config.use_only_methylation_signal ? 'm'
+                        : config.use_only_hydroxy_signal    ? 'h'
+                                                            : '\0');
+   }
+
+   std::vector<Configuration> configurations{};
+   for (const int min_read_depth : min_read_depths) {
+      for (const int max_read_depth : max_read_depths) {
+         for (const char signal : signals) {
+            configurations.push_back({.min_read_depth = min_read_depth,
+                                      .max_read_depth = max_read_depth,
+                                      .signal = signal});
+         }
+      }
+   }
+   return configurations;
+}
+
+auto filterColumns(std::span<const BedRecords::Bed9Plus9> rows)
+    -> FilterColumns {
+   FilterColumns columns{};
+   columns.read_depths.reserve(rows.size());
+   columns.names.reserve(rows.size());
+   for (const auto& row : rows) {
+      columns.read_depths.push_back(row.read_depth);
+      columns.names.push_back(row.name);
+   }
+   return columns;
+}
+
+/**
+ * The row filter skips the depth checks when the minimum is 0 or the
+ * maximum is unset, which is mirrored here by widening the bounds. The mask
+ * is built without branches so that the pass vectorises, and the indexes of
+ * passing rows are gathered afterwards.
+ */
+auto selectRows(const FilterColumns& columns,
+                const Configuration& configuration) -> RowIndexes {
+   // Rows have to be deeper than the minimum, which none can be here (and
+   // the lower bound below would overflow)
+   if (configuration.min_read_depth == std::numeric_limits<int>::max()) {
+      return {};
+   }
+   const int lowest{configuration.min_read_depth == 0
+                        ? std::numeric_limits<int>::min()
+                        : configuration.min_read_depth + 1};
+   const int highest{
+       configuration.max_read_depth == std::numeric_limits<int>::max()
+           ? std::numeric_limits<int>::max()
+           : configuration.max_read_depth - 1};
+   const char signal{configuration.signal};
+   const std::size_t num_rows{columns.read_depths.size()};
+
+   std::vector<std::uint8_t> mask(num_rows);
+   for (std::size_t i{}; i < num_rows; ++i) {
+      const int read_depth{columns.read_depths[i]};
+      const auto in_range{static_cast<unsigned>(read_depth >= lowest) &
+                          static_cast<unsigned>(read_depth <= highest)};
+      const auto has_signal{static_cast<unsigned>(signal == '\0') |
+                            static_cast<unsigned>(columns.names[i] == signal)};
+      mask[i] = static_cast<std::uint8_t>(in_range & has_signal);
+   }
+
+   RowIndexes rows{};
+   for (std::size_t i{}; i < num_rows; ++i) {
+      if (mask[i] != 0) rows.push_back(static_cast<RowIndex>(i));
+   }
+   return rows;
+}
+
+auto solve(const Matrix& reference_matrix,
+           const Vector& bulk_profile,
+           const FilterColumns& columns,
+           const std::vector<Configuration>& configurations,
+           int threads) -> std::vector<Result> {
+   std::vector<Result> results(configurations.size());
+   Parallel::forEachBlock(
+       configurations.size(), threads, [&](const Parallel::Block& block) {
+          for (std::size_t i{block.begin}; i < block.end; ++i) {
+             Result& result{results[i]};
+             result.configuration = configurations[i];
+             const RowIndexes rows{selectRows(columns, configurations[i])};
+             result.cpgs = rows.size();
+             if (!rows.empty()) {
+                solveRows(reference_matrix, bulk_profile, rows, result);
+             }
+          }
+       });
+   return results;
+}
+}  // namespace Hylord::Sweep
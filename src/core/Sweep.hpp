@@ -0,0 +1,83 @@
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+/**
+ * @file    Sweep.hpp
+ * @brief   Declares deconvolution with many combinations of the bedmethyl row
+ * filters from a single parse of the inputs.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "cli.hpp"
+#include "data/BedRecords.hpp"
+#include "types.hpp"
+
+/**
+ * Deconvolves against every combination of swept row filters (see
+ * --sweep-min-read-depth, --sweep-max-read-depth and --sweep-signal).
+ *
+ * The row filters only look at the bedmethyl rows, so filtering after the
+ * join gives the same rows as filtering whilst reading. The inputs are read
+ * and joined once without filters, keeping the read depth and name of each
+ * row. Each combination then only needs a pass over these columns to find
+ * its rows, followed by a single solve.
+ */
+namespace Hylord::Sweep {
+/// A combination of the bedmethyl row filters (see
+/// Filters::generateBedmethylRowFilter).
+struct Configuration {
+   int min_read_depth{};
+   int max_read_depth{std::numeric_limits<int>::max()};
+   /// 'm' or 'h' to only use that signal, '\0' to use both.
+   char signal{};
+};
+
+struct Result {
+   Configuration configuration{};
+   /// Number of rows that passed the filters.
+   std::size_t cpgs{};
+   /// Empty if no rows passed the filters.
+   Vector cell_proportions;
+   double objective{};
+};
+
+/// The fields of the joined bedmethyl rows that the row filters look at.
+struct FilterColumns {
+   std::vector<int> read_depths;
+   std::vector<char> names;
+};
+
+/// Whether any --sweep-* option was given.
+auto isRequested(const CMD::HylordConfig& config) -> bool;
+
+/// Every combination of the swept values. Filters that aren't swept keep
+/// their configured value.
+auto configurations(const CMD::HylordConfig& config)
+    -> std::vector<Configuration>;
+
+auto filterColumns(std::span<const BedRecords::Bed9Plus9> rows)
+    -> FilterColumns;
+
+/// Rows passing the filters of `configuration`, matching the row filter
+/// built from the same options.
+auto selectRows(const FilterColumns& columns,
+                const Configuration& configuration) -> RowIndexes;
+
+/**
+ * Solves each configuration against its rows of the reference matrix and
+ * bulk profile. Configurations are solved concurrently.
+ */
+auto solve(const Matrix& reference_matrix,
+           const Vector& bulk_profile,
+           const FilterColumns& columns,
+           const std::vector<Configuration>& configurations,
+           int threads) -> std::vector<Result>;
+}  // namespace Hylord::Sweep
+
+#endif
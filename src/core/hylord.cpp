@@ -7,133 +7,827 @@
 
 #include "core/hylord.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "Eigen/Dense"
 #include "HylordException.hpp"
 #include "cli.hpp"
+#include "core/BatchSolver.hpp"
 #include "core/Deconvolver.hpp"
+#include "core/ReadAssigner.hpp"
+#include "core/ReferenceFree.hpp"
+#include "core/Sweep.hpp"
 #include "data/BedData.hpp"
 #include "data/BedRecords.hpp"
+#include "data/Binning.hpp"
 #include "data/DataProcessing.hpp"
 #include "data/Filters.hpp"
+#include "io/BatchJournal.hpp"
+#include "io/CDFFile.hpp"
+#include "io/ParseStatistics.hpp"
+#include "io/ScratchMatrix.hpp"
+#include "io/SharedReference.hpp"
+#include "io/SidecarIndex.hpp"
+#include "io/TSVFileReader.hpp"
+#include "io/TrackWriter.hpp"
 #include "io/writeMetrics.hpp"
 #include "maths/LinearAlgebra.hpp"
+#include "parallel/ParallelFor.hpp"
+#include "random/rng.hpp"
 #include "types.hpp"
 
 namespace Hylord {
+namespace {
+/// Scales --batch-size (in MB) to bytes.
+constexpr std::size_t bytes_per_mb{std::size_t{1} << 20U};
 
-/**
- * Main workflow function that performs:
- * 1. Data processing:
- *    - Reads and filters CpG list, reference matrix, and bedmethyl data
- *    - Preprocesses input data into numerical matrices
- * 2. Deconvolution:
- *    - Initializes deconvolution solver
- *    - Runs iterative deconvolution with reference matrix updates
- * 3. Output:
- *    - Writes final metrics and proportions (possibly to a file)
- */
-auto run(CMD::HylordConfig& config) -> int {
-   try {
-      // --------------- //
-      // Data processing //
-      // --------------- //
-
-      if (config.reference_matrix_file.empty() &&
-          config.additional_cell_types == 0) {
-         throw HylordException(
-             "If no reference matrix is provided, additional_cell_types "
-             "should be set (>0).");
-      }
+/// Describes the signals kept by the name filter (see
+/// Filters::generateNameFilter()).
+auto signalsKept(const CMD::HylordConfig& config) -> std::string {
+   return std::string{config.use_only_methylation_signal ? "m" : ""} +
+          (config.use_only_hydroxy_signal ? "h" : "");
+}
 
-      IO::RowFilter mark_filter{Filters::generateNameFilter(config)};
-      BedData::CpGData cpg_list{
-          Processing::readFile<BedData::CpGData, BedRecords::Bed4>(
-              config.cpg_list_file, config.num_threads, {}, mark_filter)};
+/// Whether any output with a line per CpG was asked for (see writeTracks()).
+auto tracksRequested(const CMD::HylordConfig& config) -> bool {
+   return !config.reference_out_file.empty() ||
+          !config.residuals_out_file.empty();
+}
 
-      BedData::ReferenceMatrixData reference_matrix_data{
-          Processing::readFile<BedData::ReferenceMatrixData,
-                               BedRecords::Bed4PlusX>(
-              config.reference_matrix_file,
-              config.num_threads,
-              {},
-              mark_filter)};
+/// Keys of the rows of the deconvolution, if writeTracks() needs them.
+template <typename Records>
+auto keysForTracks(const CMD::HylordConfig& config, const Records& records)
+    -> GenomicKeys {
+   return tracksRequested(config) ? BedData::keysOf(records) : GenomicKeys{};
+}
 
-      // chr, start, end, name, score (read_depth) and fraction modified (see
-      // Modkit README)
+/**
+ * Writes the outputs with a line per CpG (rows keyed by `keys`) that were
+ * asked for: the final reference matrix (see --write-reference), so the
+ * learned novel profiles can be reused, and the residual track (see
+ * --write-residuals).
+ */
+void writeTracks(const CMD::HylordConfig& config,
+                 const GenomicKeys& keys,
+                 const Eigen::Ref<const Matrix>& reference_matrix,
+                 const Vector& cell_proportions,
+                 const Eigen::Ref<const Vector>& bulk_profile) {
+   if (!config.reference_out_file.empty()) {
+      const auto out_path{IO::writeReferenceMatrix(config.reference_out_file,
+                                                   keys,
+                                                   reference_matrix,
+                                                   config.num_threads)};
+      std::cout << "Wrote reference matrix to: " << out_path.string() << '\n';
+   }
+   if (!config.residuals_out_file.empty()) {
+      const auto out_path{IO::writeResidualTrack(config.residuals_out_file,
+                                                 keys,
+                                                 reference_matrix,
+                                                 cell_proportions,
+                                                 bulk_profile,
+                                                 config.num_threads)};
+      std::cout << "Wrote residuals to: " << out_path.string() << '\n';
+   }
+}
+
+/**
+ * Reads the fields of the bedmethyl file used in deconvolution: chr, start,
+ * end, name, score (read depth) and fraction modified (see Modkit README).
+ * Per mark bedGraph files are read instead if given, skipping the file of a
+ * signal that isn't used (see Processing::readBedGraphs). Sweeps apply the
+ * row filters of each configuration after the join. The QC report (if asked
+ * for) is gathered whilst parsing and written straight away.
+ */
+auto readBedmethyl(const CMD::HylordConfig& config,
+                   bool sweep,
+                   const IO::KeyRanges& cpg_key_ranges)
+    -> BedData::BedMethylData {
+   IO::ParseStatistics statistics{};
+   IO::ParseStatistics* qc_statistics{
+       config.qc_report_file.empty() ? nullptr : &statistics};
+   BedData::BedMethylData bedmethyl{};
+   if (!config.methylation_bedgraph_file.empty() ||
+       !config.hydroxy_bedgraph_file.empty()) {
+      std::vector<Processing::BedGraphFile> bedgraph_files{};
+      if (!config.methylation_bedgraph_file.empty() &&
+          (sweep || !config.use_only_hydroxy_signal)) {
+         bedgraph_files.push_back({'m', config.methylation_bedgraph_file});
+      }
+      if (!config.hydroxy_bedgraph_file.empty() &&
+          (sweep || !config.use_only_methylation_signal)) {
+         bedgraph_files.push_back({'h', config.hydroxy_bedgraph_file});
+      }
+      bedmethyl = Processing::readBedGraphs(
+          bedgraph_files,
+          config.num_threads,
+          sweep ? nullptr : Filters::generateReadDepthFilter(config),
+          qc_statistics);
+   } else {
       IO::ColumnIndexes bedmethyl_important_fields{0, 1, 2, 3, 4, 10};
       IO::RowFilter bedmethyl_row_filter{
-          Filters::generateBedmethylRowFilter(config)};
-      BedData::BedMethylData bedmethyl{
+          sweep ? nullptr : Filters::generateBedmethylRowFilter(config)};
+      bedmethyl =
           Processing::readFile<BedData::BedMethylData, BedRecords::Bed9Plus9>(
               config.bedmethyl_file,
               config.num_threads,
               bedmethyl_important_fields,
-              bedmethyl_row_filter)};
-
-      Processing::preprocessInputData(bedmethyl,
-                                      reference_matrix_data,
-                                      cpg_list,
-                                      config.additional_cell_types);
-      Vector bulk_profile{bedmethyl.getAsEigenVector()};
-      Matrix reference_matrix{reference_matrix_data.getAsEigenMatrix()};
-
-      // ------------- //
-      // Deconvolution //
-      // ------------- //
-      Deconvolution::Deconvolver deconvolver{
-          reference_matrix_data.numberOfCellTypes(), bulk_profile};
-      if (config.additional_cell_types == 0) {
+              bedmethyl_row_filter,
+              cpg_key_ranges,
+              qc_statistics);
+   }
+   if (qc_statistics != nullptr) IO::writeQCReport(config, statistics);
+   return bedmethyl;
+}
+
+/**
+ * Deconvolution without a reference matrix. The profiles of every cell type
+ * are estimated, so they are allocated as a single matrix straight from the
+ * bedmethyl rows and refined alongside the proportions (see
+ * ReferenceFree::factorise).
+ */
+auto runReferenceFree(CMD::HylordConfig& config,
+                      BedData::BedMethylData& bedmethyl,
+                      BedData::CpGData& cpg_list) -> int {
+   Processing::preprocessBedmethyl(bedmethyl, cpg_list, config.num_threads);
+   const Vector bulk_profile{bedmethyl.getAsEigenVector()};
+   Matrix profiles{ReferenceFree::initialProfiles(
+       bedmethyl.records(), config.additional_cell_types)};
+
+   Deconvolution::Deconvolver deconvolver{config.additional_cell_types,
+                                          bulk_profile};
+   const ReferenceFree::Result result{ReferenceFree::factorise(
+       deconvolver,
+       profiles,
+       bulk_profile,
+       {.max_iterations = config.max_iterations,
+        .convergence_threshold = config.convergence_threshold,
+        .threads = config.num_threads})};
+   std::cout << "Deconvolution loop finished after " << result.iterations
+             << " iteration" << (result.iterations == 1 ? ".\n" : "s.\n");
+   std::cout << "Deconvolution resulted in an objective function of: "
+             << result.objective << '\n';
+
+   writeTracks(config,
+               keysForTracks(config, bedmethyl.records()),
+               profiles,
+               deconvolver.cellProportions(),
+               bulk_profile);
+   IO::writeMetrics(config, deconvolver);
+   return 0;
+}
+
+/**
+ * Alternates between solving the QPP and updating the novel profiles of the
+ * reference matrix (see LinearAlgebra::updateReferenceMatrix) until the
+ * objective converges or the iterations run out.
+ */
+void runHybridLoop(const CMD::HylordConfig& config,
+                   Deconvolution::Deconvolver& deconvolver,
+                   Eigen::Ref<Matrix> reference_matrix,
+                   const Eigen::Ref<const Vector>& bulk_profile) {
+   // Each update computes the QPP terms of the updated matrix as well, so
+   // only the first solve needs a separate pass over the matrix
+   LinearAlgebra::QuadraticTerms terms{
+       LinearAlgebra::quadraticTerms(reference_matrix, bulk_profile)};
+   int iteration{0};
+   while (iteration <= config.max_iterations) {
+      iteration++;
+      deconvolver.runQpmad(std::move(terms));
+      LinearAlgebra::ReferenceUpdate update{};
+      try {
+         update = LinearAlgebra::updateReferenceMatrix(
+             reference_matrix,
+             deconvolver.cellProportions(),
+             bulk_profile,
+             config.additional_cell_types,
+             config.num_threads);
+      } catch (const std::exception& e) {
+         std::cerr << "Warning: " << e.what()
+                   << " Reference matrix could not be updated as a result "
+                      "(iteration: "
+                   << iteration << ").\n"
+                   << "Rerunning HyLoRD with a lower number of iterations "
+                      "(--max-iterations) might help.\n"
+                   << "If this doesn't help, please consult the "
+                      "documentation or consider opening an issue at "
+                      "https://github.com/sof202/HyLoRD/issues.\n";
+         break;
+      }
+      if (update.objective < config.convergence_threshold) break;
+      terms = std::move(update.terms);
+   }
+   std::cout << "Deconvolution loop finished after " << iteration
+             << " iteration" << (iteration == 1 ? ".\n" : "s.\n");
+   std::cout << "Deconvolution resulted in an objective function of: "
+             << LinearAlgebra::residualNorm(reference_matrix,
+                                            deconvolver.cellProportions(),
+                                            bulk_profile)
+             << '\n';
+}
+
+/**
+ * Hybrid deconvolution with the reference matrix, novel profiles and bulk
+ * profile held in a memory mapped scratch file (see IO::ScratchMatrix), so
+ * that only the QPP terms (k x k) are held in memory during the loop. The
+ * parsed inputs are released once they are copied in, and the novel
+ * profiles are drawn straight into the file.
+ */
+auto runOutOfCore(CMD::HylordConfig& config,
+                  BedData::BedMethylData bedmethyl,
+                  BedData::ReferenceMatrixData reference_matrix_data) -> int {
+   const Eigen::Index rows{std::ssize(bedmethyl.records())};
+   const int reference_cell_types{reference_matrix_data.numberOfCellTypes()};
+   const int num_cell_types{reference_cell_types +
+                            config.additional_cell_types};
+   // The bulk profile is stored as the last column
+   IO::ScratchMatrix scratch{
+       rows, num_cell_types + 1, config.scratch_directory};
+   Eigen::Map<Matrix> columns{scratch.matrix()};
+   columns.leftCols(reference_cell_types) =
+       reference_matrix_data.getAsEigenMatrix();
+   BedData::drawNovelProfiles(
+       reference_matrix_data.records(),
+       columns.middleCols(reference_cell_types, config.additional_cell_types));
+   for (Eigen::Index row{}; row < rows; ++row) {
+      columns(row, num_cell_types) =
+          bedmethyl.records()[static_cast<std::size_t>(row)]
+              .methylation_proportion;
+   }
+   // Keys are 8 bytes a row, so they are kept for writeTracks()
+   const GenomicKeys keys{
+       keysForTracks(config, reference_matrix_data.records())};
+   reference_matrix_data = BedData::ReferenceMatrixData{};
+   bedmethyl = BedData::BedMethylData{};
+
+   Deconvolution::Deconvolver deconvolver{num_cell_types};
+   runHybridLoop(config,
+                 deconvolver,
+                 columns.leftCols(num_cell_types),
+                 columns.col(num_cell_types));
+   writeTracks(config,
+               keys,
+               columns.leftCols(num_cell_types),
+               deconvolver.cellProportions(),
+               columns.col(num_cell_types));
+   IO::writeMetrics(config, deconvolver);
+   return 0;
+}
+
+/**
+ * Deconvolves against every configuration of the sweep (see Sweep), joining
+ * the unfiltered inputs once. Only the read depth and name of each bedmethyl
+ * row are kept for the configurations to filter on.
+ */
+auto runSweep(const CMD::HylordConfig& config,
+              BedData::BedMethylData& bedmethyl,
+              BedData::ReferenceMatrixData& reference_matrix_data,
+              BedData::CpGData& cpg_list) -> int {
+   Processing::preprocessInputData(
+       bedmethyl, reference_matrix_data, cpg_list, 0, config.num_threads);
+   const Sweep::FilterColumns columns{
+       Sweep::filterColumns(bedmethyl.records())};
+   const std::vector<Sweep::Result> results{
+       Sweep::solve(reference_matrix_data.getAsEigenMatrix(),
+                    bedmethyl.getAsEigenVector(),
+                    columns,
+                    Sweep::configurations(config),
+                    config.num_threads)};
+   IO::writeSweepResults(
+       config,
+       IO::generateCellTypeList(
+           config,
+           static_cast<std::size_t>(
+               reference_matrix_data.numberOfCellTypes())),
+       results);
+   return 0;
+}
+
+/**
+ * Deconvolves every sample (column) of a bulk matrix against the reference
+ * matrix (see Deconvolution::solveBatch), after reading and joining both
+ * once.
+ */
+auto runBulkMatrix(const CMD::HylordConfig& config,
+                   const IO::RowFilter& mark_filter,
+                   const IO::KeyRanges& cpg_key_ranges,
+                   BedData::ReferenceMatrixData& reference_matrix_data,
+                   BedData::CpGData& cpg_list) -> int {
+   BedData::ReferenceMatrixData bulk_matrix{
+       Processing::readReferenceMatrix(config.bulk_matrix_file,
+                                       config.num_threads,
+                                       {},
+                                       mark_filter,
+                                       cpg_key_ranges)};
+   Processing::preprocessBulkMatrix(
+       bulk_matrix, reference_matrix_data, cpg_list, config.num_threads);
+   const Deconvolution::BatchResult result{
+       Deconvolution::solveBatch(reference_matrix_data.getAsEigenMatrix(),
+                                 bulk_matrix.getAsEigenMatrix(),
+                                 config.num_threads)};
+   IO::writeBatchResults(
+       config,
+       IO::generateCellTypeList(
+           config,
+           static_cast<std::size_t>(
+               reference_matrix_data.numberOfCellTypes())),
+       IO::generateSampleNames(
+           config, static_cast<std::size_t>(result.cell_proportions.cols())),
+       result);
+   return 0;
+}
+
+/**
+ * Deconvolves the bedmethyl data against several reference panels (see
+ * --reference-matrix), after reading and preprocessing it once. The panels
+ * are read, joined and solved in parallel, sharing the threads between them.
+ */
+auto runPanels(const CMD::HylordConfig& config,
+               const IO::RowFilter& mark_filter,
+               const IO::KeyRanges& cpg_key_ranges,
+               BedData::CpGData& cpg_list) -> int {
+   BedData::BedMethylData bedmethyl{
+       readBedmethyl(config, false, cpg_key_ranges)};
+   Processing::preprocessBedmethyl(bedmethyl, cpg_list, config.num_threads);
+
+   const std::size_t panels{config.reference_matrix_files.size()};
+   const int panel_threads{
+       std::max(1, config.num_threads / static_cast<int>(panels))};
+   std::vector<IO::PanelResult> results(panels);
+   std::vector<double> objectives(panels);
+   Parallel::forEachBlock(
+       panels, config.num_threads, [&](const Parallel::Block& block) {
+          for (std::size_t i{block.begin}; i < block.end; ++i) {
+             BedData::ReferenceMatrixData reference_matrix_data{
+                 Processing::readReferenceMatrix(
+                     config.reference_matrix_files[i],
+                     panel_threads,
+                     {},
+                     mark_filter,
+                     cpg_key_ranges)};
+             const Vector bulk_profile{
+                 Processing::joinWithPanel(
+                     bedmethyl, reference_matrix_data, cpg_list, panel_threads)
+                     .getAsEigenVector()};
+             const Matrix& reference_matrix{
+                 reference_matrix_data.getAsEigenMatrix()};
+             Deconvolution::Deconvolver deconvolver{
+                 reference_matrix_data.numberOfCellTypes(), bulk_profile};
+             deconvolver.runQpmad(reference_matrix);
+             objectives[i] =
+                 deconvolver.evaluateObjectiveFunctionL2Norm(reference_matrix);
+             results[i].cell_proportions = deconvolver.cellProportions();
+          }
+       });
+
+   CMD::HylordConfig panel_config{config};
+   for (std::size_t i{}; i < panels; ++i) {
+      results[i].reference_matrix_file = config.reference_matrix_files[i];
+      panel_config.cell_type_list_file = config.cell_type_list_files.empty()
+                                             ? ""
+                                             : config.cell_type_list_files[i];
+      results[i].cell_type_list = IO::generateCellTypeList(
+          panel_config,
+          static_cast<std::size_t>(results[i].cell_proportions.size()));
+      std::cout << "Deconvolution against " << results[i].reference_matrix_file
+                << " resulted in an objective function of: " << objectives[i]
+                << '\n';
+   }
+   IO::writePanelResults(config, results);
+   return 0;
+}
+
+/**
+ * Identifies the inputs a batch sample is deconvolved with: its bedmethyl
+ * file, the shared inputs (reference matrix, cell type list and CpG list)
+ * and the row filters. A change to any of them reruns the sample.
+ */
+auto batchInputIdentity(const CMD::HylordConfig& config,
+                        const std::filesystem::path& bedmethyl_file)
+    -> std::uint64_t {
+   std::string inputs{};
+   for (const std::string& file_path : {config.reference_matrix_file,
+                                        config.cell_type_list_file,
+                                        config.cpg_list_file}) {
+      inputs += file_path.empty()
+                    ? "-"
+                    : std::to_string(IO::referenceIdentity(file_path,
+                                                           {},
+                                                           {},
+                                                           ""));
+      inputs += '|';
+   }
+   inputs += std::to_string(config.min_read_depth) + '|' +
+             std::to_string(config.max_read_depth) + '|' +
+             signalsKept(config);
+   return IO::referenceIdentity(bedmethyl_file, {}, {}, inputs);
+}
+
+/**
+ * Deconvolves every sample of the manifest against the reference matrix,
+ * writing the proportions of each to <out-dir>/<sample>.tsv:
+ * 1. Samples the journal records as finished, with the same inputs and an
+ *    intact output, are skipped (see IO::BatchJournal)
+ * 2. The CpG list and reference matrix are read once, when the first
+ *    remaining sample needs them
+ * 3. Each remaining sample is read, joined with the reference matrix (only
+ *    the shared rows being copied out) and solved. Its output is written
+ *    atomically (see IO::commitFile) before being recorded in the journal
+ * A failing sample is reported and left for the next run, without stopping
+ * the batch.
+ */
+auto runBatch(const CMD::HylordConfig& config) -> int {
+   const std::vector<IO::BatchSample> samples{
+       IO::readManifest(config.batch_manifest_file)};
+   // Absolute, so that the journal still finds the outputs when the batch
+   // is resumed from another directory
+   const std::filesystem::path out_directory{
+       std::filesystem::absolute(config.batch_out_directory)};
+   std::filesystem::create_directories(out_directory);
+   IO::BatchJournal journal{config.batch_journal_file.empty()
+                                ? out_directory / "hylord_journal.tsv"
+                                : std::filesystem::path{
+                                      config.batch_journal_file}};
+
+   const IO::RowFilter mark_filter{Filters::generateNameFilter(config)};
+   std::optional<BedData::CpGData> cpg_list{};
+   IO::KeyRanges cpg_key_ranges{};
+   std::optional<BedData::ReferenceMatrixData> reference_matrix_data{};
+   std::vector<BedRecords::CellType> cell_type_list{};
+   std::size_t finished{};
+   std::size_t skipped{};
+   std::size_t failed{};
+   for (const IO::BatchSample& sample : samples) {
+      const std::uint64_t identity{
+          batchInputIdentity(config, sample.bedmethyl_file)};
+      if (journal.isComplete(sample.name, identity)) {
+         ++skipped;
+         continue;
+      }
+      if (!reference_matrix_data) {
+         cpg_list = Processing::readCpGList(
+             config.cpg_list_file, config.num_threads, mark_filter);
+         cpg_key_ranges = cpg_list->keyRanges();
+         reference_matrix_data =
+             Processing::readReferenceMatrix(config.reference_matrix_file,
+                                             config.num_threads,
+                                             {},
+                                             mark_filter,
+                                             cpg_key_ranges);
+         Processing::prepareSharedReference(
+             *reference_matrix_data, *cpg_list, config.num_threads);
+         cell_type_list = IO::generateCellTypeList(
+             config,
+             static_cast<std::size_t>(
+                 reference_matrix_data->numberOfCellTypes()));
+      }
+      try {
+         CMD::HylordConfig sample_config{config};
+         sample_config.bedmethyl_file = sample.bedmethyl_file.string();
+         BedData::BedMethylData bedmethyl{
+             readBedmethyl(sample_config, false, cpg_key_ranges)};
+         Processing::preprocessBedmethyl(
+             bedmethyl, *cpg_list, config.num_threads);
+         // Only the rows shared with the sample are copied out
+         const auto [reference_rows, bedmethyl_rows]{
+             Processing::overlapWithSharedReference(bedmethyl,
+                                                    *reference_matrix_data)};
+         bedmethyl.subsetRows(bedmethyl_rows);
+         const BedData::ReferenceMatrixData sample_reference{
+             reference_matrix_data->gatherRows(reference_rows)};
+         const Vector bulk_profile{bedmethyl.getAsEigenVector()};
+         const Matrix& reference_matrix{sample_reference.getAsEigenMatrix()};
+         Deconvolution::Deconvolver deconvolver{
+             sample_reference.numberOfCellTypes(), bulk_profile};
          deconvolver.runQpmad(reference_matrix);
-         std::cout << "Deconvolution resulted in an objective function of: "
+
+         const std::string output{IO::formatProportions(
+             cell_type_list, deconvolver.cellProportions())};
+         const std::filesystem::path out_path{out_directory /
+                                              (sample.name + ".tsv")};
+         IO::commitFile(output, out_path);
+         journal.record(
+             {sample.name, identity, IO::contentHash(output), out_path});
+         ++finished;
+         std::cout << "Deconvolution of " << sample.name
+                   << " resulted in an objective function of: "
                    << deconvolver.evaluateObjectiveFunctionL2Norm(
                           reference_matrix)
                    << '\n';
-         IO::writeMetrics(config, deconvolver);
-         return 0;
+      } catch (const HylordException& e) {
+         ++failed;
+         std::cerr << e.what() << '\n'
+                   << "Warning: Sample " << sample.name
+                   << " failed, it will be retried when the batch is "
+                      "rerun.\n";
+      } catch (const std::exception& e) {
+         ++failed;
+         std::cerr << "Error: " << e.what() << '\n'
+                   << "Warning: Sample " << sample.name
+                   << " failed, it will be retried when the batch is "
+                      "rerun.\n";
       }
+   }
+   std::cout << "Batch finished: " << finished << " deconvolved, " << skipped
+             << " already complete, " << failed << " failed.\n";
+   return failed == 0 ? 0 : 1;
+}
 
-      int iteration{0};
-      while (iteration <= config.max_iterations) {
-         iteration++;
-         deconvolver.runQpmad(reference_matrix);
-         try {
-            LinearAlgebra::updateReferenceMatrix(reference_matrix,
-                                                 deconvolver.cellProportions(),
-                                                 bulk_profile,
-                                                 config.additional_cell_types);
-         } catch (const std::exception& e) {
-            std::cerr << "Warning: " << e.what()
-                      << " Reference matrix could not be updated as a result "
-                         "(iteration: "
-                      << iteration << ").\n"
-                      << "Rerunning HyLoRD with a lower number of iterations "
-                         "(--max-iterations) might help.\n"
-                      << "If this doesn't help, please consult the "
-                         "documentation or consider opening an issue at "
-                         "https://github.com/sof202/HyLoRD/issues.\n";
-            break;
-         }
-         if (deconvolver.evaluateObjectiveFunctionL2Norm(reference_matrix) <
-             config.convergence_threshold) {
-            break;
-         }
-      }
-      std::cout << "Deconvolution loop finished after " << iteration
-                << " iteration" << (iteration == 1 ? ".\n" : "s.\n");
+/**
+ * Main deconvolution workflow that performs:
+ * 1. Data processing:
+ *    - Reads and filters CpG list, reference matrix, and bedmethyl data
+ *    - Preprocesses input data into numerical matrices
+ * 2. Deconvolution:
+ *    - Initializes deconvolution solver
+ *    - Runs iterative deconvolution with reference matrix updates
+ * 3. Output:
+ *    - Writes final metrics and proportions (possibly to a file)
+ */
+auto runDeconvolution(CMD::HylordConfig& config) -> int {
+   // --------------- //
+   // Data processing //
+   // --------------- //
+
+   if (config.reference_matrix_file.empty() &&
+       config.additional_cell_types == 0) {
+      throw HylordException(
+          "If no reference matrix is provided, additional_cell_types "
+          "should be set (>0).");
+   }
+
+   // Sweeps apply the row filters of each configuration after the join
+   const bool sweep{Sweep::isRequested(config)};
+   IO::RowFilter mark_filter{sweep ? nullptr
+                                   : Filters::generateNameFilter(config)};
+   BedData::CpGData cpg_list{Processing::readCpGList(
+       config.cpg_list_file, config.num_threads, mark_filter)};
+   // Only rows that can survive the join with the CpG list are needed, so
+   // indexed inputs can skip everything outside of these ranges.
+   const IO::KeyRanges cpg_key_ranges{cpg_list.keyRanges()};
+   if (config.reference_matrix_files.size() > 1) {
+      return runPanels(config, mark_filter, cpg_key_ranges, cpg_list);
+   }
+
+   const IO::ColumnIndexes cell_type_columns{Processing::findCellTypeColumns(
+       config.cell_type_list_file, config.selected_cell_types)};
+   BedData::ReferenceMatrixData reference_matrix_data{
+       config.shared_reference_name.empty()
+           ? Processing::readReferenceMatrix(config.reference_matrix_file,
+                                             config.num_threads,
+                                             cell_type_columns,
+                                             mark_filter,
+                                             cpg_key_ranges)
+           : Processing::readSharedReferenceMatrix(
+                 config.shared_reference_name,
+                 config.reference_matrix_file,
+                 config.num_threads,
+                 cell_type_columns,
+                 mark_filter,
+                 cpg_key_ranges,
+                 mark_filter ? signalsKept(config) : "")};
+   if (!config.bulk_matrix_file.empty()) {
+      return runBulkMatrix(config,
+                           mark_filter,
+                           cpg_key_ranges,
+                           reference_matrix_data,
+                           cpg_list);
+   }
+
+   BedData::BedMethylData bedmethyl{
+       readBedmethyl(config, sweep, cpg_key_ranges)};
+   if (config.reference_matrix_file.empty()) {
+      return runReferenceFree(config, bedmethyl, cpg_list);
+   }
+   if (sweep) {
+      return runSweep(config, bedmethyl, reference_matrix_data, cpg_list);
+   }
+
+   // Novel profiles of out of core runs are drawn straight into the scratch
+   // file instead of extending the in memory matrix, those of binned runs
+   // are drawn for each bin once the sites are pooled
+   const bool out_of_core{!config.scratch_directory.empty() &&
+                          config.additional_cell_types > 0};
+   const bool binned_rows{Binning::isRequested(config)};
+   Processing::preprocessInputData(
+       bedmethyl,
+       reference_matrix_data,
+       cpg_list,
+       out_of_core || binned_rows ? 0 : config.additional_cell_types,
+       config.num_threads);
+   if (out_of_core) {
+      cpg_list = BedData::CpGData{};
+      return runOutOfCore(config,
+                          std::move(bedmethyl),
+                          std::move(reference_matrix_data));
+   }
+   Vector bulk_profile{};
+   Matrix reference_matrix{};
+   if (binned_rows) {
+      Binning::BinnedRows binned{
+          Binning::binRows(config,
+                           bedmethyl.records(),
+                           reference_matrix_data.getAsEigenMatrix())};
+      Binning::addMoreCellTypes(binned, config.additional_cell_types);
+      bulk_profile = std::move(binned.bulk_profile);
+      reference_matrix = std::move(binned.reference_matrix);
+   } else {
+      bulk_profile = bedmethyl.getAsEigenVector();
+      reference_matrix = reference_matrix_data.getAsEigenMatrix();
+   }
+
+   // ------------- //
+   // Deconvolution //
+   // ------------- //
+   Deconvolution::Deconvolver deconvolver{
+       static_cast<int>(reference_matrix.cols()), bulk_profile};
+   if (config.additional_cell_types == 0) {
+      deconvolver.runQpmad(reference_matrix);
       std::cout << "Deconvolution resulted in an objective function of: "
                 << deconvolver.evaluateObjectiveFunctionL2Norm(
                        reference_matrix)
                 << '\n';
-
-      // ------- //
-      // Outputs //
-      // ------- //
+      writeTracks(config,
+                  keysForTracks(config, reference_matrix_data.records()),
+                  reference_matrix,
+                  deconvolver.cellProportions(),
+                  bulk_profile);
       IO::writeMetrics(config, deconvolver);
+      return 0;
+   }
 
+   runHybridLoop(config, deconvolver, reference_matrix, bulk_profile);
+
+   // ------- //
+   // Outputs //
+   // ------- //
+   writeTracks(config,
+               keysForTracks(config, reference_matrix_data.records()),
+               reference_matrix,
+               deconvolver.cellProportions(),
+               bulk_profile);
+   IO::writeMetrics(config, deconvolver);
+
+   return 0;
+}
+
+/**
+ * Builds a sidecar offset index for the given file and writes it next to the
+ * file (see IO::SidecarIndex).
+ */
+auto runIndex(const CMD::HylordConfig& config) -> int {
+   const IO::SidecarIndex index{
+       IO::SidecarIndex::build(config.index_file, config.index_stride)};
+   index.write(config.index_file);
+   std::cout << "Wrote index with " << index.entries().size() << " entries to "
+             << IO::SidecarIndex::sidecarPath(config.index_file).string()
+             << '\n';
+   if (!index.isSorted()) {
+      std::cerr << "Warning: '" << config.index_file
+                << "' is not sorted. The index can still be used to split "
+                   "the file into chunks, but not to skip parts of it.\n";
+   }
+   return 0;
+}
+
+/**
+ * Assigns reads to cell types from modkit's per-read calls:
+ * 1. Builds the per-site log probability tables from the reference matrix
+ * 2. Streams the calls table in batches (see IO::TSVFileReader::stream),
+ *    holding back the last read of each batch as it may continue in the next
+ * 3. Scores the reads of each batch in parallel, writing their assignments
+ *    as it goes and tallying reads per cell type
+ * 4. Writes the aggregated counts (possibly to a file)
+ */
+auto runAssignReads(const CMD::HylordConfig& config) -> int {
+   const ReadAssignment::ReadAssigner assigner{
+       Processing::readReferenceMatrix(config.reference_matrix_file,
+                                       config.num_threads),
+       config.min_calls_per_read};
+   const std::vector<BedRecords::CellType> cell_type_list{
+       IO::generateCellTypeList(config, assigner.numberOfCellTypes())};
+
+   const auto assignments_path{
+       IO::resolveOutputPath(config.read_assignments_file)};
+   std::ofstream assignments_file(assignments_path);
+   if (!assignments_file) {
+      throw FileWriteException(assignments_path.string(),
+                               "Failed to open file for writing.");
+   }
+
+   std::vector<std::size_t> read_counts(assigner.numberOfCellTypes(), 0);
+   std::size_t unassigned_reads{};
+   auto assignBatch{[&](const std::vector<BedRecords::ReadCall>& calls) {
+      const auto assignments{assigner.assign(calls, config.num_threads)};
+      for (const auto& assignment : assignments) {
+         if (assignment.cell_type == ReadAssignment::Assignment::unassigned) {
+            ++unassigned_reads;
+         } else {
+            ++read_counts[static_cast<std::size_t>(assignment.cell_type)];
+         }
+      }
+      IO::writeReadAssignments(assignments_file, assignments, cell_type_list);
+   }};
+
+   IO::TSVFileReader<BedRecords::ReadCall> reader{
+       config.read_calls_file,
+       Processing::findModkitCallColumns(config.read_calls_file),
+       Filters::generateReadCallFilter(),
+       config.num_threads};
+   std::vector<BedRecords::ReadCall> unfinished_read{};
+   reader.stream(config.batch_size_mb * bytes_per_mb,
+                 [&](std::vector<BedRecords::ReadCall>&& batch) {
+                    if (!unfinished_read.empty()) {
+                       batch.insert(
+                           batch.begin(),
+                           std::make_move_iterator(unfinished_read.begin()),
+                           std::make_move_iterator(unfinished_read.end()));
+                    }
+                    unfinished_read = ReadAssignment::splitOffLastRead(batch);
+                    assignBatch(batch);
+                 });
+   assignBatch(unfinished_read);
+
+   if (!assignments_file) {
+      throw FileWriteException(assignments_path.string(),
+                               "Failed to write to file.");
+   }
+   IO::writeReadCounts(config, cell_type_list, read_counts, unassigned_reads);
+   return 0;
+}
+
+/**
+ * Streams each bedmethyl file, counting the methylation of the rows that
+ * pass the read depth filters as they are parsed (see
+ * IO::TSVFileReader::collectStatistics). The records themselves are
+ * dropped batch by batch, so memory is bounded by the batch size.
+ */
+auto runFitCdf(const CMD::HylordConfig& config) -> int {
+   const IO::RowFilter depth_filter{Filters::generateReadDepthFilter(config)};
+   IO::ParseStatistics statistics{};
+   for (const std::string& bedmethyl_file : config.cdf_bedmethyl_files) {
+      IO::TSVFileReader<BedRecords::Bed9Plus9> reader{bedmethyl_file,
+                                                      {0, 1, 2, 3, 4, 10},
+                                                      depth_filter,
+                                                      config.num_threads};
+      reader.collectStatistics(IO::CountedRows::kept);
+      reader.stream(config.batch_size_mb * bytes_per_mb,
+                    [](std::vector<BedRecords::Bed9Plus9>&&) {});
+      statistics.merge(reader.statistics());
+   }
+
+   std::vector<IO::MarkCDF> cdfs{};
+   for (const char mark : {'m', 'h'}) {
+      const auto histograms{std::ranges::find(
+          statistics.marks(), mark, &IO::MarkHistograms::mark)};
+      if (histograms == statistics.marks().end()) {
+         std::cerr << "Warning: No rows of mark '" << mark
+                   << "' passed the filters, so its CDF was not fitted.\n";
+         continue;
+      }
+      cdfs.emplace_back(mark, IO::fitCDF(*histograms, config.cdf_bins));
+   }
+   if (cdfs.empty()) {
+      throw PreprocessingException(
+          "Fit CDFs", "No rows of the bedmethyl files passed the filters.");
+   }
+   IO::writeCDFs(config, cdfs);
+   return 0;
+}
+}  // namespace
+
+/**
+ * Dispatches to the workflow requested on the command line, reporting any
+ * errors that occur.
+ */
+auto run(CMD::HylordConfig& config) -> int {
+   try {
+      if (!config.cdf_file.empty()) {
+         RNG::cdfs() = IO::readCDFs(config.cdf_file);
+      }
+      switch (config.command) {
+         case CMD::Command::index:
+            return runIndex(config);
+         case CMD::Command::assign_reads:
+            return runAssignReads(config);
+         case CMD::Command::batch:
+            return runBatch(config);
+         case CMD::Command::fit_cdf:
+            return runFitCdf(config);
+         case CMD::Command::deconvolve:
+            return runDeconvolution(config);
+      }
       return 0;
    } catch (const HylordException& e) {
       std::cerr << e.what() << '\n';
@@ -7,9 +7,14 @@
 
 #include "data/BedData.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
 #include "Eigen/Dense"
-#include "HylordException.hpp"
-#include "random/rng.hpp"
+#include "data/Sorting.hpp"
+#include "io/SharedReference.hpp"
 #include "types.hpp"
 
 namespace Hylord::BedData {
@@ -26,51 +31,64 @@ auto BedMethylData::getAsEigenVector() const -> Vector {
    return methylation_proportions;
 }
 
-/**
- * For each record in the matrix, appends new methylation proportion values
- * based on record type. Records with name 'm' get values from methylation_cdf,
- * others from hydroxymethylation_cdf.
- */
-void ReferenceMatrixData::addMoreCellTypes(int num_cell_types) {
-   for (auto& row : m_records) {
-      if (row.name == 'm') {
-         for (int i{}; i < num_cell_types; ++i) {
-            row.methylation_proportions.emplace_back(
-                RNG::getRandomValueFromCDF(RNG::methylation_cdf));
-         }
-      } else {
-         for (int i{}; i < num_cell_types; ++i) {
-            row.methylation_proportions.emplace_back(
-                RNG::getRandomValueFromCDF(RNG::hydroxymethylation_cdf));
-         }
-      }
+/// Rows are rebuilt from the keys of the segment, the proportions are read
+/// from it in place.
+ReferenceMatrixData::ReferenceMatrixData(
+    std::shared_ptr<const IO::SharedReference> shared) :
+    m_shared{std::move(shared)} {
+   const auto keys{m_shared->keys()};
+   m_records.reserve(keys.size());
+   for (const GenomicKey key : keys) {
+      m_records.push_back(BedRecords::Bed4{BedRecords::unpackKey(key)});
    }
 }
 
 /**
- * Constructs an Eigen matrix from the stored methylation proportions,
- * validating column consistency. Each row in the matrix corresponds to a
- * record's methylation proportions.
- * @throws PreprocessingException if records have inconsistent numbers of
- * methylation proportions.
+ * Gathers the given rows of the methylation proportions column by column
+ * (rows are contiguous within each column).
  */
-auto ReferenceMatrixData::getAsEigenMatrix() const -> Matrix {
-   const std::size_t rows = m_records.size();
-   const std::size_t cols = m_records[0].methylation_proportions.size();
-
-   for (const auto& record : m_records) {
-      if (record.methylation_proportions.size() != cols) {
-         throw PreprocessingException(
-             "Eigen Matrix Conversion",
-             "Inconsistent number of entries in reference matrix.");
+auto ReferenceMatrixData::gatherProportions(const RowIndexes& rows) const
+    -> Matrix {
+   const Eigen::Map<const Matrix> source{proportions()};
+   Matrix gathered(std::ssize(rows), source.cols());
+   for (Eigen::Index column{}; column < source.cols(); ++column) {
+      for (RowIndex i{}; i < std::ssize(rows); ++i) {
+         gathered(i, column) = source(rows[i], column);
       }
    }
-   Matrix reference_matrix(rows, cols);
-   for (RowIndex i{}; i < rows; ++i) {
-      reference_matrix.row(i) =
-          Eigen::Map<const Vector>(m_records[i].methylation_proportions.data(),
-                                   static_cast<Eigen::Index>(cols));
+   return gathered;
+}
+
+void ReferenceMatrixData::subsetRows(const RowIndexes& rows) {
+   subset(m_records, rows);
+   m_proportions = gatherProportions(rows);
+   m_shared.reset();
+}
+
+auto ReferenceMatrixData::gatherRows(const RowIndexes& rows) const
+    -> ReferenceMatrixData {
+   std::vector<BedRecords::Bed4> records{};
+   records.reserve(rows.size());
+   for (const RowIndex row : rows) {
+      records.push_back(m_records.at(static_cast<std::size_t>(row)));
    }
-   return reference_matrix;
+   return {std::move(records), gatherProportions(rows), m_sorted};
+}
+
+void ReferenceMatrixData::sortRows(int threads) {
+   subsetRows(Sorting::sortedPermutation(keysOf(m_records), threads));
+   m_sorted = true;
+}
+
+/**
+ * Appends new columns to the matrix. Rows with name 'm' get values from the
+ * methylation CDF, others from the hydroxymethylation CDF (see RNG::cdfs).
+ */
+void ReferenceMatrixData::addMoreCellTypes(int num_cell_types) {
+   if (num_cell_types <= 0) return;
+   assert(!m_shared);
+   m_proportions.conservativeResize(Eigen::NoChange,
+                                    m_proportions.cols() + num_cell_types);
+   drawNovelProfiles(m_records, m_proportions.rightCols(num_cell_types));
 }
 }  // namespace Hylord::BedData
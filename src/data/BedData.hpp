@@ -8,14 +8,21 @@
  * file in the repository root or https://mit-license.org)
  */
 
+#include <algorithm>
+#include <cassert>
+#include <memory>
 #include <numeric>
 #include <stdexcept>
-#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "Eigen/Dense"
 #include "concepts.hpp"
 #include "data/BedRecords.hpp"
+#include "data/CpGKeySet.hpp"
+#include "data/Sorting.hpp"
+#include "io/SharedReference.hpp"
+#include "random/rng.hpp"
 #include "types.hpp"
 
 /// Defines containers for holding data from bed files
@@ -42,21 +49,89 @@ void subset(Records::Collection<RecordType>& records, const RowIndexes& rows) {
    records = std::move(subset_records);
 }
 
-/// Container for CpG list data
+/// Checks whether records are in ascending (chromosome, start, name) order.
+template <Records::TSVRecord RecordType>
+   requires Records::GenomicRecord<RecordType>
+auto isSortedByKey(const Records::Collection<RecordType>& records) -> bool {
+   return std::ranges::is_sorted(
+       records, {}, [](const RecordType& record) { return record.key(); });
+}
+
+/// Gets the packed genomic key (see BedRecords::packKey) of each record.
+template <Records::TSVRecord RecordType>
+   requires Records::GenomicRecord<RecordType>
+auto keysOf(const Records::Collection<RecordType>& records) -> GenomicKeys {
+   GenomicKeys keys;
+   keys.reserve(records.size());
+   for (const auto& record : records) keys.push_back(record.key());
+   return keys;
+}
+
+/**
+ * Sorts records by their packed genomic key (see BedRecords::packKey) using a
+ * parallel radix sort. Records with equal keys keep their relative order.
+ */
+template <Records::TSVRecord RecordType>
+   requires Records::GenomicRecord<RecordType>
+void sortByKey(Records::Collection<RecordType>& records, int threads) {
+   subset(records, Sorting::sortedPermutation(keysOf(records), threads));
+}
+
+/**
+ * Fills every column of `profiles` (rows follow `records`) with plausible
+ * levels for novel cell types, drawn from the methylation or
+ * hydroxymethylation CDF (see RNG::cdfs) depending on each record's name.
+ * Columns are filled one at a time so that writes are contiguous.
+ */
+template <typename Records>
+void drawNovelProfiles(const Records& records, Eigen::Ref<Matrix> profiles) {
+   const RNG::CDFs& cdfs{RNG::cdfs()};
+   for (Eigen::Index col{}; col < profiles.cols(); ++col) {
+      double* column{profiles.col(col).data()};
+      for (const auto& record : records) {
+         *column++ = RNG::getRandomValueFromCDF(
+             record.name == 'm' ? cdfs.methylation : cdfs.hydroxymethylation);
+      }
+   }
+}
+
+/**
+ * Container for CpG list data. Only the keys of the sites are needed, so
+ * they are held compressed (see CpGKeySet) rather than as records.
+ */
 class CpGData {
   public:
    CpGData() = default;
-   CpGData(std::vector<BedRecords::Bed4> records) :
-       m_records{std::move(records)} {}
+   CpGData(const std::vector<BedRecords::Bed4>& records) :
+       m_keys{keysOf(records)} {}
+   /// The sorted flag is not needed (keys are sorted as they are added), it
+   /// is only taken so that readFile() can build the container.
+   CpGData(const std::vector<BedRecords::Bed4>& records,
+           [[maybe_unused]] bool sorted) :
+       m_keys{keysOf(records)} {}
+   explicit CpGData(CpGKeySet keys) : m_keys{std::move(keys)} {}
 
-   [[nodiscard]] auto records() const -> const std::vector<BedRecords::Bed4>& {
-      return m_records;
+   [[nodiscard]] auto keys() const -> const CpGKeySet& { return m_keys; }
+   [[nodiscard]] auto empty() const -> bool { return m_keys.empty(); }
+   /**
+    * Gets the range of keys covered by the CpG list on each chromosome.
+    * Readers can use these to skip the parts of other (indexed) files that
+    * can't overlap with the CpG list (see
+    * IO::TSVFileReader::limitToKeyRanges).
+    */
+   [[nodiscard]] auto keyRanges() const -> const IO::KeyRanges& {
+      return m_keys.keyRanges();
    }
-   [[nodiscard]] auto empty() const -> bool { return m_records.empty(); }
-   void subsetRows(const RowIndexes& rows) { subset(m_records, rows); };
 
   private:
-   std::vector<BedRecords::Bed4> m_records;
+   CpGKeySet m_keys;
+
+   static auto keysOf(const std::vector<BedRecords::Bed4>& records)
+       -> CpGKeySet {
+      CpGKeySet::Builder builder{};
+      for (const auto& record : records) builder.add(record.key());
+      return std::move(builder).build();
+   }
 };
 
 /// Container for bedmethyl data
@@ -64,52 +139,90 @@ class BedMethylData {
   public:
    BedMethylData() = default;
    BedMethylData(std::vector<BedRecords::Bed9Plus9> records) :
-       m_records{std::move(records)} {}
+       m_records{std::move(records)},
+       m_sorted{isSortedByKey(m_records)} {}
+   BedMethylData(std::vector<BedRecords::Bed9Plus9> records, bool sorted) :
+       m_records{std::move(records)},
+       m_sorted{sorted} {}
 
    [[nodiscard]] auto records() const
        -> const std::vector<BedRecords::Bed9Plus9>& {
       return m_records;
    }
    [[nodiscard]] auto empty() const -> bool { return m_records.empty(); }
+   [[nodiscard]] auto isSorted() const -> bool { return m_sorted; }
    void subsetRows(const RowIndexes& rows) { subset(m_records, rows); };
+   void sortRows(int threads) {
+      sortByKey(m_records, threads);
+      m_sorted = true;
+   }
    /// Converts methylation proportions from BED records into an Eigen vector.
    [[nodiscard]] auto getAsEigenVector() const -> Vector;
 
   private:
    std::vector<BedRecords::Bed9Plus9> m_records;
+   bool m_sorted{true};
 };
 
 /// Container for reference matrix data
 class ReferenceMatrixData {
   public:
    ReferenceMatrixData() = default;
-   ReferenceMatrixData(std::vector<BedRecords::Bed4PlusX> records) :
-       m_records{std::move(records)} {}
-   ReferenceMatrixData(const BedMethylData& bedmethyl) {
-      for (const auto& row : bedmethyl.records()) {
-         m_records.push_back(
-             BedRecords::Bed4PlusX{row.chromosome, row.start, row.name, {}});
-      }
-   }
-
+   ReferenceMatrixData(std::vector<BedRecords::Bed4> records,
+                       Matrix proportions) :
+       m_records{std::move(records)},
+       m_proportions{std::move(proportions)},
+       m_sorted{isSortedByKey(m_records)} {}
+   ReferenceMatrixData(std::vector<BedRecords::Bed4> records,
+                       Matrix proportions,
+                       bool sorted) :
+       m_records{std::move(records)},
+       m_proportions{std::move(proportions)},
+       m_sorted{sorted} {}
+   /// Uses a reference matrix published by another process in place (see
+   /// IO::SharedReference). The first subsetRows() copies out the kept rows.
+   explicit ReferenceMatrixData(
+       std::shared_ptr<const IO::SharedReference> shared);
    [[nodiscard]] auto records() const
-       -> const std::vector<BedRecords::Bed4PlusX>& {
+       -> const std::vector<BedRecords::Bed4>& {
       return m_records;
    }
    [[nodiscard]] auto empty() const -> bool { return m_records.empty(); }
-   void subsetRows(const RowIndexes& rows) { subset(m_records, rows); };
+   [[nodiscard]] auto isSorted() const -> bool { return m_sorted; }
+   /// Keeps only the given rows (in the given order) of records and matrix.
+   void subsetRows(const RowIndexes& rows);
+   /// Copies out the given rows (in the given order), leaving this alone.
+   [[nodiscard]] auto gatherRows(const RowIndexes& rows) const
+       -> ReferenceMatrixData;
+   void sortRows(int threads);
    /// Adds additional cell types to the reference matrix with randomized
    /// methylation/hydroxymethylation values.
    void addMoreCellTypes(int num_cell_types);
    [[nodiscard]] auto numberOfCellTypes() const -> int {
-      return static_cast<int>(
-          std::ssize(m_records[0].methylation_proportions));
+      return static_cast<int>(proportions().cols());
+   }
+   /// The reference matrix itself (rows follow records()). Shared matrices
+   /// have to be subset first.
+   [[nodiscard]] auto getAsEigenMatrix() const -> const Matrix& {
+      assert(!m_shared);
+      return m_proportions;
    }
-   /// Converts the reference matrix data into an Eigen matrix format.
-   [[nodiscard]] auto getAsEigenMatrix() const -> Matrix;
 
   private:
-   std::vector<BedRecords::Bed4PlusX> m_records;
+   std::vector<BedRecords::Bed4> m_records;
+   Matrix m_proportions;
+   std::shared_ptr<const IO::SharedReference> m_shared;
+   bool m_sorted{true};
+
+   [[nodiscard]] auto gatherProportions(const RowIndexes& rows) const
+       -> Matrix;
+   /// The shared matrix if there is one, otherwise the owned matrix.
+   [[nodiscard]] auto proportions() const -> Eigen::Map<const Matrix> {
+      if (m_shared) return m_shared->matrix();
+      return {m_proportions.data(),
+              m_proportions.rows(),
+              m_proportions.cols()};
+   }
 };
 
 /**
@@ -118,7 +231,8 @@ class ReferenceMatrixData {
  *
  * Compares two BED files (assumed to be sorted) and returns pairs of indexes
  * where records match. Records are considered matching if their chromosome,
- * start position, and name fields are equal.
+ * start position, and name fields are equal. Unsorted collections must be
+ * sorted first (see sortByKey), otherwise most matches are silently missed.
  */
 template <typename BedTypeOne, typename BedTypeTwo>
 auto findOverLappingIndexes(const BedTypeOne& bed_one,
@@ -138,12 +252,8 @@ auto findOverLappingIndexes(const BedTypeOne& bed_one,
    // expected to be sorted (modkit will do this). So to find the indexes where
    // the two bed files overlap, we take a two pointer approach.
    while (bed_one_row < bed_one.size() && bed_two_row < bed_two.size()) {
-      auto bed_one_key{std::tie(bed_one[bed_one_row].chromosome,
-                                bed_one[bed_one_row].start,
-                                bed_one[bed_one_row].name)};
-      auto bed_two_key{std::tie(bed_two[bed_two_row].chromosome,
-                                bed_two[bed_two_row].start,
-                                bed_two[bed_two_row].name)};
+      const GenomicKey bed_one_key{bed_one[bed_one_row].key()};
+      const GenomicKey bed_two_key{bed_two[bed_two_row].key()};
 
       if (bed_one_key == bed_two_key) {
          bed_one_overlapping_indexes.push_back(bed_one_row);
@@ -160,41 +270,31 @@ auto findOverLappingIndexes(const BedTypeOne& bed_one,
 }
 
 /**
- * Finds indexes of BED entries that match records in a CpG list using binary
- * search.
+ * Finds indexes of BED entries that match records in a CpG list.
  *
  * Searches for BED entries that match CpG records by chromosome, start
- * position, and name.
+ * position, and name. The BED entries are assumed to be sorted, so they are
+ * checked with a single cursor over the CpG list (see CpGKeySet::Cursor) and
+ * the returned indexes are ascending.
  * @throws std::runtime_error if no overlapping records are found between the
  * CpG list and BED entries.
  */
 template <typename Records>
 auto findIndexesInCpGList(const BedData::CpGData& cpg_list,
                           const Records& bed_entries) -> RowIndexes {
-   const std::vector<BedRecords::Bed4>& cpgs{cpg_list.records()};
+   CpGKeySet::Cursor cpgs{cpg_list.keys()};
    RowIndexes bed_indexes_in_cpg_list{};
-   bed_indexes_in_cpg_list.reserve(cpgs.size());
-
-   for (RowIndex cpg{}; cpg < cpgs.size(); ++cpg) {
-      auto cpg_key{
-          std::tie(cpgs[cpg].chromosome, cpgs[cpg].start, cpgs[cpg].name)};
-      RowIndex low{};
-      RowIndex high{static_cast<RowIndex>(bed_entries.size() - 1)};
-      while (low <= high) {
-         RowIndex mid{std::midpoint(low, high)};
-         auto row_key{std::tie(bed_entries[mid].chromosome,
-                               bed_entries[mid].start,
-                               bed_entries[mid].name)};
-         if (row_key == cpg_key) {
-            bed_indexes_in_cpg_list.push_back(mid);
-            break;
-         }
-         if (row_key < cpg_key) {
-            low = mid + 1;
-         } else {
-            high = mid - 1;
-         }
+   bed_indexes_in_cpg_list.reserve(
+       std::min(cpg_list.keys().size(), bed_entries.size()));
+
+   for (RowIndex row{}; row < bed_entries.size(); ++row) {
+      const GenomicKey row_key{bed_entries[row].key()};
+      // Only the first of rows sharing a key is kept
+      if (!bed_indexes_in_cpg_list.empty() &&
+          bed_entries[bed_indexes_in_cpg_list.back()].key() == row_key) {
+         continue;
       }
+      if (cpgs.contains(row_key)) bed_indexes_in_cpg_list.push_back(row);
    }
    if (bed_indexes_in_cpg_list.empty())
       throw std::runtime_error("No row overlap with cpg_list.");
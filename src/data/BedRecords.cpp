@@ -45,6 +45,19 @@ auto parseChromosomeNumber(const std::string_view chr) -> int {
                             std::string(chr));
 }
 
+auto chromosomeName(int chromosome) -> std::string {
+   switch (chromosome) {
+      case 23:
+         return "chrX";
+      case 24:
+         return "chrY";
+      case 25:
+         return "chrM";
+      default:
+         return "chr" + std::to_string(chromosome);
+   }
+}
+
 /**
  * Checks if the number of fields is at least the specified minimum expected.
  *
@@ -8,6 +8,7 @@
  * file in the repository root or https://mit-license.org)
  */
 #include <cctype>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -16,21 +17,61 @@
 #include "maths/percentage.hpp"
 #include "types.hpp"
 
-/// Parsers for BED genomic data formats (BED4, BED4+, BED9+9)
+/// Parsers for BED genomic data formats (BED4, BED4+, BED9+9, bedGraph)
 namespace Hylord::BedRecords {
 /// Parses a chromosome string into its numeric representation.
 auto parseChromosomeNumber(std::string_view chr) -> int;
 
+/// Reverses parseChromosomeNumber, giving "chr1", ..., "chrX", "chrY", "chrM".
+auto chromosomeName(int chromosome) -> std::string;
+
 /// Validates that a Fields container meets minimum field count
 /// requirements.
 void validateFields(const Fields& fields, int min_expected_fields);
 
+/// Bit layout of packed genomic keys (see packKey)
+namespace KeyLayout {
+inline constexpr std::uint32_t chromosome_mask{0xFFFFFFU};
+inline constexpr unsigned chromosome_shift{40U};
+inline constexpr unsigned start_shift{8U};
+inline constexpr GenomicKey start_mask{0xFFFFFFFFU};
+inline constexpr GenomicKey name_mask{0xFFU};
+}  // namespace KeyLayout
+
+/**
+ * Packs the (chromosome, start, name) triple of a BED record into a single
+ * integer.
+ *
+ * Comparing two packed keys gives the same ordering as comparing the triples
+ * lexicographically, so joins and sorts can work on plain integers. The layout
+ * (most to least significant) is 24 bits of chromosome, 32 bits of start
+ * position and 8 bits of name.
+ */
+constexpr auto packKey(int chromosome, int start, char name) -> GenomicKey {
+   return (static_cast<GenomicKey>(static_cast<std::uint32_t>(chromosome) &
+                                   KeyLayout::chromosome_mask)
+           << KeyLayout::chromosome_shift) |
+          (static_cast<GenomicKey>(static_cast<std::uint32_t>(start))
+           << KeyLayout::start_shift) |
+          static_cast<GenomicKey>(static_cast<unsigned char>(name));
+}
+
+/// Extracts the chromosome number from a packed key.
+constexpr auto chromosomeOfKey(GenomicKey key) -> int {
+   return static_cast<int>(key >> KeyLayout::chromosome_shift);
+}
+
 /// Core BED fields shared by all variants
 struct Bed {
    int chromosome{1};
    int start{};
    char name{};  // expected m or h
 
+   /// Packed (chromosome, start, name) key used for sorting and joining.
+   [[nodiscard]] constexpr auto key() const -> GenomicKey {
+      return packKey(chromosome, start, name);
+   }
+
    /**
     * Parses core BED fields (chromosome, start position, and name) from
     * a given fields container.
@@ -49,6 +90,15 @@ struct Bed {
    }
 };
 
+/// Reverses packKey, giving the core BED fields of a packed key.
+constexpr auto unpackKey(GenomicKey key) -> Bed {
+   return Bed{
+       .chromosome = chromosomeOfKey(key),
+       .start = static_cast<int>((key >> KeyLayout::start_shift) &
+                                 KeyLayout::start_mask),
+       .name = static_cast<char>(key & KeyLayout::name_mask)};
+}
+
 /// Standard BED4 format (chrom, start, end, name)
 struct Bed4 : public Bed {
    static auto fromFields(const Fields& fields) -> Bed4 {
@@ -58,6 +108,25 @@ struct Bed4 : public Bed {
    }
 };
 
+/// BED3+ genomic region (chrom, start, end), e.g. a CpG island. Regions are
+/// half open and have no name.
+struct Region : public Bed {
+   int end{};
+
+   /**
+    * @throws std::out_of_range if fields container has fewer than 3 elements.
+    * @throws std::invalid_argument if a position can't be converted
+    */
+   static auto fromFields(const Fields& fields) -> Region {
+      validateFields(fields, 3);
+      Region parsed_row{};
+      parsed_row.chromosome = parseChromosomeNumber(fields[0]);
+      parsed_row.start = std::stoi(fields[1]);
+      parsed_row.end = std::stoi(fields[2]);
+      return parsed_row;
+   }
+};
+
 /// BED4+ with variable-length methylation percentages (reference matrix)
 struct Bed4PlusX : public Bed {
    std::vector<double> methylation_proportions;
@@ -77,6 +146,7 @@ struct Bed4PlusX : public Bed {
       validateFields(fields, 5);
       Bed4PlusX parsed_row{};
       parseCoreFields(parsed_row, fields);
+      parsed_row.methylation_proportions.reserve(fields.size() - 4);
       for (std::size_t i{4}; i < fields.size(); ++i) {
          parsed_row.methylation_proportions.emplace_back(
              Maths::convertToProportion(std::stod(fields[i])));
@@ -85,8 +155,11 @@ struct Bed4PlusX : public Bed {
    }
 };
 
-/// BED9+9 format (uses first methylation value only)
+/// BED9+9 format (uses the read depth and first methylation value only)
 struct Bed9Plus9 : public Bed {
+   /// Score field (valid coverage in modkit's output). Kept so filters on
+   /// the read depth can be applied after parsing (see Sweep).
+   int read_depth{};
    double methylation_proportion{};
 
    /**
@@ -102,12 +175,78 @@ struct Bed9Plus9 : public Bed {
       validateFields(fields, 6);
       Bed9Plus9 parsed_row{};
       parseCoreFields(parsed_row, fields);
+      parsed_row.read_depth = std::stoi(fields[4]);
       parsed_row.methylation_proportion =
           Maths::convertToProportion(std::stod(fields[5]));
       return parsed_row;
    }
 };
 
+/**
+ * bedGraph row written by `modkit pileup --bedgraph` (chrom, start, end,
+ * fraction modified, valid coverage). Each file holds a single mark, so the
+ * name is only known once the record is tagged with the mark of its file
+ * (see tag()).
+ */
+struct BedGraph : public Bed {
+   int read_depth{};
+   double methylation_proportion{};
+
+   /**
+    * Constructs a BedGraph record from TSV fields. The fraction modified is
+    * already a proportion.
+    * @throws std::invalid_argument if field validation fails
+    * @throws std::out_of_range if string conversion fails
+    */
+   static auto fromFields(const Fields& fields) -> BedGraph {
+      validateFields(fields, 5);
+      BedGraph parsed_row{};
+      parsed_row.chromosome = parseChromosomeNumber(fields[0]);
+      parsed_row.start = std::stoi(fields[1]);
+      parsed_row.methylation_proportion = std::stod(fields[3]);
+      parsed_row.read_depth = std::stoi(fields[4]);
+      return parsed_row;
+   }
+
+   /// The row as a bedmethyl row of the given mark ('m' or 'h').
+   [[nodiscard]] auto tag(char mark) const -> Bed9Plus9 {
+      Bed9Plus9 row{};
+      row.chromosome = chromosome;
+      row.start = start;
+      row.name = mark;
+      row.read_depth = read_depth;
+      row.methylation_proportion = methylation_proportion;
+      return row;
+   }
+};
+
+/**
+ * A single modification call on a read (row of a `modkit extract calls`
+ * table). Expects the fields read_id, chrom, ref_position, ref_strand and
+ * call_code in this order (see IO::findModkitCallColumns). The call code is
+ * stored as the name ('m', 'h' or '-' for canonical).
+ */
+struct ReadCall : public Bed {
+   std::string read_id;
+   char strand{'+'};
+
+   /**
+    * Constructs a ReadCall from (reordered) modkit extract fields.
+    * @throws std::invalid_argument if field validation fails
+    * @throws std::out_of_range if the position can't be converted
+    */
+   static auto fromFields(const Fields& fields) -> ReadCall {
+      validateFields(fields, 5);
+      ReadCall parsed_row{};
+      parsed_row.read_id = fields[0];
+      parsed_row.chromosome = parseChromosomeNumber(fields[1]);
+      parsed_row.start = std::stoi(fields[2]);
+      parsed_row.strand = fields[3].empty() ? '+' : fields[3][0];
+      parsed_row.name = fields[4].empty() ? '-' : fields[4][0];
+      return parsed_row;
+   }
+};
+
 /// Newline separated list of cell types
 struct CellType {
    std::string cell_type;
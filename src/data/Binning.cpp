@@ -0,0 +1,179 @@
+/**
+ * @file    Binning.cpp
+ * @brief   Defines pooling of joined CpG sites into genomic bins.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "data/Binning.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "HylordException.hpp"
+#include "cli.hpp"
+#include "data/BedData.hpp"
+#include "data/BedRecords.hpp"
+#include "io/TSVFileReader.hpp"
+#include "parallel/ParallelFor.hpp"
+#include "types.hpp"
+
+namespace Hylord::Binning {
+namespace {
+/// Reads the regions to bin on, sorting them if needed.
+auto readRegions(const CMD::HylordConfig& config)
+    -> std::vector<BedRecords::Region> {
+   IO::TSVFileReader<BedRecords::Region> reader{
+       config.bin_regions_file, {}, nullptr, config.num_threads};
+   reader.load();
+   const bool sorted{reader.isSorted()};
+   std::vector<BedRecords::Region> regions{reader.extractRecords()};
+   if (!sorted) BedData::sortByKey(regions, config.num_threads);
+   return regions;
+}
+}  // namespace
+
+auto isRequested(const CMD::HylordConfig& config) -> bool {
+   return config.bin_size > 0 || !config.bin_regions_file.empty();
+}
+
+auto fixedBins(std::span<const BedRecords::Bed9Plus9> rows, int bin_size)
+    -> BinIndexes {
+   constexpr unsigned chromosome_shift{32U};
+   BinIndexes bins{};
+   bins.reserve(rows.size());
+   for (const auto& row : rows) {
+      bins.push_back(
+          (static_cast<std::int64_t>(row.chromosome) << chromosome_shift) |
+          (row.start / bin_size));
+   }
+   return bins;
+}
+
+/// Rows and regions are merged with two pointers, so this is a single pass
+/// over each.
+auto regionBins(std::span<const BedRecords::Bed9Plus9> rows,
+                std::span<const BedRecords::Region> regions) -> BinIndexes {
+   BinIndexes bins(rows.size(), no_bin);
+   std::size_t region{};
+   for (std::size_t i{}; i < rows.size(); ++i) {
+      const auto& row{rows[i]};
+      while (region < regions.size() &&
+             (regions[region].chromosome < row.chromosome ||
+              (regions[region].chromosome == row.chromosome &&
+               regions[region].end <= row.start))) {
+         ++region;
+      }
+      if (region < regions.size() &&
+          regions[region].chromosome == row.chromosome &&
+          regions[region].start <= row.start) {
+         bins[i] = static_cast<std::int64_t>(region);
+      }
+   }
+   return bins;
+}
+
+/**
+ * Rows are given the output row (group) of their bin and signal in a single
+ * pass, relying on the bins of sorted rows never decreasing. Bins whose rows
+ * have no read depth (only kept with --min-read-depth 0) fall back to the
+ * mean of their bulk values. The reference matrix is then pooled a column at
+ * a time, with blocks of columns in parallel.
+ */
+auto pool(std::span<const BedRecords::Bed9Plus9> rows,
+          Eigen::Ref<const Matrix> reference_matrix,
+          const BinIndexes& bins,
+          int threads) -> BinnedRows {
+   std::vector<Eigen::Index> groups(rows.size(), -1);
+   Eigen::Index num_groups{};
+   std::int64_t current_bin{no_bin};
+   std::array<Eigen::Index, 2> signal_groups{-1, -1};
+   std::vector<BedRecords::Bed4> group_rows{};
+   for (std::size_t i{}; i < rows.size(); ++i) {
+      if (bins[i] == no_bin) continue;
+      if (bins[i] != current_bin) {
+         current_bin = bins[i];
+         signal_groups = {-1, -1};
+      }
+      Eigen::Index& group{signal_groups[rows[i].name == 'h' ? 1 : 0]};
+      if (group < 0) {
+         group = num_groups++;
+         group_rows.push_back(
+             BedRecords::Bed4{BedRecords::unpackKey(rows[i].key())});
+      }
+      groups[i] = group;
+   }
+   if (num_groups == 0) {
+      throw PreprocessingException(
+          "Bin CpG Sites",
+          "None of the CpG sites shared by the reference matrix and bedmethyl "
+          "file fall in a bin.");
+   }
+
+   Vector weighted_sums{Vector::Zero(num_groups)};
+   Vector read_depths{Vector::Zero(num_groups)};
+   Vector sums{Vector::Zero(num_groups)};
+   Vector counts{Vector::Zero(num_groups)};
+   for (std::size_t i{}; i < rows.size(); ++i) {
+      const Eigen::Index group{groups[i]};
+      if (group < 0) continue;
+      const double read_depth{static_cast<double>(rows[i].read_depth)};
+      weighted_sums(group) += read_depth * rows[i].methylation_proportion;
+      read_depths(group) += read_depth;
+      sums(group) += rows[i].methylation_proportion;
+      counts(group) += 1;
+   }
+   BinnedRows binned{
+       .reference_matrix = Matrix::Zero(num_groups, reference_matrix.cols()),
+       .bulk_profile = (read_depths.array() > 0)
+                           .select(weighted_sums.array() / read_depths.array(),
+                                   sums.array() / counts.array()),
+       .rows = std::move(group_rows)};
+
+   Parallel::forEachBlock(
+       static_cast<std::size_t>(reference_matrix.cols()),
+       threads,
+       [&](const Parallel::Block& block) {
+          for (auto col{static_cast<Eigen::Index>(block.begin)};
+               col < static_cast<Eigen::Index>(block.end);
+               ++col) {
+             const double* reference_column{reference_matrix.col(col).data()};
+             double* pooled_column{binned.reference_matrix.col(col).data()};
+             for (std::size_t i{}; i < rows.size(); ++i) {
+                if (groups[i] >= 0) {
+                   pooled_column[groups[i]] += reference_column[i];
+                }
+             }
+             binned.reference_matrix.col(col).array() /= counts.array();
+          }
+       });
+   return binned;
+}
+
+auto binRows(const CMD::HylordConfig& config,
+             std::span<const BedRecords::Bed9Plus9> rows,
+             Eigen::Ref<const Matrix> reference_matrix) -> BinnedRows {
+   const BinIndexes bins{config.bin_regions_file.empty()
+                             ? fixedBins(rows, config.bin_size)
+                             : regionBins(rows, readRegions(config))};
+   BinnedRows binned{
+       pool(rows, reference_matrix, bins, config.num_threads)};
+   std::cout << "Pooled " << rows.size() << " CpG sites into "
+             << binned.bulk_profile.size() << " bins.\n";
+   return binned;
+}
+
+void addMoreCellTypes(BinnedRows& binned, int num_cell_types) {
+   if (num_cell_types <= 0) return;
+   Matrix& reference_matrix{binned.reference_matrix};
+   reference_matrix.conservativeResize(
+       Eigen::NoChange, reference_matrix.cols() + num_cell_types);
+   BedData::drawNovelProfiles(binned.rows,
+                              reference_matrix.rightCols(num_cell_types));
+}
+}  // namespace Hylord::Binning
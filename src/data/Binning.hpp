@@ -0,0 +1,84 @@
+#ifndef BINNING_H_
+#define BINNING_H_
+
+/**
+ * @file    Binning.hpp
+ * @brief   Declares pooling of joined CpG sites into genomic bins.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "cli.hpp"
+#include "data/BedRecords.hpp"
+#include "types.hpp"
+
+/**
+ * Pooling of CpG sites into genomic bins (fixed size windows or regions such
+ * as CpG islands), for samples with too little coverage to filter on read
+ * depth. Sites of a bin with the same signal (m or h) become a single row.
+ */
+namespace Hylord::Binning {
+/// Bin of each row (see fixedBins() and regionBins()).
+using BinIndexes = std::vector<std::int64_t>;
+
+/// Bin of a row that isn't pooled (dropped).
+inline constexpr std::int64_t no_bin{-1};
+
+/// Rows of the deconvolution after pooling.
+struct BinnedRows {
+   Matrix reference_matrix;
+   Vector bulk_profile;
+   /// The first site pooled into each row, giving the row's signal
+   std::vector<BedRecords::Bed4> rows;
+};
+
+/// Whether --bin-size or --bin-regions was given.
+auto isRequested(const CMD::HylordConfig& config) -> bool;
+
+/// Splits each chromosome into bins of `bin_size` bases (rows are expected
+/// to be sorted).
+auto fixedBins(std::span<const BedRecords::Bed9Plus9> rows, int bin_size)
+    -> BinIndexes;
+
+/**
+ * Places each row in the region containing it (the index into `regions`),
+ * or no_bin if there is none. Both rows and regions are expected to be
+ * sorted, and regions shouldn't overlap.
+ */
+auto regionBins(std::span<const BedRecords::Bed9Plus9> rows,
+                std::span<const BedRecords::Region> regions) -> BinIndexes;
+
+/**
+ * Pools the rows of each bin, keeping the two signals apart. Bulk values are
+ * weighted by read depth and reference values are averaged.
+ *
+ * @throws PreprocessingException if no row is in a bin.
+ */
+auto pool(std::span<const BedRecords::Bed9Plus9> rows,
+          Eigen::Ref<const Matrix> reference_matrix,
+          const BinIndexes& bins,
+          int threads) -> BinnedRows;
+
+/**
+ * Pools the joined rows as set by the config (reading the regions file if
+ * given).
+ *
+ * @throws PreprocessingException if no row is in a bin.
+ */
+auto binRows(const CMD::HylordConfig& config,
+             std::span<const BedRecords::Bed9Plus9> rows,
+             Eigen::Ref<const Matrix> reference_matrix) -> BinnedRows;
+
+/**
+ * Adds novel cell types to the pooled reference matrix, drawn for each row
+ * (see BedData::drawNovelProfiles()). Drawing them for every site before
+ * pooling would average the draws, leaving novel profiles nearly constant.
+ */
+void addMoreCellTypes(BinnedRows& binned, int num_cell_types);
+}  // namespace Hylord::Binning
+
+#endif
@@ -0,0 +1,275 @@
+/**
+ * @file    CpGKeySet.cpp
+ * @brief   Defines a compressed set of packed genomic keys, used to hold
+ * (genome wide) CpG lists.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "data/CpGKeySet.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "data/BedRecords.hpp"
+#include "types.hpp"
+
+namespace Hylord::BedData {
+namespace {
+constexpr GenomicKey site_mask{~BedRecords::KeyLayout::name_mask};
+constexpr std::uint32_t sites_per_word{32};
+constexpr std::uint8_t gap_continues{0x80U};
+constexpr std::uint8_t gap_bits{0x7FU};
+constexpr unsigned bits_per_gap_byte{7};
+
+auto nameOf(GenomicKey key) -> char {
+   return static_cast<char>(key & BedRecords::KeyLayout::name_mask);
+}
+
+auto isMark(char name) -> bool { return name == 'm' || name == 'h'; }
+
+/// Bit of the mark of the site (see CpGKeySet::m_marks).
+auto markBit(std::uint32_t site_index, char name) -> std::uint64_t {
+   return std::uint64_t{1}
+          << ((2 * (site_index % sites_per_word)) + (name == 'm' ? 0 : 1));
+}
+}  // namespace
+
+void CpGKeySet::Builder::add(GenomicKey key) {
+   if (m_sorted) {
+      const IO::KeyRanges& ranges{m_set.m_key_ranges};
+      if (ranges.empty() || key >= ranges.back().last) {
+         m_set.append(key);
+         return;
+      }
+      m_sorted = false;
+      m_unsorted_keys = m_set.keys();
+      m_set = CpGKeySet{};
+   }
+   m_unsorted_keys.push_back(key);
+}
+
+auto CpGKeySet::Builder::build() && -> CpGKeySet {
+   if (!m_sorted) {
+      std::ranges::sort(m_unsorted_keys);
+      for (const GenomicKey key : m_unsorted_keys) m_set.append(key);
+      m_unsorted_keys = GenomicKeys{};
+   }
+   m_set.shrinkToFit();
+   return std::move(m_set);
+}
+
+CpGKeySet::CpGKeySet(const GenomicKeys& keys) {
+   Builder builder{};
+   for (const GenomicKey key : keys) builder.add(key);
+   *this = std::move(builder).build();
+}
+
+/**
+ * A site starts a new block if the current one is full or on another
+ * chromosome, so gaps are always between starts on one chromosome.
+ * @throws std::length_error if the set outgrows its 32 bit offsets
+ */
+void CpGKeySet::append(GenomicKey key) {
+   const int chromosome{BedRecords::chromosomeOfKey(key)};
+   if (m_key_ranges.empty() ||
+       BedRecords::chromosomeOfKey(m_key_ranges.back().last) != chromosome) {
+      m_key_ranges.push_back({.first = key, .last = key});
+   } else {
+      m_key_ranges.back().last = key;
+   }
+
+   const char name{nameOf(key)};
+   if (!isMark(name)) {
+      if (m_other_keys.empty() || m_other_keys.back() != key) {
+         m_other_keys.push_back(key);
+         ++m_size;
+      }
+      return;
+   }
+
+   const GenomicKey site{key & site_mask};
+   if (m_sites == 0 || site != m_last_site) {
+      if (m_sites == std::numeric_limits<std::uint32_t>::max() ||
+          m_gaps.size() >= std::numeric_limits<std::uint32_t>::max()) {
+         throw std::length_error("CpG list has too many sites.");
+      }
+      if (m_sites == 0 ||
+          m_sites - m_blocks.back().first_site_index == block_size ||
+          BedRecords::chromosomeOfKey(m_last_site) != chromosome) {
+         m_blocks.push_back(
+             {.first_site = site,
+              .gap_offset = static_cast<std::uint32_t>(m_gaps.size()),
+              .first_site_index = m_sites});
+      } else {
+         GenomicKey gap{(site - m_last_site) >>
+                        BedRecords::KeyLayout::start_shift};
+         while (gap > gap_bits) {
+            m_gaps.push_back(static_cast<std::uint8_t>((gap & gap_bits) |
+                                                       gap_continues));
+            gap >>= bits_per_gap_byte;
+         }
+         m_gaps.push_back(static_cast<std::uint8_t>(gap));
+      }
+      if (m_sites % sites_per_word == 0) m_marks.push_back(0);
+      ++m_sites;
+      m_last_site = site;
+   }
+
+   const std::uint32_t site_index{m_sites - 1};
+   std::uint64_t& word{m_marks[site_index / sites_per_word]};
+   const std::uint64_t bit{markBit(site_index, name)};
+   if ((word & bit) == 0) {
+      word |= bit;
+      ++m_size;
+   }
+}
+
+void CpGKeySet::shrinkToFit() {
+   m_blocks.shrink_to_fit();
+   m_gaps.shrink_to_fit();
+   m_marks.shrink_to_fit();
+   m_other_keys.shrink_to_fit();
+   m_key_ranges.shrink_to_fit();
+}
+
+auto CpGKeySet::hasMark(std::uint32_t site_index, GenomicKey key) const
+    -> bool {
+   return (m_marks[site_index / sites_per_word] &
+           markBit(site_index, nameOf(key))) != 0;
+}
+
+auto CpGKeySet::blockEnd(std::size_t block) const -> std::uint32_t {
+   return block + 1 < m_blocks.size() ? m_blocks[block + 1].first_site_index
+                                      : m_sites;
+}
+
+auto CpGKeySet::readGap(std::uint32_t& offset) const -> GenomicKey {
+   GenomicKey gap{};
+   unsigned shift{};
+   while (true) {
+      const std::uint8_t byte{m_gaps[offset++]};
+      gap |= static_cast<GenomicKey>(byte & gap_bits) << shift;
+      if ((byte & gap_continues) == 0) break;
+      shift += bits_per_gap_byte;
+   }
+   return gap << BedRecords::KeyLayout::start_shift;
+}
+
+auto CpGKeySet::contains(GenomicKey key) const -> bool {
+   if (!isMark(nameOf(key))) {
+      return std::ranges::binary_search(m_other_keys, key);
+   }
+   const GenomicKey site{key & site_mask};
+   const auto next_block{
+       std::ranges::upper_bound(m_blocks, site, {}, &Block::first_site)};
+   if (next_block == m_blocks.begin()) return false;
+   const auto block{static_cast<std::size_t>(
+       std::distance(m_blocks.begin(), next_block) - 1)};
+
+   GenomicKey current{m_blocks[block].first_site};
+   std::uint32_t site_index{m_blocks[block].first_site_index};
+   std::uint32_t offset{m_blocks[block].gap_offset};
+   const std::uint32_t end{blockEnd(block)};
+   while (current < site && ++site_index < end) current += readGap(offset);
+   return current == site && hasMark(site_index, key);
+}
+
+auto CpGKeySet::keys() const -> GenomicKeys {
+   GenomicKeys keys{};
+   keys.reserve(m_size);
+   for (std::size_t block{}; block < m_blocks.size(); ++block) {
+      GenomicKey site{m_blocks[block].first_site};
+      std::uint32_t offset{m_blocks[block].gap_offset};
+      const std::uint32_t end{blockEnd(block)};
+      for (std::uint32_t site_index{m_blocks[block].first_site_index};
+           site_index < end;
+           ++site_index) {
+         if (site_index != m_blocks[block].first_site_index) {
+            site += readGap(offset);
+         }
+         // 'h' sorts before 'm'
+         for (const char name : {'h', 'm'}) {
+            const GenomicKey key{site | static_cast<unsigned char>(name)};
+            if (hasMark(site_index, key)) keys.push_back(key);
+         }
+      }
+   }
+   const auto marked_keys{std::ssize(keys)};
+   keys.insert(keys.end(), m_other_keys.begin(), m_other_keys.end());
+   std::ranges::inplace_merge(keys, keys.begin() + marked_keys);
+   return keys;
+}
+
+auto CpGKeySet::memoryUsage() const -> std::size_t {
+   return sizeof(*this) + (m_blocks.capacity() * sizeof(Block)) +
+          m_gaps.capacity() +
+          (m_marks.capacity() * sizeof(std::uint64_t)) +
+          (m_other_keys.capacity() * sizeof(GenomicKey)) +
+          (m_key_ranges.capacity() * sizeof(IO::KeyRange));
+}
+
+CpGKeySet::Cursor::Cursor(const CpGKeySet& set) : m_set{&set} {
+   if (set.m_blocks.empty()) {
+      m_site = std::numeric_limits<GenomicKey>::max();
+   } else {
+      startBlock(0);
+   }
+}
+
+void CpGKeySet::Cursor::startBlock(std::size_t block) {
+   const Block& start{m_set->m_blocks[block]};
+   m_block = block;
+   m_site = start.first_site;
+   m_site_index = start.first_site_index;
+   m_gap_offset = start.gap_offset;
+}
+
+/**
+ * Moves to the first site no smaller than the given one. Blocks starting at
+ * or before it are skipped with a binary search over their first sites, the
+ * rest of the way is decoded.
+ */
+void CpGKeySet::Cursor::seek(GenomicKey site) {
+   const std::vector<Block>& blocks{m_set->m_blocks};
+   if (m_block + 1 < blocks.size() && blocks[m_block + 1].first_site <= site) {
+      const auto next_block{std::upper_bound(
+          blocks.begin() + static_cast<std::ptrdiff_t>(m_block) + 1,
+          blocks.end(),
+          site,
+          [](GenomicKey target, const Block& block) {
+             return target < block.first_site;
+          })};
+      startBlock(static_cast<std::size_t>(
+          std::distance(blocks.begin(), next_block) - 1));
+   }
+   const std::uint32_t end{m_set->blockEnd(m_block)};
+   while (m_site < site) {
+      if (m_site_index + 1 == end) {
+         // The next block starts after the site
+         if (m_block + 1 < blocks.size()) {
+            startBlock(m_block + 1);
+         } else {
+            m_site = std::numeric_limits<GenomicKey>::max();
+         }
+         return;
+      }
+      ++m_site_index;
+      m_site += m_set->readGap(m_gap_offset);
+   }
+}
+
+auto CpGKeySet::Cursor::contains(GenomicKey key) -> bool {
+   if (!isMark(nameOf(key))) {
+      return std::ranges::binary_search(m_set->m_other_keys, key);
+   }
+   const GenomicKey site{key & site_mask};
+   if (m_site < site) seek(site);
+   return m_site == site && m_set->hasMark(m_site_index, key);
+}
+}  // namespace Hylord::BedData
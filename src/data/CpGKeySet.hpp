@@ -0,0 +1,135 @@
+#ifndef CPG_KEY_SET_H_
+#define CPG_KEY_SET_H_
+
+/**
+ * @file    CpGKeySet.hpp
+ * @brief   Declares a compressed set of packed genomic keys, used to hold
+ * (genome wide) CpG lists.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "types.hpp"
+
+namespace Hylord::BedData {
+/**
+ * @brief Set of packed genomic keys (see BedRecords::packKey) taking a few
+ * bits per CpG site.
+ *
+ * Keys are grouped by site (chromosome and start). Sites are stored in
+ * blocks of up to block_size sites of one chromosome: the first site of a
+ * block in full (a skip pointer), the rest as varint encoded gaps from the
+ * previous start. Which of the marks ('m' and 'h') a site has is held in two
+ * bits per site. Keys with any other name are rare, so are kept as they are.
+ *
+ * Membership is checked by a binary search over the blocks, then decoding
+ * the gaps within a block. Cursors (see Cursor) check keys in ascending
+ * order, as in the joins, and mostly just decode the next gap.
+ */
+class CpGKeySet {
+  public:
+   /// Sites per block, trading the size of the skip pointers against the
+   /// number of gaps decoded per lookup.
+   static constexpr std::uint32_t block_size{64};
+
+   /// Builds a set from keys in any order (defined below).
+   class Builder;
+
+   /**
+    * @brief Checks keys in ascending order against the set.
+    *
+    * Each check resumes from where the last one stopped, so checking the
+    * sorted keys of a file against the set is a merge of the two.
+    */
+   class Cursor {
+     public:
+      explicit Cursor(const CpGKeySet& set);
+      /// Whether the key is in the set. Keys have to be given in ascending
+      /// (non-decreasing) order.
+      [[nodiscard]] auto contains(GenomicKey key) -> bool;
+
+     private:
+      const CpGKeySet* m_set;
+      std::size_t m_block{};
+      std::uint32_t m_site_index{};
+      std::uint32_t m_gap_offset{};
+      /// Current site (with an empty name), or the largest key past the end
+      GenomicKey m_site{};
+
+      void startBlock(std::size_t block);
+      void seek(GenomicKey site);
+   };
+
+   CpGKeySet() = default;
+   /// Builds a set from keys in any order (see Builder).
+   explicit CpGKeySet(const GenomicKeys& keys);
+
+   [[nodiscard]] auto contains(GenomicKey key) const -> bool;
+   [[nodiscard]] auto cursor() const -> Cursor { return Cursor{*this}; }
+   /// Number of keys in the set.
+   [[nodiscard]] auto size() const -> std::size_t { return m_size; }
+   [[nodiscard]] auto empty() const -> bool { return m_size == 0; }
+   /// Smallest and largest key of each chromosome.
+   [[nodiscard]] auto keyRanges() const -> const IO::KeyRanges& {
+      return m_key_ranges;
+   }
+   /// Decodes every key (ascending).
+   [[nodiscard]] auto keys() const -> GenomicKeys;
+   /// Bytes held by the set.
+   [[nodiscard]] auto memoryUsage() const -> std::size_t;
+
+  private:
+   struct Block {
+      /// First site of the block (with an empty name)
+      GenomicKey first_site;
+      std::uint32_t gap_offset;
+      std::uint32_t first_site_index;
+   };
+
+   std::vector<Block> m_blocks;
+   std::vector<std::uint8_t> m_gaps;
+   /// Two bits per site: 'm' then 'h'
+   std::vector<std::uint64_t> m_marks;
+   /// Keys named other than 'm' or 'h' (ascending)
+   GenomicKeys m_other_keys;
+   IO::KeyRanges m_key_ranges;
+   std::uint32_t m_sites{};
+   GenomicKey m_last_site{};
+   std::size_t m_size{};
+
+   /// Adds a key no smaller than any added so far.
+   void append(GenomicKey key);
+   void shrinkToFit();
+   [[nodiscard]] auto hasMark(std::uint32_t site_index, GenomicKey key) const
+       -> bool;
+   /// Index one past the last site of the block.
+   [[nodiscard]] auto blockEnd(std::size_t block) const -> std::uint32_t;
+   /// Decodes the gap at the offset, moving the offset past it.
+   [[nodiscard]] auto readGap(std::uint32_t& offset) const -> GenomicKey;
+};
+
+/**
+ * Builds a set from keys added in any order (duplicates are ignored).
+ * Keys in ascending order are compressed as they are added. If a key is
+ * added out of order, the keys are collected and sorted on build()
+ * instead.
+ */
+class CpGKeySet::Builder {
+  public:
+   void add(GenomicKey key);
+   /// Whether every key so far was added in ascending order.
+   [[nodiscard]] auto isSorted() const -> bool { return m_sorted; }
+   [[nodiscard]] auto build() && -> CpGKeySet;
+
+  private:
+   CpGKeySet m_set;
+   bool m_sorted{true};
+   GenomicKeys m_unsorted_keys;
+};
+}  // namespace Hylord::BedData
+
+#endif
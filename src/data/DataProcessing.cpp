@@ -7,32 +7,80 @@
 
 #include "data/DataProcessing.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 #include "HylordException.hpp"
 #include "data/BedData.hpp"
+#include "data/BedRecords.hpp"
+#include "io/ReferenceMatrixReader.hpp"
+#include "io/SharedReference.hpp"
+#include "io/TSVFileReader.hpp"
+#include "parallel/ParallelFor.hpp"
 
 namespace Hylord::Processing {
+namespace {
 /**
- * Processes input data, ensuring row consistency between bedmethyl data and
- * reference matrix. Optionally subsets both datasets based on a CpG list and
- * adds specified additional cell types if given by user.
+ * The join stage (two pointer/binary search) relies on sorted inputs, so any
+ * input that was found to be unsorted whilst reading is sorted here instead of
+ * silently producing a tiny overlap.
+ */
+template <typename BedFile>
+void ensureSorted(BedFile& bed_file,
+                  std::string_view description,
+                  int threads) {
+   if (bed_file.empty() || bed_file.isSorted()) return;
+   std::cerr << "Warning: " << description
+             << " is not sorted, sorting it in memory before joining. "
+                "Sorting the file beforehand avoids this cost.\n";
+   bed_file.sortRows(threads);
+}
+
+/**
+ * Finds the rows a (sorted) reference matrix shares with the bulk records,
+ * as indexes into each.
  *
- * @throws PreprocessingException if subsetting fails or no overlapping indexes
- * are found.
+ * @throws PreprocessingException if there are none.
  */
-void preprocessInputData(BedData::BedMethylData& bedmethyl,
-                         BedData::ReferenceMatrixData& reference_matrix,
-                         const BedData::CpGData& cpg_list,
-                         int additional_cell_types) {
-   if (reference_matrix.empty())
-      reference_matrix = BedData::ReferenceMatrixData{bedmethyl};
-   if (bedmethyl.empty()) {
+template <typename BulkRecords>
+auto findOverlap(const BulkRecords& bulk_records,
+                 std::string_view description,
+                 const BedData::ReferenceMatrixData& reference_matrix)
+    -> std::pair<RowIndexes, RowIndexes> {
+   std::pair<RowIndexes, RowIndexes> overlapping_indexes{
+       BedData::findOverLappingIndexes(reference_matrix.records(),
+                                       bulk_records)};
+   if (overlapping_indexes.first.empty() ||
+       overlapping_indexes.second.empty()) {
       throw PreprocessingException(
-          "bedmethyl file is empty",
-          "This could be due to the file being empty, no rows being gleaned "
-          "or no rows passing the filters set");
+          "Find Overlapping Indexes",
+          "No overlapping indexes found between reference matrix and " +
+              std::string{description} + '.');
    }
+   return overlapping_indexes;
+}
+
+/**
+ * Subsets the reference matrix on the (sorted) CpG list, then keeps the rows
+ * that it shares with the bulk records (in the same order). Returns the
+ * indexes of the shared rows in the bulk records.
+ */
+template <typename BulkRecords>
+auto overlapWithReference(const BulkRecords& bulk_records,
+                          std::string_view description,
+                          BedData::ReferenceMatrixData& reference_matrix,
+                          const BedData::CpGData& cpg_list,
+                          int threads) -> RowIndexes {
+   ensureSorted(reference_matrix, "reference matrix", threads);
 
    if (!cpg_list.empty()) {
       try {
@@ -42,28 +90,360 @@ void preprocessInputData(BedData::BedMethylData& bedmethyl,
          throw PreprocessingException("Subset Reference Matrix on CpG List",
                                       e.what());
       }
-      try {
-         bedmethyl.subsetRows(
-             BedData::findIndexesInCpGList(cpg_list, bedmethyl.records()));
-      } catch (const std::exception& e) {
-         throw PreprocessingException("Subset Bedmethyl File on CpG List",
-                                      e.what());
-      }
    }
    std::pair<RowIndexes, RowIndexes> overlapping_indexes{
-       BedData::findOverLappingIndexes(reference_matrix.records(),
-                                       bedmethyl.records())};
+       findOverlap(bulk_records, description, reference_matrix)};
+   reference_matrix.subsetRows(overlapping_indexes.first);
+   return std::move(overlapping_indexes.second);
+}
 
-   if (overlapping_indexes.first.empty() ||
-       overlapping_indexes.second.empty()) {
+/// As overlapWithReference(), but also subsets the bulk data in place.
+template <typename BulkData>
+void joinWithReference(BulkData& bulk_data,
+                       std::string_view description,
+                       BedData::ReferenceMatrixData& reference_matrix,
+                       const BedData::CpGData& cpg_list,
+                       int threads) {
+   bulk_data.subsetRows(overlapWithReference(
+       bulk_data.records(), description, reference_matrix, cpg_list, threads));
+}
+}  // namespace
+
+auto readReferenceMatrix(std::string_view file_name,
+                         int threads,
+                         const IO::ColumnIndexes& cell_type_columns,
+                         IO::RowFilter rowFilter,
+                         const IO::KeyRanges& key_ranges)
+    -> BedData::ReferenceMatrixData {
+   if (file_name.empty()) return BedData::ReferenceMatrixData{};
+
+   IO::ReferenceMatrixReader reader{file_name, std::move(rowFilter), threads};
+   if (!cell_type_columns.empty()) reader.selectColumns(cell_type_columns);
+   if (!key_ranges.empty()) reader.limitToKeyRanges(key_ranges);
+   reader.load();
+   const bool sorted{reader.isSorted()};
+   return BedData::ReferenceMatrixData{
+       reader.extractRecords(), reader.extractProportions(), sorted};
+}
+
+auto readSharedReferenceMatrix(const std::string& segment_name,
+                               std::string_view file_name,
+                               int threads,
+                               const IO::ColumnIndexes& cell_type_columns,
+                               IO::RowFilter rowFilter,
+                               const IO::KeyRanges& key_ranges,
+                               std::string_view row_filter)
+    -> BedData::ReferenceMatrixData {
+   const std::uint64_t identity{IO::referenceIdentity(
+       file_name, cell_type_columns, key_ranges, row_filter)};
+   if (auto shared{IO::SharedReference::attach(segment_name, identity)}) {
+      return BedData::ReferenceMatrixData{std::move(shared)};
+   }
+   BedData::ReferenceMatrixData reference_matrix{
+       readReferenceMatrix(file_name,
+                           threads,
+                           cell_type_columns,
+                           std::move(rowFilter),
+                           key_ranges)};
+   // Attached matrices are expected to be sorted
+   if (!reference_matrix.isSorted()) reference_matrix.sortRows(threads);
+   IO::SharedReference::publish(segment_name,
+                                identity,
+                                BedData::keysOf(reference_matrix.records()),
+                                reference_matrix.getAsEigenMatrix());
+   return reference_matrix;
+}
+
+/**
+ * A CpG list found to be out of order is collected and sorted once all of it
+ * is read (see BedData::CpGKeySet::Builder).
+ */
+auto readCpGList(std::string_view file_name,
+                 int threads,
+                 IO::RowFilter rowFilter) -> BedData::CpGData {
+   if (file_name.empty()) return BedData::CpGData{};
+
+   constexpr std::size_t batch_bytes{std::size_t{64} << 20U};
+   IO::TSVFileReader<BedRecords::Bed4> reader{
+       file_name, {}, std::move(rowFilter), threads};
+   BedData::CpGKeySet::Builder builder{};
+   reader.stream(batch_bytes,
+                 [&builder](std::vector<BedRecords::Bed4>&& records) {
+                    for (const auto& record : records) {
+                       builder.add(record.key());
+                    }
+                 });
+   if (!builder.isSorted()) {
+      std::cerr << "Warning: CpG list is not sorted, sorting it in memory. "
+                   "Sorting the file beforehand avoids this cost.\n";
+   }
+   return BedData::CpGData{std::move(builder).build()};
+}
+
+/**
+ * Rows of sorted files are merged, keeping the result sorted. Otherwise they
+ * are concatenated and left for the join to sort (see ensureSorted()).
+ */
+auto readBedGraphs(const std::vector<BedGraphFile>& files,
+                   int threads,
+                   const IO::RowFilter& rowFilter,
+                   IO::ParseStatistics* statistics) -> BedData::BedMethylData {
+   std::vector<std::vector<BedRecords::Bed9Plus9>> marks(files.size());
+   std::vector<IO::ParseStatistics> file_statistics(files.size());
+   // Not std::vector<bool>, as files are read concurrently
+   std::vector<char> sorted(files.size());
+   const int file_threads{
+       std::max(1, threads / static_cast<int>(std::max<std::size_t>(
+                                 files.size(), 1)))};
+   Parallel::forEachBlock(
+       files.size(), threads, [&](const Parallel::Block& block) {
+          for (std::size_t i{block.begin}; i < block.end; ++i) {
+             IO::TSVFileReader<BedRecords::BedGraph> reader{
+                 files[i].file_name, {}, rowFilter, file_threads};
+             if (statistics != nullptr) reader.collectStatistics();
+             reader.load();
+             sorted[i] = static_cast<char>(reader.isSorted());
+             file_statistics[i] = reader.statistics().tagged(files[i].mark);
+             const std::vector<BedRecords::BedGraph> rows{
+                 reader.extractRecords()};
+             marks[i].reserve(rows.size());
+             for (const auto& row : rows) {
+                marks[i].push_back(row.tag(files[i].mark));
+             }
+          }
+       });
+
+   if (statistics != nullptr) {
+      for (const auto& counts : file_statistics) statistics->merge(counts);
+   }
+   const bool all_sorted{
+       std::ranges::all_of(sorted, [](char file) { return file != 0; })};
+   std::vector<BedRecords::Bed9Plus9> records{};
+   for (auto& rows : marks) {
+      if (records.empty()) {
+         records = std::move(rows);
+         continue;
+      }
+      const auto middle{std::ssize(records)};
+      records.insert(records.end(),
+                     std::make_move_iterator(rows.begin()),
+                     std::make_move_iterator(rows.end()));
+      if (all_sorted) {
+         std::ranges::inplace_merge(
+             records,
+             records.begin() + middle,
+             {},
+             [](const auto& row) { return row.key(); });
+      }
+      rows = {};
+   }
+   return BedData::BedMethylData{std::move(records), all_sorted};
+}
+
+/**
+ * The columns of modkit's per-read tables have changed between releases, so
+ * they are located by name. Columns are returned in the order expected by
+ * BedRecords::ReadCall, followed by the fail column (see
+ * Filters::generateReadCallFilter).
+ *
+ * @throws FileReadException if the header can't be read or lacks a column.
+ */
+auto findModkitCallColumns(const std::string& read_calls_file)
+    -> IO::ColumnIndexes {
+   static constexpr std::array<std::string_view, 6> required_columns{
+       "read_id", "chrom", "ref_position", "ref_strand", "call_code", "fail"};
+
+   std::ifstream calls_file(read_calls_file);
+   std::string header{};
+   if (!calls_file || !std::getline(calls_file, header)) {
+      throw FileReadException(read_calls_file, "Could not read header.");
+   }
+   Fields header_fields{};
+   std::size_t start{};
+   while (start <= header.size()) {
+      const std::size_t end{std::min(header.find('\t', start), header.size())};
+      header_fields.emplace_back(header.substr(start, end - start));
+      start = end + 1;
+   }
+
+   IO::ColumnIndexes columns{};
+   for (const auto column_name : required_columns) {
+      const auto match{std::ranges::find(header_fields, column_name)};
+      if (match == header_fields.end()) {
+         throw FileReadException(read_calls_file,
+                                 "Missing column '" +
+                                     std::string{column_name} +
+                                     "' (expected modkit extract calls "
+                                     "output).");
+      }
+      columns.push_back(static_cast<std::size_t>(
+          std::distance(header_fields.begin(), match)));
+   }
+   return columns;
+}
+
+/**
+ * Columns are returned in the order the cell types were selected, so the
+ * loaded matrix (and therefore the output) follows that order. An empty
+ * selection gives no columns (meaning every column is loaded).
+ *
+ * @throws PreprocessingException if a cell type is not in the cell type list
+ * or is selected more than once.
+ */
+auto findCellTypeColumns(std::string_view cell_type_list_file,
+                         const std::vector<std::string>& selected_cell_types)
+    -> IO::ColumnIndexes {
+   if (selected_cell_types.empty()) return {};
+
+   IO::TSVFileReader<BedRecords::CellType> reader{cell_type_list_file};
+   reader.load();
+   const std::vector<BedRecords::CellType> cell_types{reader.extractRecords()};
+
+   IO::ColumnIndexes columns{};
+   columns.reserve(selected_cell_types.size());
+   for (const auto& selected : selected_cell_types) {
+      const auto match{std::ranges::find(
+          cell_types, selected, &BedRecords::CellType::cell_type)};
+      if (match == cell_types.end()) {
+         throw PreprocessingException(
+             "Select cell types",
+             "'" + selected + "' is not in the cell type list.");
+      }
+      const auto column{
+          static_cast<std::size_t>(std::distance(cell_types.begin(), match))};
+      if (std::ranges::find(columns, column) != columns.end()) {
+         throw PreprocessingException(
+             "Select cell types", "'" + selected + "' was selected twice.");
+      }
+      columns.push_back(column);
+   }
+   return columns;
+}
+
+/**
+ * Sorts the bedmethyl data if needed and optionally subsets it on the CpG
+ * list.
+ *
+ * @throws PreprocessingException if the bedmethyl data is empty or subsetting
+ * fails.
+ */
+void preprocessBedmethyl(BedData::BedMethylData& bedmethyl,
+                         const BedData::CpGData& cpg_list,
+                         int threads) {
+   ensureSorted(bedmethyl, "bedmethyl file", threads);
+
+   if (bedmethyl.empty()) {
       throw PreprocessingException(
-          "Find Overlapping Indexes",
-          "No overlapping indexes found between reference matrix and input "
-          "bedmethyl file.");
+          "bedmethyl file is empty",
+          "This could be due to the file being empty, no rows being gleaned "
+          "or no rows passing the filters set");
    }
-   reference_matrix.subsetRows(overlapping_indexes.first);
-   bedmethyl.subsetRows(overlapping_indexes.second);
+   if (cpg_list.empty()) return;
+   try {
+      bedmethyl.subsetRows(
+          BedData::findIndexesInCpGList(cpg_list, bedmethyl.records()));
+   } catch (const std::exception& e) {
+      throw PreprocessingException("Subset Bedmethyl File on CpG List",
+                                   e.what());
+   }
+}
 
+/**
+ * Processes input data, ensuring row consistency between bedmethyl data and
+ * reference matrix. Unsorted inputs are sorted first. Optionally subsets both
+ * datasets based on a CpG list and adds specified additional cell types if
+ * given by user. Runs without a reference matrix only need
+ * preprocessBedmethyl() (see ReferenceFree).
+ *
+ * @throws PreprocessingException if subsetting fails or no overlapping indexes
+ * are found.
+ */
+void preprocessInputData(BedData::BedMethylData& bedmethyl,
+                         BedData::ReferenceMatrixData& reference_matrix,
+                         const BedData::CpGData& cpg_list,
+                         int additional_cell_types,
+                         int threads) {
+   preprocessBedmethyl(bedmethyl, cpg_list, threads);
+   joinWithReference(bedmethyl,
+                     "input bedmethyl file",
+                     reference_matrix,
+                     cpg_list,
+                     threads);
    reference_matrix.addMoreCellTypes(additional_cell_types);
 }
+
+/**
+ * Rows of the bulk matrix outside of the CpG list are dropped by the join,
+ * as the reference matrix is subset on the CpG list first.
+ *
+ * @throws PreprocessingException if the bulk matrix is empty, subsetting
+ * fails or no overlapping indexes are found.
+ */
+void preprocessBulkMatrix(BedData::ReferenceMatrixData& bulk_matrix,
+                          BedData::ReferenceMatrixData& reference_matrix,
+                          const BedData::CpGData& cpg_list,
+                          int threads) {
+   ensureSorted(bulk_matrix, "bulk matrix", threads);
+   if (bulk_matrix.empty()) {
+      throw PreprocessingException(
+          "bulk matrix is empty",
+          "This could be due to the file being empty, no rows being gleaned "
+          "or no rows passing the filters set");
+   }
+   joinWithReference(
+       bulk_matrix, "bulk matrix", reference_matrix, cpg_list, threads);
+}
+
+/**
+ * The bedmethyl data is left alone so that it can be joined with every
+ * panel, only the rows shared with this panel are copied out.
+ *
+ * @throws PreprocessingException if subsetting fails or no overlapping indexes
+ * are found.
+ */
+auto joinWithPanel(const BedData::BedMethylData& bedmethyl,
+                   BedData::ReferenceMatrixData& reference_matrix,
+                   const BedData::CpGData& cpg_list,
+                   int threads) -> BedData::BedMethylData {
+   const RowIndexes rows{overlapWithReference(bedmethyl.records(),
+                                              "input bedmethyl file",
+                                              reference_matrix,
+                                              cpg_list,
+                                              threads)};
+   std::vector<BedRecords::Bed9Plus9> records{};
+   records.reserve(rows.size());
+   for (const std::size_t row : rows) {
+      records.push_back(bedmethyl.records()[row]);
+   }
+   return BedData::BedMethylData{std::move(records), true};
+}
+
+/**
+ * The CpG list subset is the same for every sample, so is done here rather
+ * than in every join.
+ */
+void prepareSharedReference(BedData::ReferenceMatrixData& reference_matrix,
+                            const BedData::CpGData& cpg_list,
+                            int threads) {
+   ensureSorted(reference_matrix, "reference matrix", threads);
+   if (cpg_list.empty()) return;
+   try {
+      reference_matrix.subsetRows(BedData::findIndexesInCpGList(
+          cpg_list, reference_matrix.records()));
+   } catch (const std::exception& e) {
+      throw PreprocessingException("Subset Reference Matrix on CpG List",
+                                   e.what());
+   }
+}
+
+/**
+ * @throws PreprocessingException if no overlapping indexes are found.
+ */
+auto overlapWithSharedReference(
+    const BedData::BedMethylData& bedmethyl,
+    const BedData::ReferenceMatrixData& reference_matrix)
+    -> std::pair<RowIndexes, RowIndexes> {
+   return findOverlap(
+       bedmethyl.records(), "input bedmethyl file", reference_matrix);
+}
 }  // namespace Hylord::Processing
@@ -8,7 +8,15 @@
  * file in the repository root or https://mit-license.org)
  */
 
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "concepts.hpp"
 #include "data/BedData.hpp"
+#include "io/ParseStatistics.hpp"
+#include "io/ReferenceMatrixReader.hpp"
 #include "io/TSVFileReader.hpp"
 #include "types.hpp"
 
@@ -21,30 +29,146 @@ namespace Hylord::Processing {
  * Reads a BED-formatted file using multiple threads if specified,
  * with options for column selection and row filtering. Returns an empty
  * container if the filename is empty. Threads and field selection can be
- * customized.
+ * customized. The container is told whether the file was sorted (determined
+ * whilst reading), so that the join stage can sort it if needed. Key ranges
+ * let indexed files skip rows that can't be joined (see
+ * IO::TSVFileReader::limitToKeyRanges). If statistics are given (only for
+ * methylation records), they are filled whilst parsing (see
+ * IO::TSVFileReader::collectStatistics).
  */
 template <typename BedFile, typename BedType>
 auto readFile(const std::string_view file_name,
               int threads,
               const IO::ColumnIndexes& fields_to_extract = {},
-              IO::RowFilter rowFilter = nullptr) -> BedFile {
+              IO::RowFilter rowFilter = nullptr,
+              const IO::KeyRanges& key_ranges = {},
+              IO::ParseStatistics* statistics = nullptr) -> BedFile {
    if (file_name.empty()) return BedFile{};
 
-   return BedFile{[&]() {
-      IO::TSVFileReader<BedType> reader{
-          file_name, fields_to_extract, rowFilter, threads};
-      reader.load();
-      return reader.extractRecords();
-   }()};
+   IO::TSVFileReader<BedType> reader{
+       file_name, fields_to_extract, rowFilter, threads};
+   if (!key_ranges.empty()) reader.limitToKeyRanges(key_ranges);
+   if constexpr (Records::MethylationRecord<BedType>) {
+      if (statistics != nullptr) reader.collectStatistics();
+   }
+   reader.load();
+   if (statistics != nullptr) statistics->merge(reader.statistics());
+   const bool sorted{reader.isSorted()};
+   return BedFile{reader.extractRecords(), sorted};
 }
 
+/// Reads a reference matrix (BED4+X) with the dedicated wide row reader (see
+/// IO::ReferenceMatrixReader), optionally only loading some cell types.
+/// Returns an empty container if the filename is empty.
+auto readReferenceMatrix(std::string_view file_name,
+                         int threads,
+                         const IO::ColumnIndexes& cell_type_columns = {},
+                         IO::RowFilter rowFilter = nullptr,
+                         const IO::KeyRanges& key_ranges = {})
+    -> BedData::ReferenceMatrixData;
+
+/**
+ * As readReferenceMatrix(), but shares the parsed (and sorted) matrix with
+ * other processes on the node through the named shared memory segment (see
+ * IO::SharedReference). The segment is attached to if it was published from
+ * the same inputs, otherwise the matrix is parsed and published.
+ * `row_filter` describes the row filter, as part of the inputs.
+ */
+auto readSharedReferenceMatrix(const std::string& segment_name,
+                               std::string_view file_name,
+                               int threads,
+                               const IO::ColumnIndexes& cell_type_columns,
+                               IO::RowFilter rowFilter,
+                               const IO::KeyRanges& key_ranges,
+                               std::string_view row_filter)
+    -> BedData::ReferenceMatrixData;
+
+/**
+ * Reads a CpG list straight into its compressed key set (see
+ * BedData::CpGKeySet), streaming the file so that the records are never all
+ * held at once. Returns an empty container if the filename is empty.
+ */
+auto readCpGList(std::string_view file_name,
+                 int threads,
+                 IO::RowFilter rowFilter = nullptr) -> BedData::CpGData;
+
+/// A per mark bedGraph file (see readBedGraphs()).
+struct BedGraphFile {
+   char mark{};
+   std::string file_name;
+};
+
+/**
+ * Reads per mark bedGraph files (from `modkit pileup --bedgraph`) in place
+ * of a bedmethyl file. The files are parsed in parallel (sharing the
+ * threads), their rows are tagged with the mark of their file and merged by
+ * key into a single bedmethyl container. The row filter sees the fields of
+ * bedGraph rows, so can't filter on the mark. If statistics are given, they
+ * are filled whilst parsing (under the mark of each file).
+ */
+auto readBedGraphs(const std::vector<BedGraphFile>& files,
+                   int threads,
+                   const IO::RowFilter& rowFilter = nullptr,
+                   IO::ParseStatistics* statistics = nullptr)
+    -> BedData::BedMethylData;
+
+/// Finds the reference matrix columns of the selected cell types, using their
+/// positions in the cell type list.
+auto findCellTypeColumns(std::string_view cell_type_list_file,
+                         const std::vector<std::string>& selected_cell_types)
+    -> IO::ColumnIndexes;
+
+/// Finds the columns of a `modkit extract calls` table that are needed for
+/// read level assignment (see BedRecords::ReadCall) from its header.
+auto findModkitCallColumns(const std::string& read_calls_file)
+    -> IO::ColumnIndexes;
+
+/// Sorts and subsets the bedmethyl data on its own (for runs without a
+/// reference matrix).
+void preprocessBedmethyl(BedData::BedMethylData& bedmethyl,
+                         const BedData::CpGData& cpg_list,
+                         int threads);
+
 /// Preprocesses input data by aligning and subsetting bedmethyl and reference
 /// matrix data.
 void preprocessInputData(BedData::BedMethylData& bedmethyl,
                          BedData::ReferenceMatrixData& reference_matrix,
                          const BedData::CpGData& cpg_list,
-                         int additional_cell_types);
+                         int additional_cell_types,
+                         int threads);
 
+/// Aligns a bulk matrix (a column per sample, in the same format as the
+/// reference matrix) with the reference matrix.
+void preprocessBulkMatrix(BedData::ReferenceMatrixData& bulk_matrix,
+                          BedData::ReferenceMatrixData& reference_matrix,
+                          const BedData::CpGData& cpg_list,
+                          int threads);
+
+/// Joins one of several reference panels with bedmethyl data that was
+/// preprocessed once (see preprocessBedmethyl()), returning the bedmethyl
+/// rows shared with the panel.
+auto joinWithPanel(const BedData::BedMethylData& bedmethyl,
+                   BedData::ReferenceMatrixData& reference_matrix,
+                   const BedData::CpGData& cpg_list,
+                   int threads) -> BedData::BedMethylData;
+
+/// Sorts a reference matrix and subsets it on the CpG list, once, so that
+/// it can be joined with many samples (see overlapWithSharedReference()).
+void prepareSharedReference(BedData::ReferenceMatrixData& reference_matrix,
+                            const BedData::CpGData& cpg_list,
+                            int threads);
+
+/**
+ * Finds the rows a reference matrix prepared by prepareSharedReference()
+ * shares with preprocessed bedmethyl data (see preprocessBedmethyl()),
+ * leaving both alone. Returns the indexes of the shared rows in the
+ * reference matrix and in the bedmethyl data (in the same order), so that
+ * only those rows need copying.
+ */
+auto overlapWithSharedReference(
+    const BedData::BedMethylData& bedmethyl,
+    const BedData::ReferenceMatrixData& reference_matrix)
+    -> std::pair<RowIndexes, RowIndexes>;
 }  // namespace Hylord::Processing
 
 #endif
@@ -9,6 +9,7 @@
 
 #include <limits>
 #include <stdexcept>
+#include <utility>
 
 #include "cli.hpp"
 #include "types.hpp"
@@ -76,18 +77,46 @@ auto generateNameFilter(const CMD::HylordConfig& config) -> RowFilter {
                                    : combined_filters.combinedFilter();
 }
 
-auto generateBedmethylRowFilter(const CMD::HylordConfig& config) -> RowFilter {
+auto generateReadDepthFilter(const CMD::HylordConfig& config) -> RowFilter {
    FilterCombiner combined_filters{};
    if (config.min_read_depth != 0)
       combined_filters.addFilter(makeLowReadFilter(config.min_read_depth));
    if (config.max_read_depth != std::numeric_limits<int>::max())
       combined_filters.addFilter(makeHighReadFilter(config.max_read_depth));
-   if (config.use_only_methylation_signal)
-      combined_filters.addFilter(is_methyl_read);
-   if (config.use_only_hydroxy_signal)
-      combined_filters.addFilter(is_hydroxy_read);
 
    return combined_filters.empty() ? nullptr
                                    : combined_filters.combinedFilter();
 }
+
+/// The read depth filters (see generateReadDepthFilter()) are applied before
+/// the name filters (see generateNameFilter()).
+auto generateBedmethylRowFilter(const CMD::HylordConfig& config) -> RowFilter {
+   FilterCombiner combined_filters{};
+   if (RowFilter depth_filter{generateReadDepthFilter(config)})
+      combined_filters.addFilter(std::move(depth_filter));
+   if (RowFilter name_filter{generateNameFilter(config)})
+      combined_filters.addFilter(std::move(name_filter));
+
+   return combined_filters.empty() ? nullptr
+                                   : combined_filters.combinedFilter();
+}
+
+/**
+ * Fields are expected in the order read_id, chrom, ref_position, ref_strand,
+ * call_code, fail. Removes the header row, calls that modkit failed (below
+ * its threshold), calls on unmapped positions (-1) and call codes other than
+ * m, h and - (canonical).
+ */
+auto generateReadCallFilter() -> RowFilter {
+   return [](const Fields& fields) -> bool {
+      if (fields.size() < 6) {
+         throw std::out_of_range(
+             "Could not apply row filter, not enough fields.");
+      }
+      if (fields[0] == "read_id") return false;
+      if (fields[5] == "true") return false;
+      if (fields[2].empty() || fields[2][0] == '-') return false;
+      return fields[4] == "m" || fields[4] == "h" || fields[4] == "-";
+   };
+}
 }  // namespace Hylord::Filters
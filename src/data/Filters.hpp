@@ -56,6 +56,15 @@ auto generateNameFilter(const CMD::HylordConfig& config) -> RowFilter;
 /// given on command line
 auto generateBedmethylRowFilter(const CMD::HylordConfig& config) -> RowFilter;
 
+/// Generates a filter on the read depth only, for bedGraph rows (which hold
+/// their read depth in the same field as bedmethyl rows, but no name)
+auto generateReadDepthFilter(const CMD::HylordConfig& config) -> RowFilter;
+
+/// Generates a filter for modkit extract calls rows (see
+/// Processing::findModkitCallColumns), keeping passing calls on mapped
+/// positions
+auto generateReadCallFilter() -> RowFilter;
+
 }  // namespace Hylord::Filters
 
 #endif
@@ -0,0 +1,92 @@
+/**
+ * @file    Sorting.cpp
+ * @brief   Defines a parallel radix sort for packed genomic keys.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "data/Sorting.hpp"
+
+#include <array>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "parallel/ParallelFor.hpp"
+#include "types.hpp"
+
+namespace Hylord::Sorting {
+/**
+ * Least significant digit radix sort over the bytes of each key. Bytes that
+ * are identical across all keys (e.g. the upper chromosome bits) are skipped
+ * entirely, so a typical whole genome input only needs 4-5 passes.
+ *
+ * Each pass is parallelised by giving every thread a contiguous block of the
+ * input. Threads build a histogram for their block, the histograms are turned
+ * into per thread write offsets (bucket major, then block order, which keeps
+ * the sort stable) and each thread then scatters its own block.
+ */
+auto sortedPermutation(const GenomicKeys& keys, int threads) -> RowIndexes {
+   const std::size_t size{keys.size()};
+   RowIndexes permutation(size);
+   std::iota(permutation.begin(), permutation.end(), RowIndex{});
+   if (size < 2) return permutation;
+
+   GenomicKey varying_bits{};
+   for (auto key : keys) varying_bits |= key ^ keys[0];
+   if (varying_bits == 0) return permutation;
+
+   // Spawning threads for tiny inputs costs more than it saves
+   constexpr std::size_t min_parallel_size{1U << 16U};
+   const int sort_threads{size < min_parallel_size ? 1 : threads};
+   const std::size_t num_blocks{Parallel::numberOfBlocks(size, sort_threads)};
+
+   constexpr std::size_t radix{256};
+   constexpr unsigned bits_per_pass{8};
+   using Histogram = std::array<std::size_t, radix>;
+   std::vector<Histogram> offsets(num_blocks);
+
+   GenomicKeys current_keys{keys};
+   GenomicKeys next_keys(size);
+   RowIndexes next_permutation(size);
+
+   for (unsigned shift{}; shift < 8 * sizeof(GenomicKey);
+        shift += bits_per_pass) {
+      if (((varying_bits >> shift) & (radix - 1)) == 0) continue;
+
+      Parallel::forEachBlock(
+          size, sort_threads, [&](const Parallel::Block& block) {
+             Histogram& histogram{offsets[block.index]};
+             histogram.fill(0);
+             for (std::size_t i{block.begin}; i < block.end; ++i) {
+                ++histogram[(current_keys[i] >> shift) & (radix - 1)];
+             }
+          });
+
+      std::size_t running_offset{};
+      for (std::size_t bucket{}; bucket < radix; ++bucket) {
+         for (auto& histogram : offsets) {
+            const std::size_t count{histogram[bucket]};
+            histogram[bucket] = running_offset;
+            running_offset += count;
+         }
+      }
+
+      Parallel::forEachBlock(
+          size, sort_threads, [&](const Parallel::Block& block) {
+             Histogram& block_offsets{offsets[block.index]};
+             for (std::size_t i{block.begin}; i < block.end; ++i) {
+                const std::size_t destination{
+                    block_offsets[(current_keys[i] >> shift) & (radix - 1)]++};
+                next_keys[destination] = current_keys[i];
+                next_permutation[destination] = permutation[i];
+             }
+          });
+
+      std::swap(current_keys, next_keys);
+      std::swap(permutation, next_permutation);
+   }
+   return permutation;
+}
+}  // namespace Hylord::Sorting
@@ -0,0 +1,19 @@
+#ifndef SORTING_H_
+#define SORTING_H_
+
+/**
+ * @file    Sorting.hpp
+ * @brief   Declares sorting utilities for packed genomic keys.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "types.hpp"
+
+/// Sorting utilities used when input files are not sorted
+namespace Hylord::Sorting {
+/// Finds the permutation that stably sorts the given keys (ascending).
+auto sortedPermutation(const GenomicKeys& keys, int threads) -> RowIndexes;
+}  // namespace Hylord::Sorting
+
+#endif
@@ -0,0 +1,246 @@
+/**
+ * @file    BatchJournal.cpp
+ * @brief   Defines the manifest and completion journal of batch runs (see
+ * the batch subcommand).
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "io/BatchJournal.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "HylordException.hpp"
+#include "io/FileDescriptor.hpp"
+#include "io/Hashing.hpp"
+
+namespace Hylord::IO {
+namespace {
+constexpr char journal_separator{'\t'};
+constexpr int journal_fields{4};
+
+/// Splits a line on tabs.
+auto splitFields(std::string_view line) -> std::vector<std::string_view> {
+   std::vector<std::string_view> fields{};
+   std::size_t start{};
+   while (true) {
+      const std::size_t end{line.find(journal_separator, start)};
+      fields.push_back(line.substr(start, end - start));
+      if (end == std::string_view::npos) return fields;
+      start = end + 1;
+   }
+}
+
+auto toHex(std::uint64_t value) -> std::string {
+   std::array<char, 16> digits{};
+   const auto result{
+       std::to_chars(digits.data(), digits.data() + digits.size(), value, 16)};
+   return {digits.data(), result.ptr};
+}
+
+auto fromHex(std::string_view digits, std::uint64_t& value) -> bool {
+   const auto result{std::from_chars(
+       digits.data(), digits.data() + digits.size(), value, 16)};
+   return result.ec == std::errc{} &&
+          result.ptr == digits.data() + digits.size();
+}
+
+/// Syncs a directory, so that files created or renamed in it survive a
+/// crash.
+void syncDirectory(const std::filesystem::path& directory) {
+   const int file_descriptor{::open(
+       directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY)};
+   if (file_descriptor == -1) return;
+   ::fsync(file_descriptor);
+   ::close(file_descriptor);
+}
+}  // namespace
+
+auto readManifest(const std::filesystem::path& manifest_file)
+    -> std::vector<BatchSample> {
+   std::ifstream manifest(manifest_file);
+   if (!manifest) {
+      throw FileReadException(manifest_file.string(),
+                              "Failed to open manifest.");
+   }
+   const std::filesystem::path directory{manifest_file.parent_path()};
+   std::vector<BatchSample> samples{};
+   std::unordered_set<std::string> names{};
+   std::string line;
+   int line_number{};
+   while (std::getline(manifest, line)) {
+      ++line_number;
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (line.empty() || line.starts_with('#')) continue;
+      const std::vector<std::string_view> fields{splitFields(line)};
+      const std::string location{"Line " + std::to_string(line_number)};
+      if (fields.size() != 2 || fields[0].empty() || fields[1].empty()) {
+         throw FileReadException(
+             manifest_file.string(),
+             location + " should hold a sample name and bedmethyl file.");
+      }
+      if (fields[0].find('/') != std::string_view::npos ||
+          fields[0] == "." || fields[0] == "..") {
+         throw FileReadException(
+             manifest_file.string(),
+             location + " names a sample that can't be used as a file name.");
+      }
+      BatchSample sample{std::string{fields[0]},
+                         std::filesystem::path{fields[1]}};
+      if (!names.insert(sample.name).second) {
+         throw FileReadException(
+             manifest_file.string(),
+             location + " repeats the sample '" + sample.name + "'.");
+      }
+      if (sample.bedmethyl_file.is_relative()) {
+         sample.bedmethyl_file = directory / sample.bedmethyl_file;
+      }
+      samples.push_back(std::move(sample));
+   }
+   return samples;
+}
+
+BatchJournal::BatchJournal(std::filesystem::path journal_file) :
+    m_journal_file{std::move(journal_file)} {
+   std::ifstream journal(m_journal_file, std::ios::binary);
+   if (!journal) return;
+   const std::string contents{std::istreambuf_iterator<char>{journal},
+                              std::istreambuf_iterator<char>{}};
+   std::string_view remaining{contents};
+   int line_number{};
+   while (!remaining.empty()) {
+      const std::size_t end{remaining.find('\n')};
+      if (end == std::string_view::npos) {
+         m_torn_tail = true;
+         break;
+      }
+      const std::string_view line{remaining.substr(0, end)};
+      remaining.remove_prefix(end + 1);
+      ++line_number;
+      if (line.empty()) continue;
+
+      const std::vector<std::string_view> fields{splitFields(line)};
+      JournalEntry entry{};
+      if (fields.size() != journal_fields ||
+          !fromHex(fields[1], entry.input_identity) ||
+          !fromHex(fields[2], entry.output_hash)) {
+         std::cerr << "Warning: Line " << line_number << " of journal '"
+                   << m_journal_file.string()
+                   << "' is malformed and was ignored.\n";
+         continue;
+      }
+      entry.sample = fields[0];
+      entry.out_path = fields[3];
+      m_entries.insert_or_assign(entry.sample, std::move(entry));
+   }
+}
+
+auto BatchJournal::isComplete(const std::string& sample,
+                              std::uint64_t input_identity) const -> bool {
+   const auto entry{m_entries.find(sample)};
+   if (entry == m_entries.end() ||
+       entry->second.input_identity != input_identity) {
+      return false;
+   }
+   std::error_code error{};
+   return std::filesystem::is_regular_file(entry->second.out_path, error) &&
+          fileHash(entry->second.out_path) == entry->second.output_hash;
+}
+
+/**
+ * The line is written with a single write() to a file opened for appending,
+ * then synced. A line cut short by an earlier run is ended first, so that
+ * the entry starts on its own line.
+ */
+void BatchJournal::record(const JournalEntry& entry) {
+   std::string line{m_torn_tail ? "\n" : ""};
+   line += entry.sample;
+   line += journal_separator;
+   line += toHex(entry.input_identity);
+   line += journal_separator;
+   line += toHex(entry.output_hash);
+   line += journal_separator;
+   line += entry.out_path.string();
+   line += '\n';
+
+   const bool created{!std::filesystem::exists(m_journal_file)};
+   const int file_descriptor{
+       ::open(m_journal_file.c_str(),
+              O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+              0644)};
+   if (file_descriptor == -1) {
+      throw FileWriteException(m_journal_file.string(),
+                               "Failed to open journal for appending.");
+   }
+   const bool written{writeAll(file_descriptor, line)};
+   const bool synced{written && ::fsync(file_descriptor) == 0};
+   ::close(file_descriptor);
+   if (!synced) {
+      throw FileWriteException(m_journal_file.string(),
+                               "Failed to append to journal.");
+   }
+   if (created) syncDirectory(m_journal_file.parent_path());
+   m_torn_tail = false;
+   m_entries.insert_or_assign(entry.sample, entry);
+}
+
+auto contentHash(std::string_view bytes) -> std::uint64_t {
+   std::uint64_t hash{fnv_offset_basis};
+   hashBytes(hash, bytes.data(), bytes.size());
+   return hash;
+}
+
+auto fileHash(const std::filesystem::path& file_path) -> std::uint64_t {
+   std::ifstream file(file_path, std::ios::binary);
+   if (!file) return 0;
+   std::stringstream contents;
+   contents << file.rdbuf();
+   return contentHash(contents.view());
+}
+
+void commitFile(std::string_view buffer,
+                const std::filesystem::path& out_path) {
+   std::filesystem::path temporary_path{out_path};
+   temporary_path += ".partial";
+   const int file_descriptor{
+       ::open(temporary_path.c_str(),
+              O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+              0644)};
+   if (file_descriptor == -1) {
+      throw FileWriteException(temporary_path.string(),
+                               "Failed to open file for writing.");
+   }
+   const bool written{writeAll(file_descriptor, buffer)};
+   const bool synced{written && ::fsync(file_descriptor) == 0};
+   std::error_code error{};
+   if (::close(file_descriptor) == -1 || !synced) {
+      std::filesystem::remove(temporary_path, error);
+      throw FileWriteException(temporary_path.string(),
+                               "Failed to write to file.");
+   }
+   std::filesystem::rename(temporary_path, out_path, error);
+   if (error) {
+      std::error_code remove_error{};
+      std::filesystem::remove(temporary_path, remove_error);
+      throw FileWriteException(out_path.string(),
+                               "Failed to replace file: " + error.message());
+   }
+   syncDirectory(out_path.parent_path());
+}
+}  // namespace Hylord::IO
@@ -0,0 +1,103 @@
+#ifndef BATCH_JOURNAL_H_
+#define BATCH_JOURNAL_H_
+
+/**
+ * @file    BatchJournal.hpp
+ * @brief   Declares the manifest and completion journal of batch runs (see
+ * the batch subcommand).
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Hylord::IO {
+/// A sample of a batch manifest.
+struct BatchSample {
+   std::string name;
+   std::filesystem::path bedmethyl_file;
+};
+
+/**
+ * Reads a batch manifest: a line per sample holding its name and bedmethyl
+ * file (tab separated). Empty lines and lines starting with '#' are skipped.
+ * Relative paths are taken from the directory of the manifest.
+ * @throws FileReadException if the manifest can't be read, or a sample is
+ * malformed or given twice.
+ */
+auto readManifest(const std::filesystem::path& manifest_file)
+    -> std::vector<BatchSample>;
+
+/// A sample recorded as finished in the journal.
+struct JournalEntry {
+   std::string sample;
+   /// Identity of the inputs the sample was deconvolved with
+   std::uint64_t input_identity{};
+   /// Hash of the output as it was written (see contentHash())
+   std::uint64_t output_hash{};
+   std::filesystem::path out_path;
+};
+
+/**
+ * @brief Append only record of the samples a batch run has finished.
+ *
+ * A line is appended (and synced to disk) once the output of a sample is
+ * fully written, so a run killed part way through loses at most the sample
+ * it was working on. Lines are "sample, input identity, output hash, output
+ * path" (tab separated, hashes in hex). A run killed while appending leaves
+ * a line without its newline, which is ignored. Later lines of a sample
+ * replace earlier ones.
+ */
+class BatchJournal {
+  public:
+   /// Opens the journal at the given path, reading any entries already in
+   /// it (the file is created on the first record()).
+   explicit BatchJournal(std::filesystem::path journal_file);
+
+   /**
+    * Whether the sample was finished with the same inputs and its output is
+    * still intact (it exists and hashes to the recorded value).
+    */
+   [[nodiscard]] auto isComplete(const std::string& sample,
+                                 std::uint64_t input_identity) const -> bool;
+
+   /// Appends the entry to the journal.
+   /// @throws FileWriteException if it can't be written and synced
+   void record(const JournalEntry& entry);
+
+   [[nodiscard]] auto entries() const
+       -> const std::unordered_map<std::string, JournalEntry>& {
+      return m_entries;
+   }
+
+  private:
+   std::filesystem::path m_journal_file;
+   std::unordered_map<std::string, JournalEntry> m_entries;
+   /// The journal ends in a line cut short, which the next entry must not
+   /// be appended to.
+   bool m_torn_tail{false};
+};
+
+/// FNV-1a hash of the bytes.
+auto contentHash(std::string_view bytes) -> std::uint64_t;
+
+/// Hashes the contents of a file (see contentHash()). Returns 0 if it can't
+/// be read.
+auto fileHash(const std::filesystem::path& file_path) -> std::uint64_t;
+
+/**
+ * Writes the buffer to a temporary file next to out_path, syncs it and
+ * renames it over out_path. Readers (and restarts) therefore see either the
+ * previous file or the complete new one, never a part written file.
+ * @throws FileWriteException if any step fails
+ */
+void commitFile(std::string_view buffer,
+                const std::filesystem::path& out_path);
+}  // namespace Hylord::IO
+
+#endif
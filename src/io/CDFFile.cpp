@@ -0,0 +1,147 @@
+/**
+ * @file    CDFFile.cpp
+ * @brief   Defines fitting, writing and reading of the methylation CDFs that
+ * novel cell type profiles are drawn from.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "io/CDFFile.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "HylordException.hpp"
+#include "io/ParseStatistics.hpp"
+#include "random/rng.hpp"
+#include "types.hpp"
+
+namespace Hylord::IO {
+namespace {
+constexpr double percent{100.0};
+/// Levels are written with 6 significant digits
+constexpr double level_tolerance{1e-3};
+constexpr double cumulative_tolerance{1e-6};
+constexpr int cumulative_precision{8};
+
+auto levelOf(std::size_t point, std::size_t points) -> double {
+   return percent * static_cast<double>(point) /
+          static_cast<double>(points - 1);
+}
+
+/// Checks a CDF read from a file, making its last value exactly 1.
+void validate(const std::filesystem::path& cdf_file,
+              char mark,
+              const std::vector<std::pair<double, double>>& points,
+              RNG::CDF& cdf) {
+   const std::string location{"CDF of mark '" + std::string(1, mark) + "'"};
+   if (points.size() < 2) {
+      throw FileReadException(cdf_file.string(),
+                              location + " needs at least two levels.");
+   }
+   double previous{0.0};
+   for (std::size_t point{}; point < points.size(); ++point) {
+      const auto [level, cumulative]{points[point]};
+      if (std::abs(level - levelOf(point, points.size())) > level_tolerance) {
+         throw FileReadException(
+             cdf_file.string(),
+             location + " should have evenly spaced levels from 0 to 100.");
+      }
+      if (cumulative < previous || cumulative > 1.0 + cumulative_tolerance) {
+         throw FileReadException(
+             cdf_file.string(),
+             location + " should increase from 0 to 1 with each level.");
+      }
+      previous = cumulative;
+      cdf.push_back(cumulative);
+   }
+   if (std::abs(cdf.back() - 1.0) > cumulative_tolerance) {
+      throw FileReadException(cdf_file.string(),
+                              location + " should end at 1.");
+   }
+   cdf.back() = 1.0;
+}
+}  // namespace
+
+auto fitCDF(const MarkHistograms& histograms, int bins) -> RNG::CDF {
+   if (histograms.rows == 0 || bins < 1) return {};
+   std::vector<std::uint64_t> counts(static_cast<std::size_t>(bins) + 1);
+   for (std::size_t bin{}; bin < histograms.proportion.size(); ++bin) {
+      const auto level{static_cast<std::size_t>(std::lround(
+          static_cast<double>(bin) * bins /
+          static_cast<double>(ParseStatistics::proportion_bins - 1)))};
+      counts[level] += histograms.proportion[bin];
+   }
+   RNG::CDF cdf{};
+   cdf.reserve(counts.size());
+   std::uint64_t cumulative{};
+   for (const std::uint64_t count : counts) {
+      cumulative += count;
+      cdf.push_back(static_cast<double>(cumulative) /
+                    static_cast<double>(histograms.rows));
+   }
+   cdf.back() = 1.0;
+   return cdf;
+}
+
+auto formatCDFs(const std::vector<MarkCDF>& cdfs) -> std::string {
+   std::ostringstream output;
+   output << "mark\tmethylation\tcumulative\n"
+          << std::setprecision(cumulative_precision);
+   for (const auto& [mark, cdf] : cdfs) {
+      for (std::size_t point{}; point < cdf.size(); ++point) {
+         output << mark << '\t' << levelOf(point, cdf.size()) << '\t'
+                << cdf[point] << '\n';
+      }
+   }
+   return output.str();
+}
+
+auto readCDFs(const std::filesystem::path& cdf_file) -> RNG::CDFs {
+   std::ifstream file(cdf_file);
+   if (!file) {
+      throw FileReadException(cdf_file.string(), "Failed to open CDF file.");
+   }
+   std::map<char, std::vector<std::pair<double, double>>> points{};
+   std::string line;
+   int line_number{};
+   while (std::getline(file, line)) {
+      ++line_number;
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (line.empty() || line.starts_with('#') || line.starts_with("mark")) {
+         continue;
+      }
+      std::istringstream fields{line};
+      std::string mark;
+      double level{};
+      double cumulative{};
+      if (!(fields >> mark >> level >> cumulative) || mark.size() != 1 ||
+          (mark[0] != 'm' && mark[0] != 'h')) {
+         throw FileReadException(
+             cdf_file.string(),
+             "Line " + std::to_string(line_number) +
+                 " should hold a mark (m or h), a methylation level and a "
+                 "cumulative proportion.");
+      }
+      points[mark[0]].emplace_back(level, cumulative);
+   }
+
+   RNG::CDFs cdfs{};
+   for (const auto& [mark, mark_points] : points) {
+      RNG::CDF cdf{};
+      validate(cdf_file, mark, mark_points, cdf);
+      (mark == 'm' ? cdfs.methylation : cdfs.hydroxymethylation) =
+          std::move(cdf);
+   }
+   return cdfs;
+}
+}  // namespace Hylord::IO
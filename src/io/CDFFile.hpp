@@ -0,0 +1,46 @@
+#ifndef CDF_FILE_H_
+#define CDF_FILE_H_
+
+/**
+ * @file    CDFFile.hpp
+ * @brief   Declares fitting, writing and reading of the methylation CDFs that
+ * novel cell type profiles are drawn from (see the fit-cdf subcommand).
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "io/ParseStatistics.hpp"
+#include "random/rng.hpp"
+#include "types.hpp"
+
+namespace Hylord::IO {
+/// A fitted CDF and the mark it was fitted to.
+using MarkCDF = std::pair<char, RNG::CDF>;
+
+/**
+ * Fits a CDF (in the format of RNG::methylation_cdf) to the methylation
+ * histogram of a mark. The CDF has bins + 1 evenly spaced levels from 0 to
+ * 100%, percentages are rounded to the nearest level. Returns an empty CDF
+ * if the mark has no rows.
+ */
+auto fitCDF(const MarkHistograms& histograms, int bins) -> RNG::CDF;
+
+/// Formats CDFs as "mark, methylation (%), cumulative proportion" rows (tab
+/// separated, after a header), as read by readCDFs().
+auto formatCDFs(const std::vector<MarkCDF>& cdfs) -> std::string;
+
+/**
+ * Reads CDFs written by the fit-cdf subcommand (see formatCDFs()). Marks
+ * missing from the file keep the built in CDF.
+ * @throws FileReadException if the file can't be read, or a CDF is of an
+ * unknown mark, unevenly spaced, decreasing or doesn't end at 1.
+ */
+auto readCDFs(const std::filesystem::path& cdf_file) -> RNG::CDFs;
+}  // namespace Hylord::IO
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * @file    Chunking.cpp
+ * @brief   Defines how memory mapped files are split for parallel parsing.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "io/Chunking.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "io/SidecarIndex.hpp"
+#include "types.hpp"
+
+namespace Hylord::IO {
+namespace {
+using ByteRange = std::pair<std::uint64_t, std::uint64_t>;
+
+/// Smallest chunk worth handing to another thread. Inputs smaller than this
+/// are parsed in a single chunk on the calling thread.
+constexpr std::size_t min_chunk_bytes{std::size_t{256} << 10U};
+
+/**
+ * Locates the nearest newline character after the approximate chunk end to
+ * ensure complete records in each chunk. Returns file end if no newline found.
+ */
+auto findChunkEnd(const char* start,
+                  std::ptrdiff_t size,
+                  const char* file_end) -> const char* {
+   const char* approximate_end{start + size};
+   if (approximate_end >= file_end) return file_end;
+   return findLineEnd(approximate_end, file_end);
+}
+
+/**
+ * Without a sidecar index, the file is divided evenly by chunk count and each
+ * chunk is extended to the next newline.
+ */
+auto scannedChunks(MapRange map_range, int chunks) -> std::vector<MapRange> {
+   std::vector<MapRange> chunk_ranges{};
+   auto chunk_size{(map_range.end - map_range.start) / chunks};
+   const char* chunk_start{map_range.start};
+
+   for (int i{0}; i < chunks; ++i) {
+      const char* chunk_end{
+          (i == chunks - 1)
+              ? map_range.end
+              : findChunkEnd(chunk_start, chunk_size, map_range.end)};
+      chunk_ranges.push_back({chunk_start, chunk_end});
+      chunk_start = chunk_end + 1;
+   }
+   return chunk_ranges;
+}
+
+/// Byte ranges of the file overlapping the key ranges (merged and sorted).
+auto overlappingByteRanges(const SidecarIndex& index,
+                           const KeyRanges& key_ranges)
+    -> std::vector<ByteRange> {
+   std::vector<ByteRange> byte_ranges{};
+   for (const auto& key_range : key_ranges) {
+      byte_ranges.push_back(index.byteRange(key_range));
+   }
+   std::ranges::sort(byte_ranges);
+   std::vector<ByteRange> merged{};
+   for (const auto& range : byte_ranges) {
+      if (range.first == range.second) continue;
+      if (!merged.empty() && range.first <= merged.back().second) {
+         merged.back().second = std::max(merged.back().second, range.second);
+      } else {
+         merged.push_back(range);
+      }
+   }
+   return merged;
+}
+
+/**
+ * For sorted files with requested key ranges, the byte ranges overlapping
+ * those key ranges are found via the index. Otherwise the whole file is used.
+ * Chunks are shared between byte ranges in proportion to their size and each
+ * byte range is split at indexed line starts (preferring contig boundaries,
+ * see SidecarIndex::chunkBoundaries).
+ */
+auto indexedChunks(MapRange map_range,
+                   int chunks,
+                   const SidecarIndex& index,
+                   const KeyRanges& key_ranges) -> std::vector<MapRange> {
+   std::vector<ByteRange> byte_ranges{};
+   if (!key_ranges.empty() && index.isSorted()) {
+      byte_ranges = overlappingByteRanges(index, key_ranges);
+   } else {
+      byte_ranges.emplace_back(
+          0, static_cast<std::uint64_t>(map_range.end - map_range.start));
+   }
+
+   std::uint64_t total_bytes{};
+   for (const auto& [begin, end] : byte_ranges) total_bytes += end - begin;
+
+   std::vector<MapRange> chunk_ranges{};
+   for (const auto& [begin, end] : byte_ranges) {
+      const double range_fraction{
+          static_cast<double>(end - begin) /
+          static_cast<double>(std::max<std::uint64_t>(total_bytes, 1))};
+      const auto range_chunks{static_cast<int>(
+          std::llround(static_cast<double>(chunks) * range_fraction))};
+      const auto boundaries{
+          index.chunkBoundaries(begin, end, std::max(range_chunks, 1))};
+      for (std::size_t i{1}; i < boundaries.size(); ++i) {
+         chunk_ranges.push_back({map_range.start + boundaries[i - 1],
+                                 map_range.start + boundaries[i]});
+      }
+   }
+   return chunk_ranges;
+}
+}  // namespace
+
+auto findLineEnd(const char* from, const char* end) -> const char* {
+   if (from >= end) return end;
+   const char* line_end{static_cast<const char*>(
+       memchr(from, '\n', static_cast<std::size_t>(end - from)))};
+   return (line_end != nullptr) ? line_end : end;
+}
+
+auto splitIntoChunks(MapRange map_range,
+                     int chunks,
+                     const std::optional<SidecarIndex>& index,
+                     const KeyRanges& key_ranges) -> std::vector<MapRange> {
+   const auto bytes{static_cast<std::size_t>(map_range.end - map_range.start)};
+   chunks = static_cast<int>(
+       std::clamp<std::size_t>(bytes / min_chunk_bytes,
+                               1,
+                               static_cast<std::size_t>(std::max(chunks, 1))));
+   if (index) return indexedChunks(map_range, chunks, *index, key_ranges);
+   return scannedChunks(map_range, chunks);
+}
+}  // namespace Hylord::IO
@@ -0,0 +1,38 @@
+#ifndef CHUNKING_H_
+#define CHUNKING_H_
+
+/**
+ * @file    Chunking.hpp
+ * @brief   Declares how memory mapped files are split for parallel parsing.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <optional>
+#include <vector>
+
+#include "io/SidecarIndex.hpp"
+#include "types.hpp"
+
+namespace Hylord::IO {
+/// Finds the first newline at or after `from` (or `end` if there is none).
+auto findLineEnd(const char* from, const char* end) -> const char*;
+
+/**
+ * Splits a memory mapped file into line aligned chunks that can be parsed
+ * independently. Chunks never split a line, and are at least a few hundred
+ * KiB (so small files give a single chunk).
+ *
+ * @param map_range The mapped file (or the part of it) to split.
+ * @param chunks The desired number of chunks (usually the thread count).
+ * @param index Sidecar index of the file, if one is available.
+ * @param key_ranges Key ranges that are needed (empty for the whole file).
+ * Only used when the index shows the file is sorted.
+ */
+auto splitIntoChunks(MapRange map_range,
+                     int chunks,
+                     const std::optional<SidecarIndex>& index,
+                     const KeyRanges& key_ranges) -> std::vector<MapRange>;
+}  // namespace Hylord::IO
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef DECIMAL_PARSING_H_
+#define DECIMAL_PARSING_H_
+
+/**
+ * @file    DecimalParsing.hpp
+ * @brief   Defines fast conversion of fixed format decimals to doubles.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "simd/Dispatch.hpp"
+
+namespace Hylord::IO {
+/// A decimal number parsed from text, and where its text ended.
+struct ParsedDecimal {
+   double value{};
+   const char* end{};
+};
+
+namespace Decimal {
+/// Integers with at most this many digits are exactly representable.
+inline constexpr int max_exact_digits{15};
+inline constexpr std::array<double, 23> powers_of_ten{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+inline constexpr std::array<std::uint64_t, 9> digit_scales{
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+/// Loads up to 8 bytes (zero padded), never reading at or beyond `end`.
+inline auto loadBytes(const char* cursor, const char* end) -> std::uint64_t {
+   std::uint64_t bytes{};
+   const auto available{static_cast<std::size_t>(end - cursor)};
+   if (available >= sizeof(bytes)) {
+      std::memcpy(&bytes, cursor, sizeof(bytes));
+   } else {
+      std::memcpy(&bytes, cursor, available);
+   }
+   return bytes;
+}
+
+/**
+ * Number of ASCII digits at the start of 8 bytes (first character in the
+ * lowest byte). A byte is a digit if its high nibble is 3 and adding 6 doesn't
+ * carry into that nibble (i.e. it lies in '0'..'9').
+ */
+inline auto leadingDigits(std::uint64_t bytes) -> int {
+   constexpr std::uint64_t high_nibbles{0xF0F0F0F0F0F0F0F0};
+   constexpr std::uint64_t zeros{0x3030303030303030};
+   constexpr std::uint64_t sixes{0x0606060606060606};
+   const std::uint64_t non_digits{((bytes & high_nibbles) ^ zeros) |
+                                  (((bytes + sixes) & high_nibbles) ^ zeros)};
+   return non_digits == 0 ? 8 : std::countr_zero(non_digits) / 8;
+}
+
+/**
+ * Converts the first `count` (1-8) digits held in 8 bytes to an integer,
+ * combining pairs, then quads, then octets of digits with three multiplies.
+ */
+inline auto digitsToInteger(std::uint64_t bytes, int count) -> std::uint64_t {
+   std::uint64_t digits{bytes - 0x3030303030303030};
+   // Moves the digits to the top, so missing digits act as leading zeros
+   digits <<= 8 * static_cast<unsigned>(8 - count);
+   digits = ((digits & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+   digits = ((digits & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+   return ((digits & 0x0000FFFF0000FFFF) * 42949672960001) >> 32;
+}
+
+/**
+ * Accumulates a run of digits into `mantissa`. Returns the number of digits
+ * consumed (stopping early if more than max_exact_digits are seen).
+ */
+inline auto accumulateDigits(const char*& cursor,
+                             const char* readable_end,
+                             std::uint64_t& mantissa) -> int {
+   int total{};
+   while (cursor < readable_end && total <= max_exact_digits) {
+      const std::uint64_t bytes{loadBytes(cursor, readable_end)};
+      const int count{leadingDigits(bytes)};
+      if (count == 0) break;
+      mantissa = mantissa * digit_scales[static_cast<std::size_t>(count)] +
+                 digitsToInteger(bytes, count);
+      cursor += count;
+      total += count;
+      if (count < 8) break;
+   }
+   return total;
+}
+
+/**
+ * Parses a fixed format decimal (`[-]ddd[.ddd]`, as written by modkit and most
+ * tools) starting at `cursor`, eight digits at a time. This is the portable
+ * variant of parseFixedDecimal(), which the others fall back on near the end
+ * of readable memory.
+ *
+ * Integer and fractional digits are gathered into a single integer which is
+ * then divided by a power of ten. With at most 15 significant digits both are
+ * exact, so the (correctly rounded) division gives the same double as
+ * std::strtod. Anything else (exponents, very long numbers, no digits) returns
+ * std::nullopt so the caller can fall back to parseDecimal().
+ *
+ * @param readable_end End of readable memory. Bytes up to here may be read,
+ * even if they are past the end of the number.
+ */
+inline auto parseFixedDecimalScalar(const char* cursor,
+                                    const char* readable_end)
+    -> std::optional<ParsedDecimal> {
+   if constexpr (std::endian::native != std::endian::little) {
+      return std::nullopt;
+   }
+   const bool negative{cursor < readable_end && *cursor == '-'};
+   if (negative) ++cursor;
+
+   std::uint64_t mantissa{};
+   int digits{accumulateDigits(cursor, readable_end, mantissa)};
+   int fraction_digits{};
+   if (cursor < readable_end && *cursor == '.') {
+      ++cursor;
+      fraction_digits = accumulateDigits(cursor, readable_end, mantissa);
+      digits += fraction_digits;
+   }
+   if (digits == 0 || digits > max_exact_digits) return std::nullopt;
+   if (cursor < readable_end && (*cursor == 'e' || *cursor == 'E')) {
+      return std::nullopt;
+   }
+
+   double value{static_cast<double>(mantissa) /
+                powers_of_ten[static_cast<std::size_t>(fraction_digits)]};
+   return ParsedDecimal{.value = negative ? -value : value, .end = cursor};
+}
+}  // namespace Decimal
+
+/**
+ * Parses a fixed format decimal (`[-]ddd[.ddd]`) starting at `cursor`, using
+ * the variant for the instruction set selected at startup (see
+ * Simd::kernels()). All variants give the same value as std::strtod.
+ *
+ * @param readable_end End of readable memory. Bytes up to here may be read,
+ * even if they are past the end of the number.
+ * @return std::nullopt if the text is in another format (see
+ * Decimal::parseFixedDecimalScalar()).
+ */
+inline auto parseFixedDecimal(const char* cursor, const char* readable_end)
+    -> std::optional<ParsedDecimal> {
+   double value{};
+   const char* end{
+       Simd::kernels().parse_fixed_decimal(cursor, readable_end, value)};
+   if (end == nullptr) return std::nullopt;
+   return ParsedDecimal{.value = value, .end = end};
+}
+
+/**
+ * Parses the number occupying all of [begin, end), using parseFixedDecimal()
+ * where possible and std::from_chars otherwise.
+ *
+ * @throws std::invalid_argument if [begin, end) is not a number.
+ */
+inline auto parseDecimal(const char* begin, const char* end) -> double {
+   const auto parsed{parseFixedDecimal(begin, end)};
+   if (parsed && parsed->end == end) return parsed->value;
+   double value{};
+   auto [number_end, error]{std::from_chars(begin, end, value)};
+   if (error != std::errc{} || number_end != end || begin == end) {
+      throw std::invalid_argument("Could not convert '" +
+                                  std::string(begin, end) + "' to a number.");
+   }
+   return value;
+}
+}  // namespace Hylord::IO
+
+#endif
@@ -3,7 +3,10 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstddef>
 #include <filesystem>
+#include <string_view>
 
 #include "HylordException.hpp"
 
@@ -38,4 +41,14 @@ void FileDescriptor::teardown() {
    }
 }
 
+auto writeAll(int file_descriptor, std::string_view buffer) -> bool {
+   while (!buffer.empty()) {
+      const ssize_t written{
+          ::write(file_descriptor, buffer.data(), buffer.size())};
+      if (written == -1 && errno == EINTR) continue;
+      if (written <= 0) return false;
+      buffer.remove_prefix(static_cast<std::size_t>(written));
+   }
+   return true;
+}
 }  // namespace Hylord::IO
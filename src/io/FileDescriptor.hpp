@@ -6,6 +6,7 @@
 
 #include <cstddef>
 #include <filesystem>
+#include <string_view>
 #include <utility>
 
 namespace Hylord::IO {
@@ -50,6 +51,9 @@ class FileDescriptor {
    void teardown();
 };
 
+/// Writes all of the buffer to an open file descriptor, retrying interrupted
+/// and partial writes. Returns false if a write fails.
+auto writeAll(int file_descriptor, std::string_view buffer) -> bool;
 }  // namespace Hylord::IO
 
 #endif
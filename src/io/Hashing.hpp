@@ -0,0 +1,32 @@
+#ifndef HASHING_H_
+#define HASHING_H_
+
+/**
+ * @file    Hashing.hpp
+ * @brief   Defines the FNV-1a hash used to identify inputs and outputs (see
+ * referenceIdentity() and contentHash()).
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Hylord::IO {
+/// Value a running FNV-1a hash starts from.
+inline constexpr std::uint64_t fnv_offset_basis{14695981039346656037ULL};
+
+/// Folds bytes into a running FNV-1a hash.
+inline void hashBytes(std::uint64_t& hash,
+                      const void* data,
+                      std::size_t size) {
+   constexpr std::uint64_t prime{1099511628211ULL};
+   const auto* bytes{static_cast<const unsigned char*>(data)};
+   for (std::size_t i{}; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= prime;
+   }
+}
+}  // namespace Hylord::IO
+
+#endif
@@ -1,14 +1,43 @@
 #include "io/MemoryMap.hpp"
 
 #include <sys/mman.h>
+#include <unistd.h>
 
 #include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <system_error>
 
 #include "io/FileDescriptor.hpp"
 
 namespace Hylord::IO {
-void MemoryMap::setup(const FileDescriptor& file_descriptor) {
+void MemoryMap::readWhole(const FileDescriptor& file_descriptor) {
+   m_buffer = std::make_unique_for_overwrite<char[]>(m_size);
+   std::size_t bytes_read{};
+   while (bytes_read < m_size) {
+      const ssize_t result{pread(file_descriptor.fileDescriptor(),
+                                 m_buffer.get() + bytes_read,
+                                 m_size - bytes_read,
+                                 static_cast<off_t>(bytes_read))};
+      if (result == -1 && errno == EINTR) continue;
+      if (result <= 0) {
+         const int error_number{result == 0 ? EIO : errno};
+         m_buffer.reset();
+         throw std::system_error(
+             error_number, std::system_category(), "Reading file failed");
+      }
+      bytes_read += static_cast<std::size_t>(result);
+   }
+   m_mapped_data = m_buffer.get();
+}
+
+void MemoryMap::setup(const FileDescriptor& file_descriptor,
+                      std::size_t read_threshold) {
    m_size = file_descriptor.fileSize();
+   if (m_size <= read_threshold) {
+      readWhole(file_descriptor);
+      return;
+   }
    m_mapped_data = mmap(nullptr,
                         m_size,
                         PROT_READ,
@@ -22,8 +51,31 @@ void MemoryMap::setup(const FileDescriptor& file_descriptor) {
    madvise(m_mapped_data, m_size, MADV_SEQUENTIAL | MADV_WILLNEED);
 }
 
+/**
+ * Only whole pages inside the range are released. Streaming readers call this
+ * on parts of the file they have finished with, so resident memory stays
+ * bounded for files far larger than RAM.
+ */
+void MemoryMap::discard(const char* begin, const char* end) const noexcept {
+   if (!valid() || m_buffer || end <= begin) return;
+   const auto page_size{static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE))};
+   const auto first_page{(reinterpret_cast<std::uintptr_t>(begin) +
+                          page_size - 1) &
+                         ~(page_size - 1)};
+   const auto last_page{reinterpret_cast<std::uintptr_t>(end) &
+                        ~(page_size - 1)};
+   if (last_page <= first_page) return;
+   madvise(reinterpret_cast<void*>(first_page),
+           last_page - first_page,
+           MADV_DONTNEED);
+}
+
 void MemoryMap::teardown() noexcept {
-   if (valid()) {
+   if (m_buffer) {
+      m_buffer.reset();
+      m_mapped_data = MAP_FAILED;
+      m_size = 0;
+   } else if (valid()) {
       munmap(m_mapped_data, m_size);
       m_mapped_data = MAP_FAILED;
       m_size = 0;
@@ -4,14 +4,25 @@
 #include <sys/mman.h>
 
 #include <cstddef>
+#include <memory>
 #include <utility>
 
 #include "io/FileDescriptor.hpp"
 namespace Hylord::IO {
+/**
+ * Read-only view of a whole file. Files up to `read_threshold` bytes (8 MiB
+ * by default) are read into memory with a single read() instead of being
+ * mapped, as for small inputs (e.g. targeted panels) setting up and tearing
+ * down the mapping costs more than copying the file.
+ */
 class MemoryMap {
   public:
-   explicit MemoryMap(const FileDescriptor& file_descriptor) {
-      setup(file_descriptor);
+   static constexpr std::size_t default_read_threshold{std::size_t{8}
+                                                       << 20U};
+
+   explicit MemoryMap(const FileDescriptor& file_descriptor,
+                      std::size_t read_threshold = default_read_threshold) {
+      setup(file_descriptor, read_threshold);
    }
    ~MemoryMap() { teardown(); }
    MemoryMap(const MemoryMap&) = delete;
@@ -19,13 +30,15 @@ class MemoryMap {
 
    MemoryMap(MemoryMap&& other) noexcept :
        m_mapped_data(std::exchange(other.m_mapped_data, MAP_FAILED)),
-       m_size(std::exchange(other.m_size, 0)) {}
+       m_size(std::exchange(other.m_size, 0)),
+       m_buffer(std::move(other.m_buffer)) {}
 
    auto operator=(MemoryMap&& other) noexcept -> MemoryMap& {
       if (this != &other) {
          teardown();
-         m_mapped_data = std::exchange(other.m_mapped_data, nullptr);
+         m_mapped_data = std::exchange(other.m_mapped_data, MAP_FAILED);
          m_size = std::exchange(other.m_size, 0);
+         m_buffer = std::move(other.m_buffer);
       }
       return *this;
    }
@@ -37,11 +50,18 @@ class MemoryMap {
       return static_cast<char*>(m_mapped_data);
    }
    [[nodiscard]] auto size() const -> std::size_t { return m_size; }
+   /// Tells the kernel that [begin, end) of the mapping won't be read again
+   /// (files that were read are left alone).
+   void discard(const char* begin, const char* end) const noexcept;
 
   private:
    void* m_mapped_data{MAP_FAILED};
    std::size_t m_size{};
-   void setup(const FileDescriptor& file_descriptor);
+   /// Holds the file when it was read rather than mapped
+   std::unique_ptr<char[]> m_buffer{};
+   void setup(const FileDescriptor& file_descriptor,
+              std::size_t read_threshold);
+   void readWhole(const FileDescriptor& file_descriptor);
    void teardown() noexcept;
 };
 
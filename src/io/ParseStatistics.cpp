@@ -0,0 +1,139 @@
+/**
+ * @file    ParseStatistics.cpp
+ * @brief   Defines histograms of read depth and methylation, gathered whilst
+ * methylation files are parsed.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "io/ParseStatistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Hylord::IO {
+namespace {
+constexpr double percent{100.0};
+
+/// Marks are single characters, unnamed rows are shown as '.'.
+auto markLabel(char mark) -> std::string {
+   return std::string(1, mark == '\0' ? '.' : mark);
+}
+
+auto mean(double sum, std::uint64_t rows) -> double {
+   return rows == 0 ? 0.0 : sum / static_cast<double>(rows);
+}
+}  // namespace
+
+auto ParseStatistics::histogramsOf(char mark) -> MarkHistograms& {
+   for (auto& histograms : m_marks) {
+      if (histograms.mark == mark) return histograms;
+   }
+   MarkHistograms& histograms{m_marks.emplace_back()};
+   histograms.mark = mark;
+   histograms.depth.resize(max_depth + 1);
+   histograms.proportion.resize(proportion_bins);
+   return histograms;
+}
+
+auto ParseStatistics::find(char mark) const -> const MarkHistograms* {
+   const auto histograms{
+       std::ranges::find(m_marks, mark, &MarkHistograms::mark)};
+   return histograms == m_marks.end() ? nullptr : &*histograms;
+}
+
+void ParseStatistics::add(char mark,
+                          int read_depth,
+                          double methylation_proportion) {
+   MarkHistograms& histograms{histogramsOf(mark)};
+   const int depth{std::clamp(read_depth, 0, max_depth)};
+   const auto proportion_bin{static_cast<std::size_t>(std::clamp(
+       std::lround(methylation_proportion * percent), 0L, 100L))};
+   ++histograms.rows;
+   histograms.depth_sum += static_cast<std::uint64_t>(std::max(read_depth, 0));
+   histograms.proportion_sum += methylation_proportion;
+   ++histograms.depth[static_cast<std::size_t>(depth)];
+   ++histograms.proportion[proportion_bin];
+}
+
+void ParseStatistics::merge(const ParseStatistics& other) {
+   for (const auto& from : other.m_marks) {
+      MarkHistograms& into{histogramsOf(from.mark)};
+      into.rows += from.rows;
+      into.depth_sum += from.depth_sum;
+      into.proportion_sum += from.proportion_sum;
+      std::ranges::transform(
+          into.depth, from.depth, into.depth.begin(), std::plus{});
+      std::ranges::transform(into.proportion,
+                             from.proportion,
+                             into.proportion.begin(),
+                             std::plus{});
+   }
+}
+
+auto ParseStatistics::tagged(char mark) const -> ParseStatistics {
+   ParseStatistics statistics{};
+   for (const auto& histograms : m_marks) {
+      ParseStatistics relabelled{};
+      relabelled.m_marks.push_back(histograms);
+      relabelled.m_marks.back().mark = mark;
+      statistics.merge(relabelled);
+   }
+   return statistics;
+}
+
+auto ParseStatistics::depthQuantile(char mark, double quantile) const -> int {
+   const MarkHistograms* histograms{find(mark)};
+   if (histograms == nullptr || histograms->rows == 0) return 0;
+   const auto target{std::max<std::uint64_t>(
+       1,
+       static_cast<std::uint64_t>(
+           std::ceil(quantile * static_cast<double>(histograms->rows))))};
+   std::uint64_t cumulative{};
+   for (std::size_t depth{}; depth < histograms->depth.size(); ++depth) {
+      cumulative += histograms->depth[depth];
+      if (cumulative >= target) return static_cast<int>(depth);
+   }
+   return max_depth;
+}
+
+void ParseStatistics::write(std::ostream& output) const {
+   constexpr double lower{0.01};
+   constexpr double median{0.5};
+   constexpr double upper{0.99};
+   output << "mark\trows\tmean_depth\tdepth_p1\tdepth_median\tdepth_p99\t"
+             "mean_methylation\n";
+   for (const auto& histograms : m_marks) {
+      output << markLabel(histograms.mark) << '\t' << histograms.rows << '\t'
+             << mean(static_cast<double>(histograms.depth_sum),
+                     histograms.rows)
+             << '\t' << depthQuantile(histograms.mark, lower) << '\t'
+             << depthQuantile(histograms.mark, median) << '\t'
+             << depthQuantile(histograms.mark, upper) << '\t'
+             << mean(histograms.proportion_sum, histograms.rows) * percent
+             << '\n';
+   }
+
+   output << "\nhistogram\tmark\tbin\trows\n";
+   for (const auto& histograms : m_marks) {
+      const std::string label{markLabel(histograms.mark)};
+      for (std::size_t depth{}; depth < histograms.depth.size(); ++depth) {
+         if (histograms.depth[depth] == 0) continue;
+         output << "depth\t" << label << '\t' << depth
+                << (depth == max_depth ? "+" : "") << '\t'
+                << histograms.depth[depth] << '\n';
+      }
+      for (std::size_t bin{}; bin < histograms.proportion.size(); ++bin) {
+         if (histograms.proportion[bin] == 0) continue;
+         output << "methylation\t" << label << '\t' << bin << '\t'
+                << histograms.proportion[bin] << '\n';
+      }
+   }
+}
+}  // namespace Hylord::IO
@@ -0,0 +1,85 @@
+#ifndef PARSE_STATISTICS_H_
+#define PARSE_STATISTICS_H_
+
+/**
+ * @file    ParseStatistics.hpp
+ * @brief   Declares histograms of read depth and methylation, gathered whilst
+ * methylation files are parsed (see TSVFileReader::collectStatistics).
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace Hylord::IO {
+/// Which rows of a file statistics are gathered from.
+enum class CountedRows {
+   /// Every row that parses, including those the row filter drops
+   parsed,
+   /// Only the rows kept by the row filter
+   kept
+};
+
+/// Histograms of the rows of a single mark.
+struct MarkHistograms {
+   char mark{};
+   std::uint64_t rows{};
+   std::uint64_t depth_sum{};
+   double proportion_sum{};
+   /// Rows per read depth, the last bin holding every depth from
+   /// ParseStatistics::max_depth up
+   std::vector<std::uint64_t> depth;
+   /// Rows per percentage point of methylation (0 to 100)
+   std::vector<std::uint64_t> proportion;
+};
+
+/**
+ * @brief Histograms of read depth (the score column) and methylation
+ * proportion, split by mark.
+ *
+ * Each parsing thread fills its own instance, which are merged once parsing
+ * is done, so gathering these costs a few increments per row rather than
+ * another pass over the file.
+ */
+class ParseStatistics {
+  public:
+   /// Depths at or above this share the last bin of the depth histogram.
+   static constexpr int max_depth{1000};
+   static constexpr int proportion_bins{101};
+
+   /// Counts a row of the given mark.
+   void add(char mark, int read_depth, double methylation_proportion);
+   /// Adds the counts of another instance (of the same file).
+   void merge(const ParseStatistics& other);
+   /// The counts with every mark relabelled as the given mark, for files
+   /// holding a single mark (see BedRecords::BedGraph).
+   [[nodiscard]] auto tagged(char mark) const -> ParseStatistics;
+
+   [[nodiscard]] auto empty() const -> bool { return m_marks.empty(); }
+   /// Histograms of each mark seen, in the order the marks were first seen.
+   [[nodiscard]] auto marks() const -> const std::vector<MarkHistograms>& {
+      return m_marks;
+   }
+   /// Smallest depth that at least the given fraction of the mark's rows
+   /// are at or below (0 if there are no rows of the mark).
+   [[nodiscard]] auto depthQuantile(char mark, double quantile) const -> int;
+
+   /**
+    * Writes the QC report: a summary row per mark (rows, mean depth, 1st,
+    * 50th and 99th percentile depth and mean methylation percentage), then
+    * the non-empty bins of each histogram. Both tables are tab separated with
+    * a header.
+    */
+   void write(std::ostream& output) const;
+
+  private:
+   std::vector<MarkHistograms> m_marks;
+
+   auto histogramsOf(char mark) -> MarkHistograms&;
+   [[nodiscard]] auto find(char mark) const -> const MarkHistograms*;
+};
+}  // namespace Hylord::IO
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef PARSE_WARNINGS_H_
+#define PARSE_WARNINGS_H_
+
+/**
+ * @file    ParseWarnings.hpp
+ * @brief   Defines a thread-safe collector for line conversion warnings.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Hylord::IO {
+/**
+ * @brief Collects warnings for lines that could not be converted into records
+ * whilst a file is parsed in parallel.
+ *
+ * Only the first few messages are kept, the rest are counted and reported as
+ * suppressed.
+ */
+class ParseWarnings {
+  public:
+   /// Records a warning for the given line (safe to call from any thread).
+   void add(std::string_view reason, std::string_view line) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_number_of_warnings++;
+      if (std::ssize(m_messages) >= m_max_messages) return;
+      std::ostringstream oss;
+      oss << "Record conversion warning: " << reason << '\n';
+      if (line.empty()) {
+         oss << "Line was empty.\n";
+      } else {
+         oss << line << '\n';
+      }
+      m_messages.emplace_back(oss.str());
+   }
+
+   /// Prints the collected warnings (if there were any) to stderr.
+   void report(const std::filesystem::path& file_path) const {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_number_of_warnings == 0) return;
+      std::cerr << "===\n"
+                << m_number_of_warnings << " warning"
+                << (m_number_of_warnings > 1 ? "s" : "")
+                << " occurred whilst processing '" << file_path << "'.\n";
+      for (const auto& message : m_messages) std::cerr << message << '\n';
+      std::cerr << "These lines will be skipped.\n";
+      int remaining_messages{m_number_of_warnings - m_max_messages};
+      if (remaining_messages > 0) {
+         std::cerr << remaining_messages << " warning message"
+                   << (remaining_messages > 1 ? "s were" : " was")
+                   << " surpressed.\n"
+                   << "===\n";
+      }
+   }
+
+  private:
+   static constexpr int m_max_messages{5};
+   mutable std::mutex m_mutex;
+   std::vector<std::string> m_messages;
+   int m_number_of_warnings{};
+};
+}  // namespace Hylord::IO
+
+#endif
@@ -0,0 +1,377 @@
+/**
+ * @file    ReferenceMatrixReader.cpp
+ * @brief   Defines a dedicated reader for wide reference matrix files.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "io/ReferenceMatrixReader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "HylordException.hpp"
+#include "data/BedRecords.hpp"
+#include "io/Chunking.hpp"
+#include "io/DecimalParsing.hpp"
+#include "maths/percentage.hpp"
+#include "parallel/Affinity.hpp"
+#include "parallel/ParallelFor.hpp"
+#include "simd/Dispatch.hpp"
+#include "types.hpp"
+
+namespace Hylord::IO {
+namespace {
+constexpr Eigen::Index unselected_column{-1};
+
+/// Raised for lines whose number of cell types differs from the first line.
+class InconsistentWidthError : public std::runtime_error {
+  public:
+   explicit InconsistentWidthError(Eigen::Index cell_types) :
+       std::runtime_error{"Found " + std::to_string(cell_types) +
+                          " cell types on line:"} {}
+};
+
+constexpr auto isDelimiter(char character) -> bool {
+   return character == '\t' || character == ' ';
+}
+
+auto findFieldEnd(const char* cursor, const char* line_end) -> const char* {
+   return Simd::kernels().find_delimiter(cursor, line_end);
+}
+
+/// Ignores the carriage return of files with Windows line endings.
+auto contentEnd(const char* line_start, const char* line_end) -> const char* {
+   return (line_end > line_start && *(line_end - 1) == '\r') ? line_end - 1
+                                                             : line_end;
+}
+}  // namespace
+
+ReferenceMatrixReader::ReferenceMatrixReader(std::filesystem::path file_path,
+                                             RowFilter rowFilter,
+                                             int threads) :
+    m_file_path{std::move(file_path)},
+    m_row_filter{std::move(rowFilter)},
+    m_num_threads{std::max(1, threads)} {}
+
+auto ReferenceMatrixReader::mappedRange() const -> MapRange {
+   if (!m_memory_map.valid())
+      throw FileReadException(m_file_path, "No valid memory mapping.");
+   return {.start = m_memory_map.data(),
+           .end = m_memory_map.data() + m_file_descriptor.fileSize()};
+}
+
+/**
+ * Every field after the first four (chr, start, end, name) is a cell type.
+ * @throws FileReadException if there are no cell type columns.
+ */
+auto ReferenceMatrixReader::countCellTypes(MapRange map_range) const
+    -> Eigen::Index {
+   const char* line_start{map_range.start};
+   while (line_start < map_range.end) {
+      const char* line_end{findLineEnd(line_start, map_range.end)};
+      const char* content_end{contentEnd(line_start, line_end)};
+      if (content_end > line_start) {
+         const auto fields{
+             std::count_if(line_start, content_end, isDelimiter) + 1};
+         constexpr std::ptrdiff_t bed_fields{4};
+         if (fields <= bed_fields) {
+            throw FileReadException(
+                m_file_path,
+                "Reference matrix has no cell type columns (found " +
+                    std::to_string(fields) + " fields on the first line).");
+         }
+         return fields - bed_fields;
+      }
+      line_start = line_end + 1;
+   }
+   throw FileReadException(m_file_path, "File contains no lines.");
+}
+
+/**
+ * Without a selection every column is loaded in file order.
+ * @throws FileReadException if a selected column does not exist or is
+ * selected twice.
+ */
+void ReferenceMatrixReader::resolveColumnTargets() {
+   if (m_selected_columns.empty()) {
+      m_column_targets.resize(static_cast<std::size_t>(m_cell_types));
+      std::iota(m_column_targets.begin(), m_column_targets.end(), 0);
+      return;
+   }
+   m_column_targets.assign(static_cast<std::size_t>(m_cell_types),
+                           unselected_column);
+   for (std::size_t i{}; i < m_selected_columns.size(); ++i) {
+      const std::size_t column{m_selected_columns[i]};
+      if (column >= m_column_targets.size()) {
+         throw FileReadException(
+             m_file_path,
+             "Cell type " + std::to_string(column + 1) +
+                 " was selected, but the reference matrix only has " +
+                 std::to_string(m_cell_types) + " cell types.");
+      }
+      if (m_column_targets[column] != unselected_column) {
+         throw FileReadException(m_file_path,
+                                 "Cell type " + std::to_string(column + 1) +
+                                     " was selected more than once.");
+      }
+      m_column_targets[column] = static_cast<Eigen::Index>(i);
+   }
+}
+
+/**
+ * Splits the four BED fields, applies the row filter and then decodes each
+ * selected cell type value straight into column-major storage. Values in the
+ * usual fixed format are decoded by parseFixedDecimal() without looking for
+ * the end of the field first. Unselected values are only skipped over.
+ *
+ * @throws std::out_of_range if there are too few fields.
+ * @throws std::invalid_argument if a value is not a number.
+ * @throws InconsistentWidthError if the number of values differs from the
+ * first line.
+ */
+auto ReferenceMatrixReader::parseLine(const char* line_start,
+                                      const char* line_end,
+                                      const char* readable_end,
+                                      Eigen::Index row) -> bool {
+   const char* content_end{contentEnd(line_start, line_end)};
+   std::array<std::string_view, 4> bed_fields{};
+   const char* cursor{line_start};
+   for (auto& field : bed_fields) {
+      const char* field_end{findFieldEnd(cursor, content_end)};
+      if (field_end == content_end) {
+         throw std::out_of_range(
+             "Could not parse field, too few fields (expected >=5)");
+      }
+      field = std::string_view(cursor,
+                               static_cast<std::size_t>(field_end - cursor));
+      cursor = field_end + 1;
+   }
+   if (m_row_filter &&
+       !m_row_filter(Fields(bed_fields.begin(), bed_fields.end()))) {
+      return false;
+   }
+
+   BedRecords::Bed4& record{m_records[static_cast<std::size_t>(row)]};
+   record.chromosome = BedRecords::parseChromosomeNumber(bed_fields[0]);
+   const auto [start_end, start_error]{std::from_chars(
+       bed_fields[1].data(),
+       bed_fields[1].data() + bed_fields[1].size(),
+       record.start)};
+   if (start_error != std::errc{}) {
+      throw std::invalid_argument("Could not convert start position '" +
+                                  std::string(bed_fields[1]) + "'.");
+   }
+   record.name = bed_fields[3].empty() ? '\0' : bed_fields[3][0];
+
+   double* row_values{m_proportions.data() + row};
+   const Eigen::Index column_stride{m_proportions.rows()};
+   Eigen::Index cell_type{};
+   while (true) {
+      const Eigen::Index target{
+          cell_type < m_cell_types
+              ? m_column_targets[static_cast<std::size_t>(cell_type)]
+              : unselected_column};
+      const char* field_end{};
+      if (target == unselected_column) {
+         field_end = findFieldEnd(cursor, content_end);
+      } else {
+         double value{};
+         const auto parsed{parseFixedDecimal(cursor, readable_end)};
+         if (parsed &&
+             (parsed->end == content_end || isDelimiter(*parsed->end))) {
+            value = parsed->value;
+            field_end = parsed->end;
+         } else {
+            field_end = findFieldEnd(cursor, content_end);
+            value = parseDecimal(cursor, field_end);
+         }
+         row_values[target * column_stride] =
+             Maths::convertToProportion(value);
+      }
+      ++cell_type;
+      if (field_end >= content_end) break;
+      cursor = field_end + 1;
+   }
+   if (cell_type != m_cell_types) throw InconsistentWidthError(cell_type);
+   return true;
+}
+
+/**
+ * Parses each line of the chunk into consecutive rows from first_row onwards.
+ * Lines that fail to parse generate warnings and are skipped. Parsing stops
+ * at the first line with the wrong number of cell types, as the whole file is
+ * rejected in that case.
+ */
+auto ReferenceMatrixReader::parseChunk(MapRange chunk, Eigen::Index first_row)
+    -> ChunkResult {
+   ChunkResult result{.first_row = first_row};
+   const char* readable_end{mappedRange().end};
+   GenomicKey previous_key{};
+   const char* line_start{chunk.start};
+   while (line_start < chunk.end) {
+      const char* line_end{findLineEnd(line_start, chunk.end)};
+      const Eigen::Index row{first_row + result.rows};
+      try {
+         if (parseLine(line_start, line_end, readable_end, row)) {
+            const GenomicKey key{
+                m_records[static_cast<std::size_t>(row)].key()};
+            if (result.rows > 0 && key < previous_key) result.sorted = false;
+            previous_key = key;
+            ++result.rows;
+         }
+      } catch (const InconsistentWidthError& e) {
+         result.inconsistent_line =
+             std::string(e.what()) + '\n' + std::string(line_start, line_end);
+         return result;
+      } catch (const std::exception& e) {
+         m_warnings.add(e.what(),
+                        std::string_view(line_start,
+                                         static_cast<std::size_t>(
+                                             line_end - line_start)));
+      }
+      line_start = line_end + 1;
+   }
+   return result;
+}
+
+/**
+ * Chunks reserve a row for every line they contain, so filtered or malformed
+ * lines leave gaps at the end of a chunk's rows. The rows are only copied if
+ * there are any such gaps.
+ */
+void ReferenceMatrixReader::compactRows(
+    const std::vector<ChunkResult>& chunk_results) {
+   Eigen::Index total_rows{};
+   bool contiguous{true};
+   for (const auto& result : chunk_results) {
+      if (result.first_row != total_rows) contiguous = false;
+      total_rows += result.rows;
+   }
+   if (contiguous && total_rows == m_proportions.rows()) return;
+
+   std::vector<BedRecords::Bed4> records(static_cast<std::size_t>(total_rows));
+   Matrix proportions(total_rows, m_proportions.cols());
+   Eigen::Index row{};
+   for (const auto& result : chunk_results) {
+      std::copy_n(m_records.begin() + result.first_row,
+                  result.rows,
+                  records.begin() + row);
+      proportions.middleRows(row, result.rows) =
+          m_proportions.middleRows(result.first_row, result.rows);
+      row += result.rows;
+   }
+   m_records = std::move(records);
+   m_proportions = std::move(proportions);
+}
+
+/**
+ * This method:
+ * 1. Counts the cell types on the first line (and resolves the selection)
+ * 2. Divides the memory map into chunks (see splitIntoChunks())
+ * 3. Counts the lines of each chunk, giving each chunk its first row
+ * 4. Parses chunks in parallel into the matrix. The matrix is allocated
+ *    without being written to (and advised to use huge pages), so its pages
+ *    are first touched by the threads parsing into them.
+ * 5. Checks widths and sortedness, then removes gaps left by skipped lines
+ *
+ * @throw HylordException if the file is already loaded.
+ * @throw FileReadException if the file cannot be loaded or lines have
+ * inconsistent numbers of cell types.
+ */
+void ReferenceMatrixReader::load() {
+   if (m_loaded) {
+      throw HylordException("File is already loaded.");
+   }
+   try {
+      const MapRange map_range{mappedRange()};
+      m_cell_types = countCellTypes(map_range);
+      resolveColumnTargets();
+      const std::vector<MapRange> chunks{splitIntoChunks(
+          map_range, m_num_threads, m_index, m_key_ranges)};
+
+      std::vector<Eigen::Index> first_rows(chunks.size() + 1, 0);
+      Parallel::forEachBlock(
+          chunks.size(), m_num_threads, [&](Parallel::Block block) {
+             for (std::size_t i{block.begin}; i < block.end; ++i) {
+                if (chunks[i].start >= chunks[i].end) continue;
+                first_rows[i + 1] =
+                    std::count(chunks[i].start, chunks[i].end, '\n') + 1;
+             }
+          });
+      std::partial_sum(
+          first_rows.begin(), first_rows.end(), first_rows.begin());
+
+      m_records.resize(static_cast<std::size_t>(first_rows.back()));
+      m_proportions.resize(
+          first_rows.back(),
+          m_selected_columns.empty()
+              ? m_cell_types
+              : static_cast<Eigen::Index>(m_selected_columns.size()));
+      Parallel::adviseHugePages(
+          m_proportions.data(),
+          static_cast<std::size_t>(m_proportions.size()) * sizeof(double));
+
+      std::vector<ChunkResult> chunk_results(chunks.size());
+      Parallel::forEachBlock(
+          chunks.size(), m_num_threads, [&](Parallel::Block block) {
+             for (std::size_t i{block.begin}; i < block.end; ++i) {
+                chunk_results[i] = parseChunk(chunks[i], first_rows[i]);
+             }
+          });
+
+      std::optional<GenomicKey> previous_last{};
+      for (const auto& result : chunk_results) {
+         if (result.inconsistent_line) {
+            throw FileReadException(
+                m_file_path,
+                "Inconsistent number of entries in reference matrix. "
+                "Expected " +
+                    std::to_string(m_cell_types) +
+                    " cell types (from the first line). " +
+                    *result.inconsistent_line);
+         }
+         if (result.rows == 0) continue;
+         const auto first{static_cast<std::size_t>(result.first_row)};
+         const auto last{first + static_cast<std::size_t>(result.rows) - 1};
+         if (!result.sorted ||
+             (previous_last && m_records[first].key() < *previous_last)) {
+            m_sorted = false;
+         }
+         previous_last = m_records[last].key();
+      }
+      compactRows(chunk_results);
+      m_loaded = true;
+
+      m_warnings.report(m_file_path);
+   } catch (const std::system_error& e) {
+      throw FileReadException(m_file_path,
+                              "Caught system_error with code " +
+                                  std::to_string(e.code().value()) + " [" +
+                                  e.what() + "].");
+   }
+}
+
+auto ReferenceMatrixReader::extractRecords()
+    -> std::vector<BedRecords::Bed4> {
+   if (!isLoaded()) throw std::runtime_error("No data loaded.");
+   return std::move(m_records);
+}
+
+auto ReferenceMatrixReader::extractProportions() -> Matrix {
+   if (!isLoaded()) throw std::runtime_error("No data loaded.");
+   return std::move(m_proportions);
+}
+}  // namespace Hylord::IO
@@ -0,0 +1,80 @@
+/**
+ * @file    ScratchMatrix.cpp
+ * @brief   Defines a matrix backed by a memory mapped scratch file.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "io/ScratchMatrix.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "HylordException.hpp"
+#include "types.hpp"
+
+namespace Hylord::IO {
+/**
+ * The mapping is advised as sequential, as every pass over the matrix walks
+ * each column from top to bottom (in row blocks). The kernel then reads ahead
+ * of the pass and drops pages behind it early.
+ */
+ScratchMatrix::ScratchMatrix(Eigen::Index rows,
+                             Eigen::Index cols,
+                             const std::filesystem::path& directory) :
+    m_size{static_cast<std::size_t>(rows * cols) * sizeof(double)},
+    m_rows{rows},
+    m_cols{cols} {
+   const std::string file_template{
+       (directory / "hylord-scratch-XXXXXX").string()};
+   std::vector<char> file_name(file_template.begin(), file_template.end());
+   file_name.push_back('\0');
+
+   const int file_descriptor{mkstemp(file_name.data())};
+   if (file_descriptor == -1) {
+      throw FileWriteException(file_template, std::strerror(errno));
+   }
+   unlink(file_name.data());
+   if (m_size == 0) {
+      close(file_descriptor);
+      return;
+   }
+   if (ftruncate(file_descriptor, static_cast<off_t>(m_size)) == -1) {
+      const int error_number{errno};
+      close(file_descriptor);
+      throw FileWriteException(file_name.data(),
+                               std::string{"Failed to resize scratch file: "} +
+                                   std::strerror(error_number));
+   }
+   m_mapped_data = mmap(nullptr,
+                        m_size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED,
+                        file_descriptor,
+                        0);
+   const int error_number{errno};
+   // The mapping keeps the file alive
+   close(file_descriptor);
+   if (m_mapped_data == MAP_FAILED) {
+      throw FileWriteException(file_name.data(),
+                               std::string{"Memory mapping failed: "} +
+                                   std::strerror(error_number));
+   }
+   madvise(m_mapped_data, m_size, MADV_SEQUENTIAL);
+}
+
+void ScratchMatrix::teardown() noexcept {
+   if (m_mapped_data != MAP_FAILED) {
+      munmap(m_mapped_data, m_size);
+      m_mapped_data = MAP_FAILED;
+      m_size = 0;
+   }
+}
+}  // namespace Hylord::IO
@@ -0,0 +1,71 @@
+#ifndef SCRATCH_MATRIX_H_
+#define SCRATCH_MATRIX_H_
+
+/**
+ * @file    ScratchMatrix.hpp
+ * @brief   Declares a matrix backed by a memory mapped scratch file.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <utility>
+
+#include "types.hpp"
+
+namespace Hylord::IO {
+/**
+ * @brief Column-major matrix of doubles stored in a temporary file.
+ *
+ * The file is mapped (shared) into memory, so the kernel writes pages back to
+ * disk and drops them under memory pressure instead of the matrix needing to
+ * fit in RAM. The file is unlinked as soon as it is created, so it is removed
+ * even if HyLoRD doesn't exit cleanly.
+ */
+class ScratchMatrix {
+  public:
+   /// Creates a zeroed rows x cols matrix in a new file in `directory`.
+   /// @throws FileWriteException if the file can't be created or mapped
+   ScratchMatrix(Eigen::Index rows,
+                 Eigen::Index cols,
+                 const std::filesystem::path& directory);
+   ~ScratchMatrix() { teardown(); }
+   ScratchMatrix(const ScratchMatrix&) = delete;
+   auto operator=(const ScratchMatrix&) -> ScratchMatrix& = delete;
+
+   ScratchMatrix(ScratchMatrix&& other) noexcept :
+       m_mapped_data(std::exchange(other.m_mapped_data, MAP_FAILED)),
+       m_size(std::exchange(other.m_size, 0)),
+       m_rows(std::exchange(other.m_rows, 0)),
+       m_cols(std::exchange(other.m_cols, 0)) {}
+
+   auto operator=(ScratchMatrix&& other) noexcept -> ScratchMatrix& {
+      if (this != &other) {
+         teardown();
+         m_mapped_data = std::exchange(other.m_mapped_data, MAP_FAILED);
+         m_size = std::exchange(other.m_size, 0);
+         m_rows = std::exchange(other.m_rows, 0);
+         m_cols = std::exchange(other.m_cols, 0);
+      }
+      return *this;
+   }
+
+   [[nodiscard]] auto matrix() -> Eigen::Map<Matrix> {
+      return {static_cast<double*>(m_mapped_data), m_rows, m_cols};
+   }
+   [[nodiscard]] auto rows() const -> Eigen::Index { return m_rows; }
+   [[nodiscard]] auto cols() const -> Eigen::Index { return m_cols; }
+
+  private:
+   void* m_mapped_data{MAP_FAILED};
+   std::size_t m_size{};
+   Eigen::Index m_rows{};
+   Eigen::Index m_cols{};
+   void teardown() noexcept;
+};
+}  // namespace Hylord::IO
+
+#endif
@@ -0,0 +1,340 @@
+/**
+ * @file    SharedReference.cpp
+ * @brief   Defines a parsed reference matrix shared between processes
+ * through POSIX shared memory.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "io/SharedReference.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include "io/Hashing.hpp"
+#include "parallel/Affinity.hpp"
+#include "types.hpp"
+
+namespace Hylord::IO {
+namespace {
+constexpr std::array<char, 8> segment_magic{
+    'H', 'Y', 'L', 'O', 'R', 'D', 'R', 'M'};
+/// Bumped whenever the layout of segments changes. The magic, version and
+/// state have to stay at the start of the header.
+constexpr std::uint32_t layout_version{1};
+/// Fresh segments are zeroed, so start out as being published.
+constexpr std::uint32_t state_publishing{0};
+constexpr std::uint32_t state_ready{1};
+
+constexpr std::size_t alignment{64};
+constexpr auto publish_timeout{std::chrono::minutes{10}};
+constexpr auto poll_interval{std::chrono::milliseconds{50}};
+
+struct Header {
+   std::array<char, 8> magic;
+   std::uint32_t version;
+   std::uint32_t state;
+   std::uint64_t identity;
+   std::uint64_t rows;
+   std::uint64_t cols;
+   /// Process publishing the segment (0 until it is known)
+   std::int32_t publisher;
+};
+
+constexpr auto alignUp(std::size_t bytes) -> std::size_t {
+   return (bytes + alignment - 1) / alignment * alignment;
+}
+constexpr auto keysOffset() -> std::size_t { return alignUp(sizeof(Header)); }
+constexpr auto matrixOffset(std::uint64_t rows) -> std::size_t {
+   return alignUp(keysOffset() + rows * sizeof(GenomicKey));
+}
+constexpr auto segmentSize(std::uint64_t rows, std::uint64_t cols)
+    -> std::size_t {
+   return matrixOffset(rows) + rows * cols * sizeof(double);
+}
+
+/// POSIX shared memory names start with a single slash.
+auto segmentName(const std::string& name) -> std::string {
+   return name.starts_with('/') ? name : '/' + name;
+}
+
+auto loadState(const Header& header) -> std::uint32_t {
+   // The mapping is read only, but loading doesn't write to it
+   return std::atomic_ref<std::uint32_t>{const_cast<std::uint32_t&>(
+                                             header.state)}
+       .load(std::memory_order_acquire);
+}
+
+/// Whether the process publishing the segment has exited without finishing.
+auto publisherDied(const Header& header) -> bool {
+   const std::int32_t publisher{
+       std::atomic_ref<std::int32_t>{const_cast<std::int32_t&>(
+                                         header.publisher)}
+           .load(std::memory_order_relaxed)};
+   return publisher > 0 && kill(publisher, 0) == -1 && errno == ESRCH;
+}
+
+void warn(const std::string& name, std::string_view message) {
+   std::cerr << "Warning: Shared reference '" << name << "' " << message
+             << '\n';
+}
+
+/**
+ * Waits for the publisher of a segment to size its header and then to mark
+ * it ready. Gives up (with a warning) if the segment is removed meanwhile
+ * (e.g. its publisher couldn't allocate it), the publisher dies or the
+ * deadline passes.
+ */
+auto waitUntilPublished(const std::string& name,
+                        int file_descriptor,
+                        std::chrono::steady_clock::time_point deadline)
+    -> bool {
+   struct stat file_stats{};
+   const auto removed{[&] {
+      return fstat(file_descriptor, &file_stats) != 0 ||
+             file_stats.st_nlink == 0;
+   }};
+   constexpr std::string_view removed_message{
+       "was removed whilst being published, parsing the reference matrix "
+       "instead."};
+   while (true) {
+      if (removed()) {
+         warn(name, removed_message);
+         return false;
+      }
+      if (static_cast<std::size_t>(file_stats.st_size) >= sizeof(Header)) {
+         break;
+      }
+      if (std::chrono::steady_clock::now() >= deadline) {
+         warn(name,
+              "was never sized, parsing the reference matrix instead.");
+         return false;
+      }
+      std::this_thread::sleep_for(poll_interval);
+   }
+
+   void* header_data{mmap(
+       nullptr, sizeof(Header), PROT_READ, MAP_SHARED, file_descriptor, 0)};
+   if (header_data == MAP_FAILED) return false;
+   const auto& header{*static_cast<const Header*>(header_data)};
+   bool published{true};
+   while (loadState(header) == state_publishing) {
+      if (removed()) {
+         warn(name, removed_message);
+         published = false;
+         break;
+      }
+      if (publisherDied(header) ||
+          std::chrono::steady_clock::now() >= deadline) {
+         warn(name,
+              "was never completed, parsing the reference matrix instead. "
+              "Remove it (from /dev/shm) so that it can be published "
+              "again.");
+         published = false;
+         break;
+      }
+      std::this_thread::sleep_for(poll_interval);
+   }
+   munmap(header_data, sizeof(Header));
+   return published;
+}
+}  // namespace
+
+/**
+ * The publisher sizes the segment as soon as it creates it, but only marks
+ * it ready once the keys and matrix are written. Attaching processes wait
+ * (up to publish_timeout) for that, unless the publisher has died or removed
+ * the segment (in which case the caller parses and publishes it again).
+ */
+auto SharedReference::attach(const std::string& name, std::uint64_t identity)
+    -> std::shared_ptr<const SharedReference> {
+   const std::string segment{segmentName(name)};
+   const int file_descriptor{shm_open(segment.c_str(), O_RDONLY, 0)};
+   if (file_descriptor == -1) return nullptr;
+
+   if (!waitUntilPublished(name,
+                           file_descriptor,
+                           std::chrono::steady_clock::now() +
+                               publish_timeout)) {
+      close(file_descriptor);
+      return nullptr;
+   }
+   struct stat file_stats{};
+   const bool sized{fstat(file_descriptor, &file_stats) == 0};
+   const auto size{static_cast<std::size_t>(file_stats.st_size)};
+   void* mapped_data{
+       sized ? mmap(nullptr, size, PROT_READ, MAP_SHARED, file_descriptor, 0)
+             : MAP_FAILED};
+   close(file_descriptor);
+   if (mapped_data == MAP_FAILED) return nullptr;
+   // Owns the mapping from here on
+   std::shared_ptr<const SharedReference> shared{
+       new SharedReference{mapped_data, size}};
+
+   const auto& header{*static_cast<const Header*>(mapped_data)};
+   if (header.magic != segment_magic || header.version != layout_version) {
+      warn(name,
+           "was published by another version of HyLoRD, parsing the "
+           "reference matrix instead.");
+      return nullptr;
+   }
+   if (header.identity != identity) {
+      warn(name,
+           "was published from other inputs (reference matrix, cell types, "
+           "CpG list or signal), parsing the reference matrix instead.");
+      return nullptr;
+   }
+   if (size < segmentSize(header.rows, header.cols)) {
+      warn(name, "is truncated, parsing the reference matrix instead.");
+      return nullptr;
+   }
+   return shared;
+}
+
+/**
+ * The segment is created exclusively, so only one of many processes starting
+ * together publishes it (the others wait in attach()). Its memory is
+ * allocated up front, so a full /dev/shm fails here instead of crashing the
+ * run part way through writing.
+ */
+auto SharedReference::publish(const std::string& name,
+                              std::uint64_t identity,
+                              std::span<const GenomicKey> keys,
+                              const Matrix& proportions) -> bool {
+   const std::string segment{segmentName(name)};
+   const int file_descriptor{
+       shm_open(segment.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644)};
+   if (file_descriptor == -1) {
+      if (errno != EEXIST) {
+         warn(name,
+              std::string{"could not be created: "} + std::strerror(errno));
+      }
+      return false;
+   }
+   const std::uint64_t rows{keys.size()};
+   const auto cols{static_cast<std::uint64_t>(proportions.cols())};
+   const std::size_t size{segmentSize(rows, cols)};
+   // The header is sized and claimed first, so attaching processes can tell
+   // if this process dies whilst the rest is being allocated
+   const auto publisher{static_cast<std::int32_t>(getpid())};
+   int error_number{
+       ftruncate(file_descriptor, sizeof(Header)) == 0 &&
+               pwrite(file_descriptor,
+                      &publisher,
+                      sizeof(publisher),
+                      offsetof(Header, publisher)) ==
+                   static_cast<ssize_t>(sizeof(publisher))
+           ? 0
+           : errno};
+   if (error_number == 0) {
+      error_number =
+          posix_fallocate(file_descriptor, 0, static_cast<off_t>(size));
+   }
+   void* mapped_data{error_number == 0 ? mmap(nullptr,
+                                              size,
+                                              PROT_READ | PROT_WRITE,
+                                              MAP_SHARED,
+                                              file_descriptor,
+                                              0)
+                                       : MAP_FAILED};
+   close(file_descriptor);
+   if (mapped_data == MAP_FAILED) {
+      shm_unlink(segment.c_str());
+      warn(name,
+           std::string{"could not be allocated: "} +
+               std::strerror(error_number == 0 ? errno : error_number));
+      return false;
+   }
+
+   auto* bytes{static_cast<char*>(mapped_data)};
+   auto& header{*static_cast<Header*>(mapped_data)};
+   header.magic = segment_magic;
+   header.version = layout_version;
+   header.identity = identity;
+   header.rows = rows;
+   header.cols = cols;
+   Parallel::adviseHugePages(bytes + keysOffset(), size - keysOffset());
+   std::ranges::copy(keys,
+                     reinterpret_cast<GenomicKey*>(bytes + keysOffset()));
+   std::copy_n(proportions.data(),
+               proportions.size(),
+               reinterpret_cast<double*>(bytes + matrixOffset(rows)));
+   std::atomic_ref<std::uint32_t>{header.state}.store(
+       state_ready, std::memory_order_release);
+   munmap(mapped_data, size);
+   return true;
+}
+
+void SharedReference::remove(const std::string& name) noexcept {
+   shm_unlink(segmentName(name).c_str());
+}
+
+SharedReference::~SharedReference() {
+   munmap(const_cast<void*>(m_mapped_data), m_size);
+}
+
+auto SharedReference::keys() const -> std::span<const GenomicKey> {
+   const auto& header{*static_cast<const Header*>(m_mapped_data)};
+   return {reinterpret_cast<const GenomicKey*>(
+               static_cast<const char*>(m_mapped_data) + keysOffset()),
+           header.rows};
+}
+
+auto SharedReference::matrix() const -> Eigen::Map<const Matrix> {
+   const auto& header{*static_cast<const Header*>(m_mapped_data)};
+   return {reinterpret_cast<const double*>(
+               static_cast<const char*>(m_mapped_data) +
+               matrixOffset(header.rows)),
+           static_cast<Eigen::Index>(header.rows),
+           static_cast<Eigen::Index>(header.cols)};
+}
+
+auto referenceIdentity(const std::filesystem::path& file_path,
+                       const ColumnIndexes& columns,
+                       const KeyRanges& key_ranges,
+                       std::string_view row_filter) -> std::uint64_t {
+   std::uint64_t hash{fnv_offset_basis};
+   std::error_code error{};
+   const std::string path{
+       std::filesystem::weakly_canonical(file_path, error).string()};
+   hashBytes(hash, path.data(), path.size() + 1);
+   const std::uintmax_t file_size{
+       std::filesystem::file_size(file_path, error)};
+   hashBytes(hash, &file_size, sizeof(file_size));
+   const auto modified{
+       std::filesystem::last_write_time(file_path, error)
+           .time_since_epoch()
+           .count()};
+   hashBytes(hash, &modified, sizeof(modified));
+   for (const std::size_t column : columns) {
+      hashBytes(hash, &column, sizeof(column));
+   }
+   hashBytes(hash, "|", 1);
+   for (const KeyRange& key_range : key_ranges) {
+      hashBytes(hash, &key_range.first, sizeof(key_range.first));
+      hashBytes(hash, &key_range.last, sizeof(key_range.last));
+   }
+   hashBytes(hash, row_filter.data(), row_filter.size());
+   return hash;
+}
+}  // namespace Hylord::IO
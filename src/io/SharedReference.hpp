@@ -0,0 +1,86 @@
+#ifndef SHARED_REFERENCE_H_
+#define SHARED_REFERENCE_H_
+
+/**
+ * @file    SharedReference.hpp
+ * @brief   Declares a parsed reference matrix shared between processes
+ * through POSIX shared memory.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "types.hpp"
+
+namespace Hylord::IO {
+/**
+ * @brief Read-only view of a reference matrix (its keys and values) that
+ * another HyLoRD process parsed and published.
+ *
+ * Jobs sharing a node and reference then hold one copy of the matrix between
+ * them, and skip parsing it. The segment starts with a header holding a
+ * layout version and an identity of the inputs it was parsed from (see
+ * referenceIdentity()), which are checked before it is used. Segments
+ * outlive the processes, until they are removed (see remove()).
+ */
+class SharedReference {
+  public:
+   /**
+    * Attaches to a published segment. If it is still being published, this
+    * waits for it to be completed. Returns nullptr if there is no such
+    * segment, or it can't be used (a warning is printed if it was built from
+    * other inputs or by another version of HyLoRD).
+    */
+   static auto attach(const std::string& name, std::uint64_t identity)
+       -> std::shared_ptr<const SharedReference>;
+
+   /**
+    * Publishes sorted keys and their rows of the reference matrix. Returns
+    * false (leaving the segment alone) if it already exists, and false with
+    * a warning if it can't be created.
+    */
+   static auto publish(const std::string& name,
+                       std::uint64_t identity,
+                       std::span<const GenomicKey> keys,
+                       const Matrix& proportions) -> bool;
+
+   /// Removes a segment (attached processes keep their mappings).
+   static void remove(const std::string& name) noexcept;
+
+   ~SharedReference();
+   SharedReference(const SharedReference&) = delete;
+   auto operator=(const SharedReference&) -> SharedReference& = delete;
+   SharedReference(SharedReference&&) = delete;
+   auto operator=(SharedReference&&) -> SharedReference& = delete;
+
+   [[nodiscard]] auto keys() const -> std::span<const GenomicKey>;
+   [[nodiscard]] auto matrix() const -> Eigen::Map<const Matrix>;
+
+  private:
+   SharedReference(const void* mapped_data, std::size_t size) :
+       m_mapped_data{mapped_data},
+       m_size{size} {}
+
+   const void* m_mapped_data;
+   std::size_t m_size;
+};
+
+/**
+ * Identifies the reference matrix that would be parsed from the given
+ * inputs: the file (its path, size and modification time), the selected
+ * columns, the key ranges and a description of the row filter.
+ */
+auto referenceIdentity(const std::filesystem::path& file_path,
+                       const ColumnIndexes& columns,
+                       const KeyRanges& key_ranges,
+                       std::string_view row_filter) -> std::uint64_t;
+}  // namespace Hylord::IO
+
+#endif
@@ -0,0 +1,319 @@
+/**
+ * @file    SidecarIndex.cpp
+ * @brief   Defines building, reading and querying of sidecar offset indexes.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "io/SidecarIndex.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+#include "HylordException.hpp"
+#include "data/BedRecords.hpp"
+#include "io/FileDescriptor.hpp"
+#include "io/MemoryMap.hpp"
+#include "types.hpp"
+
+namespace Hylord::IO {
+namespace {
+constexpr std::array<char, 8> index_magic{
+    'H', 'L', 'R', 'D', 'I', 'D', 'X', '\0'};
+constexpr std::uint32_t index_version{1};
+constexpr std::uint32_t sorted_flag{1U};
+
+template <typename T>
+void writeValue(std::ofstream& stream, const T& value) {
+   stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+auto readValue(std::ifstream& stream, T& value) -> bool {
+   stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+   return static_cast<bool>(stream);
+}
+
+/**
+ * Extracts the genomic key (chromosome, start and name fields) from a line of
+ * a BED file. Returns an empty optional for lines that can't be parsed (such
+ * as headers), these lines are simply not indexed.
+ */
+auto parseKey(std::string_view line) -> std::optional<GenomicKey> {
+   std::array<std::string_view, 4> fields{};
+   std::size_t field{};
+   std::size_t start{};
+   while (field < fields.size()) {
+      const std::size_t end{line.find_first_of("\t ", start)};
+      fields[field++] = line.substr(start, end - start);
+      if (end == std::string_view::npos) break;
+      start = end + 1;
+   }
+   if (field < fields.size() || fields[3].empty()) return std::nullopt;
+
+   int position{};
+   const auto [end_pointer, error]{std::from_chars(
+       fields[1].data(), fields[1].data() + fields[1].size(), position)};
+   if (error != std::errc{}) return std::nullopt;
+   try {
+      return BedRecords::packKey(BedRecords::parseChromosomeNumber(fields[0]),
+                                 position,
+                                 fields[3][0]);
+   } catch (const std::exception&) {
+      return std::nullopt;
+   }
+}
+}  // namespace
+
+auto SidecarIndex::sidecarPath(const std::filesystem::path& file_path)
+    -> std::filesystem::path {
+   std::filesystem::path sidecar_path{file_path};
+   sidecar_path += ".hli";
+   return sidecar_path;
+}
+
+/**
+ * Scans the file line by line, adding an entry for the first row of every
+ * contig (chromosome) and for every `stride`-th row after that. Rows that
+ * can't be parsed are skipped. Whether the file is sorted is recorded too, as
+ * key based seeking is only possible for sorted files.
+ */
+auto SidecarIndex::build(const std::filesystem::path& file_path,
+                         std::size_t stride) -> SidecarIndex {
+   FileDescriptor file_descriptor{file_path};
+   MemoryMap memory_map{file_descriptor};
+
+   SidecarIndex index{};
+   index.m_file_size = file_descriptor.fileSize();
+   index.m_modified_seconds = file_descriptor.fileInfo().st_mtim.tv_sec;
+   index.m_modified_nanoseconds = file_descriptor.fileInfo().st_mtim.tv_nsec;
+   index.m_stride = std::max<std::size_t>(stride, 1);
+
+   const char* file_start{memory_map.data()};
+   const char* file_end{file_start + file_descriptor.fileSize()};
+   const char* line_start{file_start};
+   std::optional<GenomicKey> previous_key{};
+   std::uint64_t rows_since_entry{};
+
+   while (line_start < file_end) {
+      const char* line_end{static_cast<const char*>(
+          memchr(line_start,
+                 '\n',
+                 static_cast<std::size_t>(file_end - line_start)))};
+      if (line_end == nullptr) line_end = file_end;
+
+      const auto key{parseKey(
+          {line_start, static_cast<std::size_t>(line_end - line_start)})};
+      if (key) {
+         const bool new_contig{
+             !previous_key || BedRecords::chromosomeOfKey(*key) !=
+                                  BedRecords::chromosomeOfKey(*previous_key)};
+         if (new_contig || rows_since_entry >= index.m_stride) {
+            index.m_entries.push_back(
+                {.offset =
+                     static_cast<std::uint64_t>(line_start - file_start),
+                 .key = *key});
+            rows_since_entry = 0;
+         }
+         if (previous_key && *key < *previous_key) index.m_sorted = false;
+         previous_key = key;
+         ++rows_since_entry;
+      }
+      line_start = line_end + 1;
+   }
+   return index;
+}
+
+/**
+ * Writes to a temporary file first and renames it into place so that a
+ * concurrently running HyLoRD never sees a partially written index.
+ * @throws FileWriteException if the index can't be written.
+ */
+void SidecarIndex::write(const std::filesystem::path& file_path) const {
+   const std::filesystem::path sidecar_path{sidecarPath(file_path)};
+   std::filesystem::path temporary_path{sidecar_path};
+   temporary_path += ".tmp";
+   {
+      std::ofstream stream(temporary_path, std::ios::binary);
+      if (!stream) {
+         throw FileWriteException(temporary_path.string(),
+                                  "Failed to open file for writing.");
+      }
+      stream.write(index_magic.data(), index_magic.size());
+      writeValue(stream, index_version);
+      writeValue(stream, m_sorted ? sorted_flag : 0U);
+      writeValue(stream, m_file_size);
+      writeValue(stream, m_modified_seconds);
+      writeValue(stream, m_modified_nanoseconds);
+      writeValue(stream, m_stride);
+      writeValue(stream, static_cast<std::uint64_t>(m_entries.size()));
+      for (const auto& entry : m_entries) {
+         writeValue(stream, entry.offset);
+         writeValue(stream, entry.key);
+      }
+      if (!stream) {
+         throw FileWriteException(temporary_path.string(),
+                                  "Failed to write to file.");
+      }
+   }
+   std::error_code error;
+   std::filesystem::rename(temporary_path, sidecar_path, error);
+   if (error) {
+      throw FileWriteException(sidecar_path.string(), error.message());
+   }
+}
+
+/**
+ * An index is only returned if it exists, is readable, was written by a
+ * compatible version of HyLoRD and the size and modification time of the
+ * indexed file still match. In every other case the index is ignored (the
+ * file is then read without it), so this never throws.
+ */
+auto SidecarIndex::loadFor(const std::filesystem::path& file_path,
+                           const struct stat& file_info)
+    -> std::optional<SidecarIndex> {
+   try {
+      const std::filesystem::path sidecar_path{sidecarPath(file_path)};
+      if (!std::filesystem::exists(sidecar_path)) return std::nullopt;
+      std::ifstream stream(sidecar_path, std::ios::binary);
+
+      std::array<char, index_magic.size()> magic{};
+      stream.read(magic.data(), magic.size());
+      std::uint32_t version{};
+      std::uint32_t flags{};
+      std::uint64_t num_entries{};
+      SidecarIndex index{};
+      if (!stream || magic != index_magic || !readValue(stream, version) ||
+          version != index_version || !readValue(stream, flags) ||
+          !readValue(stream, index.m_file_size) ||
+          !readValue(stream, index.m_modified_seconds) ||
+          !readValue(stream, index.m_modified_nanoseconds) ||
+          !readValue(stream, index.m_stride) ||
+          !readValue(stream, num_entries)) {
+         return std::nullopt;
+      }
+      if (index.m_file_size != static_cast<std::uint64_t>(file_info.st_size) ||
+          index.m_modified_seconds != file_info.st_mtim.tv_sec ||
+          index.m_modified_nanoseconds != file_info.st_mtim.tv_nsec) {
+         return std::nullopt;
+      }
+      index.m_sorted = (flags & sorted_flag) != 0;
+
+      // Guards against allocating absurd amounts for corrupted files
+      constexpr std::uint64_t bytes_per_entry{2 * sizeof(std::uint64_t)};
+      if (num_entries > index.m_file_size / bytes_per_entry + 1) {
+         return std::nullopt;
+      }
+      index.m_entries.resize(num_entries);
+      for (auto& entry : index.m_entries) {
+         if (!readValue(stream, entry.offset) ||
+             !readValue(stream, entry.key) ||
+             entry.offset >= index.m_file_size) {
+            return std::nullopt;
+         }
+      }
+      return index;
+   } catch (const std::exception&) {
+      return std::nullopt;
+   }
+}
+
+/**
+ * Rows before the last entry with a key smaller than the start of the range
+ * can't be in the range, nor can rows from the first entry with a key larger
+ * than the end of the range. Only meaningful for sorted files.
+ */
+auto SidecarIndex::byteRange(KeyRange key_range) const
+    -> std::pair<std::uint64_t, std::uint64_t> {
+   auto first_entry{
+       std::ranges::lower_bound(m_entries, key_range.first, {}, &Entry::key)};
+   const std::uint64_t begin{
+       first_entry == m_entries.begin() ? 0 : std::prev(first_entry)->offset};
+
+   auto last_entry{
+       std::ranges::upper_bound(m_entries, key_range.last, {}, &Entry::key)};
+   const std::uint64_t end{last_entry == m_entries.end() ? m_file_size
+                                                         : last_entry->offset};
+   return {begin, std::max(begin, end)};
+}
+
+auto SidecarIndex::isContigStart(std::size_t entry) const -> bool {
+   return entry == 0 ||
+          BedRecords::chromosomeOfKey(m_entries[entry].key) !=
+              BedRecords::chromosomeOfKey(m_entries[entry - 1].key);
+}
+
+/**
+ * Splits [begin, end) at the indexed line starts that are closest to an even
+ * split. If a contig starts close to an ideal split point (within a quarter
+ * of a chunk), the split is moved onto the contig boundary instead, so chunks
+ * tend to line up with chromosomes. The returned offsets always start with
+ * begin and end with end.
+ */
+auto SidecarIndex::chunkBoundaries(std::uint64_t begin,
+                                   std::uint64_t end,
+                                   int chunks) const
+    -> std::vector<std::uint64_t> {
+   std::vector<std::uint64_t> boundaries{begin};
+   const std::uint64_t length{end - begin};
+   const auto num_chunks{static_cast<std::uint64_t>(std::max(chunks, 1))};
+   const std::uint64_t tolerance{length / (4 * num_chunks)};
+
+   for (std::uint64_t i{1}; i < num_chunks; ++i) {
+      const std::uint64_t target{begin + i * length / num_chunks};
+      auto entry{
+          std::ranges::lower_bound(m_entries, target, {}, &Entry::offset)};
+
+      std::optional<std::uint64_t> best{};
+      auto distance{[target](std::uint64_t offset) {
+         return offset > target ? offset - target : target - offset;
+      }};
+      // Look for contig starts either side of the target
+      for (auto it{entry}; it != m_entries.end() &&
+                           it->offset <= target + tolerance;
+           ++it) {
+         if (isContigStart(static_cast<std::size_t>(it - m_entries.begin()))) {
+            best = it->offset;
+            break;
+         }
+      }
+      for (auto it{entry}; it != m_entries.begin();) {
+         --it;
+         if (it->offset + tolerance < target) break;
+         if (isContigStart(static_cast<std::size_t>(it - m_entries.begin())) &&
+             (!best || distance(it->offset) < distance(*best))) {
+            best = it->offset;
+            break;
+         }
+      }
+      if (!best) {
+         if (entry == m_entries.end()) {
+            if (entry == m_entries.begin()) continue;
+            best = std::prev(entry)->offset;
+         } else if (entry != m_entries.begin() &&
+                    distance(std::prev(entry)->offset) <
+                        distance(entry->offset)) {
+            best = std::prev(entry)->offset;
+         } else {
+            best = entry->offset;
+         }
+      }
+      if (*best > boundaries.back() && *best < end) {
+         boundaries.push_back(*best);
+      }
+   }
+   boundaries.push_back(end);
+   return boundaries;
+}
+}  // namespace Hylord::IO
@@ -0,0 +1,86 @@
+#ifndef SIDECAR_INDEX_H_
+#define SIDECAR_INDEX_H_
+
+/**
+ * @file    SidecarIndex.hpp
+ * @brief   Declares a sidecar byte offset index for plain text BED files.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <sys/stat.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "types.hpp"
+
+namespace Hylord::IO {
+/**
+ * @brief Byte offsets of selected lines in a BED file, each annotated with the
+ * genomic key of that line.
+ *
+ * Compressed BED files can be indexed with tabix, plain text ones can't. This
+ * index fills that gap for HyLoRD: it records the start of every contig and
+ * of every `stride`-th row. With it, TSVFileReader can split a file into
+ * chunks without scanning for newlines and, for sorted files, only read the
+ * parts of a file that overlap requested key ranges.
+ *
+ * The index is stored next to the file (`<file>.hli`) and is only used if the
+ * size and modification time of the file match those recorded in the index.
+ */
+class SidecarIndex {
+  public:
+   struct Entry {
+      std::uint64_t offset{};
+      GenomicKey key{};
+   };
+
+   static constexpr std::size_t default_stride{4096};
+
+   /// Builds an index by scanning every line of the given file.
+   static auto build(const std::filesystem::path& file_path,
+                     std::size_t stride = default_stride) -> SidecarIndex;
+   /// Loads the sidecar index of a file if it exists and is up to date.
+   static auto loadFor(const std::filesystem::path& file_path,
+                       const struct stat& file_info)
+       -> std::optional<SidecarIndex>;
+   /// Path of the sidecar index belonging to a file.
+   static auto sidecarPath(const std::filesystem::path& file_path)
+       -> std::filesystem::path;
+
+   /// Writes the index to the sidecar path of the indexed file.
+   void write(const std::filesystem::path& file_path) const;
+
+   [[nodiscard]] auto entries() const -> const std::vector<Entry>& {
+      return m_entries;
+   }
+   [[nodiscard]] auto isSorted() const -> bool { return m_sorted; }
+   [[nodiscard]] auto fileSize() const -> std::uint64_t { return m_file_size; }
+
+   /// Byte range [begin, end) containing every row with a key in the range.
+   [[nodiscard]] auto byteRange(KeyRange key_range) const
+       -> std::pair<std::uint64_t, std::uint64_t>;
+   /// Line aligned offsets splitting [begin, end) into roughly equal chunks.
+   [[nodiscard]] auto chunkBoundaries(std::uint64_t begin,
+                                      std::uint64_t end,
+                                      int chunks) const
+       -> std::vector<std::uint64_t>;
+
+  private:
+   std::vector<Entry> m_entries;
+   std::uint64_t m_file_size{};
+   std::int64_t m_modified_seconds{};
+   std::int64_t m_modified_nanoseconds{};
+   std::uint64_t m_stride{default_stride};
+   bool m_sorted{true};
+
+   [[nodiscard]] auto isContigStart(std::size_t entry) const -> bool;
+};
+}  // namespace Hylord::IO
+
+#endif
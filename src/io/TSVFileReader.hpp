@@ -13,6 +13,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstddef>
 #include <cstring>
@@ -20,19 +21,23 @@
 #include <future>
 #include <iostream>
 #include <iterator>
-#include <mutex>
-#include <sstream>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <system_error>
-#include <thread>
 #include <utility>
 #include <vector>
 
 #include "HylordException.hpp"
 #include "concepts.hpp"
+#include "io/Chunking.hpp"
 #include "io/FileDescriptor.hpp"
 #include "io/MemoryMap.hpp"
+#include "io/ParseStatistics.hpp"
+#include "io/ParseWarnings.hpp"
+#include "io/SidecarIndex.hpp"
+#include "parallel/Affinity.hpp"
+#include "simd/Dispatch.hpp"
 #include "types.hpp"
 
 /// Defines Input and Output methods for HyLoRD
@@ -50,10 +55,16 @@ namespace Hylord::IO {
  * - Multi-threaded parsing
  * - Column filtering
  * - Row filtering
+ * - Sortedness detection (for records satisfying GenomicRecord)
+ * - Depth and methylation histograms (for records satisfying
+ *   MethylationRecord, see collectStatistics())
  * - Move semantics for efficient resource transfer
  *
  * The reader loads the entire file into memory (via memory mapping) and
- * processes it in parallel chunks.
+ * processes it in parallel chunks. If an up to date sidecar index exists for
+ * the file (see SidecarIndex), chunks are split at indexed line starts and,
+ * when only certain key ranges are needed (see limitToKeyRanges()), only the
+ * parts of the file overlapping those ranges are read.
  *
  * @note This class is not copyable but supports move operations.
  * @note The file must exist and be accessible at construction time.
@@ -82,13 +93,13 @@ class TSVFileReader {
     * @param rowFilter Optional filter function to exclude rows (nullptr to
     * include all rows).
     * @param threads Number of threads to use for processing (defaults to
-    * hardware concurrency).
+    * the available cores, see Parallel::availableCores()).
     */
    TSVFileReader(
        std::filesystem::path file_path,
        ColumnIndexes columns_to_include = {},
        RowFilter rowFilter = nullptr,
-       int threads = static_cast<int>(std::thread::hardware_concurrency())) :
+       int threads = Parallel::availableCores()) :
        m_file_path{std::move(file_path)},
        m_columns_to_include{std::move(columns_to_include)},
        m_row_filter{std::move(rowFilter)},
@@ -102,7 +113,49 @@ class TSVFileReader {
 
    /// Loads and processes the TSV file.
    void load();
+   /**
+    * Processes the file in batches of roughly batch_bytes, handing the
+    * records of each batch (in file order) to `consumer` instead of keeping
+    * them. Batches never split a line. Intended for files too large to hold
+    * in memory, used instead of load().
+    */
+   template <typename Consumer>
+   void stream(std::size_t batch_bytes, Consumer&& consumer);
    auto isLoaded() const noexcept -> bool { return m_loaded; }
+   /**
+    * Whether the loaded records are in ascending genomic key order. This is
+    * checked whilst parsing (within each chunk and across chunk boundaries),
+    * so comes at no extra cost. Always true for records without a key.
+    */
+   auto isSorted() const noexcept -> bool { return m_sorted; }
+   /**
+    * Declares that only rows within the given key ranges are needed. This is
+    * a hint: it only has an effect if a valid sidecar index exists for a
+    * sorted file, and even then rows outside the ranges may still be returned
+    * (callers are expected to join/filter on keys afterwards).
+    */
+   void limitToKeyRanges(KeyRanges key_ranges) {
+      m_key_ranges = std::move(key_ranges);
+   }
+   auto hasSidecarIndex() const noexcept -> bool {
+      return m_index.has_value();
+   }
+   /**
+    * Fills histograms of depth and methylation whilst parsing (see
+    * statistics()). By default every row that parses is counted, including
+    * those the row filter drops, so that the statistics can be used to pick
+    * filters.
+    */
+   void collectStatistics(CountedRows counted_rows = CountedRows::parsed)
+      requires Hylord::Records::MethylationRecord<RecordType>
+   {
+      m_collect_statistics = true;
+      m_counted_rows = counted_rows;
+   }
+   /// Statistics of the rows parsed so far (see collectStatistics()).
+   auto statistics() const noexcept -> const ParseStatistics& {
+      return m_statistics;
+   }
 
    using Records = Records::Collection<RecordType>;
    /**
@@ -123,10 +176,17 @@ class TSVFileReader {
    RowFilter m_row_filter;
    int m_num_threads{};
    bool m_loaded{false};
+   bool m_sorted{true};
+   KeyRanges m_key_ranges{};
+   bool m_collect_statistics{false};
+   CountedRows m_counted_rows{CountedRows::parsed};
+   ParseStatistics m_statistics{};
 
    // Memory mapping
    FileDescriptor m_file_descriptor{m_file_path};
    MemoryMap m_memory_map{m_file_descriptor};
+   std::optional<SidecarIndex> m_index{
+       SidecarIndex::loadFor(m_file_path, m_file_descriptor.fileInfo())};
    /// Get the start and end pointers of the file
    auto mappedRange() const -> MapRange;
 
@@ -134,24 +194,31 @@ class TSVFileReader {
    struct ChunkResult {
       std::size_t chunk_index{};
       Records records{};
+      bool sorted{true};
+      ParseStatistics statistics{};
    };
    /// Splits a TSV line into individual fields.
    auto splitTSVLine(const std::string& line) const -> Fields;
-   /// Finds the end of a chunk for parallel processing.
-   auto findChunkEnd(const char* start, std::ptrdiff_t size) const -> const
-       char*;
    /// Processes a chunk of TSV data into records.
-   auto processChunk(MapRange map_range) -> Records;
+   auto processChunk(MapRange map_range) -> ChunkResult;
+   /// Adds a record to the chunk, checking it follows the previous one.
+   static void appendRecord(ChunkResult& result, RecordType&& record);
+   /// Merges the statistics of each chunk into m_statistics.
+   void mergeStatistics(const std::vector<ChunkResult>& chunk_results);
+   /// Checks that consecutive (non-empty) chunks are in ascending key order.
+   static auto chunksAreSorted(const std::vector<ChunkResult>& chunk_results)
+       -> bool;
 
    using ChunkResults = std::vector<ChunkResult>;
-   /// Processes TSV file in parallel chunks
-   auto processFile(MapRange map_range) -> ChunkResults;
+   /// Processes chunks of the TSV file in parallel
+   auto processChunks(const std::vector<MapRange>& chunk_ranges)
+       -> ChunkResults;
+   /// Joins the records of each chunk (in order).
+   static auto combineChunks(ChunkResults& chunk_results, Records& records)
+       -> void;
 
    // error catching (thread safe)
-   mutable std::mutex m_warning_mutex;
-   mutable std::vector<std::string> m_warning_messages;
-   static constexpr int m_max_warning_messages{5};
-   int m_number_of_warning_messages{};
+   ParseWarnings m_warnings;
 };
 
 template <Records::TSVRecord RecordType>
@@ -166,57 +233,41 @@ auto TSVFileReader<RecordType>::mappedRange() const -> MapRange {
  * Parses tab or space delimited fields from a line and returns them
  * as a vector. Handles both tabs and spaces as delimiters and includes the
  * final field. Spaces are required due to the silly format of bedmethyl files.
+ * Delimiters are found with the vectorised kernel (see Simd::Kernels).
  */
 template <Records::TSVRecord RecordType>
 inline auto TSVFileReader<RecordType>::splitTSVLine(
     const std::string& line) const -> Fields {
+   const auto find_delimiter{Simd::kernels().find_delimiter};
    Fields fields;
-   std::size_t start{0};
-   std::size_t end{line.find_first_of("\t ")};
+   const char* line_end{line.data() + line.size()};
+   const char* start{line.data()};
+   const char* end{find_delimiter(start, line_end)};
 
-   while (end != std::string::npos) {
-      fields.emplace_back(line.substr(start, end - start));
+   while (end != line_end) {
+      fields.emplace_back(start, end);
       start = end + 1;
-      end = line.find_first_of("\t ", start);
+      end = find_delimiter(start, line_end);
    }
    // Final field
-   fields.emplace_back(line.substr(start));
+   fields.emplace_back(start, line_end);
 
    return fields;
 }
 
-/**
- * Locates the nearest newline character after the approximate chunk
- * end to ensure complete records in each chunk. Returns file end if no newline
- * found.
- */
-template <Records::TSVRecord RecordType>
-inline auto TSVFileReader<RecordType>::findChunkEnd(const char* start,
-                                                    std::ptrdiff_t size) const
-    -> const char* {
-   const char* approximate_end{start + size};
-   const char* file_end{m_memory_map.data() + m_file_descriptor.fileSize()};
-
-   if (approximate_end >= file_end) return file_end;
-
-   const char* end{static_cast<const char*>(
-       memchr(approximate_end,
-              '\n',
-              static_cast<std::size_t>(file_end - approximate_end)))};
-
-   return (end != nullptr) ? end : file_end;
-}
-
 /**
  * Parses each line in the chunk, applies column filtering if
  * specified, and converts valid lines into record objects. Invalid records
  * generate warnings while valid ones are added to the result vector.
  * Thread-safe warning collection is implemented due to parallel processing.
+ * For genomic records, each new record is compared against the previous one to
+ * determine whether the chunk is sorted. Statistics (if collected) are kept
+ * per chunk, so threads never share them.
  */
 template <Records::TSVRecord RecordType>
 inline auto TSVFileReader<RecordType>::processChunk(MapRange map_range)
-    -> std::vector<RecordType> {
-   Records chunk_records;
+    -> ChunkResult {
+   ChunkResult result{};
    const char* line_start{map_range.start};
 
    while (line_start < map_range.end) {
@@ -242,59 +293,95 @@ inline auto TSVFileReader<RecordType>::processChunk(MapRange map_range)
       }
 
       try {
-         if (!m_row_filter || m_row_filter(filtered_fields)) {
-            chunk_records.emplace_back(
-                RecordType::fromFields(filtered_fields));
-         }
-      } catch (const std::exception& e) {
-         if (std::ssize(m_warning_messages) < m_max_warning_messages) {
-            std::lock_guard<std::mutex> lock(m_warning_mutex);
-            std::ostringstream oss;
-            oss << "Record conversion warning: " << e.what() << '\n';
-            if (line.empty()) {
-               oss << "Line was empty.\n";
-            } else {
-               oss << line << '\n';
+         const bool keep{!m_row_filter || m_row_filter(filtered_fields)};
+         if (m_collect_statistics &&
+             (keep || m_counted_rows == CountedRows::parsed)) {
+            RecordType record{RecordType::fromFields(filtered_fields)};
+            if constexpr (Hylord::Records::MethylationRecord<RecordType>) {
+               result.statistics.add(record.name,
+                                     record.read_depth,
+                                     record.methylation_proportion);
             }
-            m_warning_messages.emplace_back(oss.str());
+            if (keep) appendRecord(result, std::move(record));
+         } else if (keep) {
+            appendRecord(result, RecordType::fromFields(filtered_fields));
          }
-         m_number_of_warning_messages++;
+      } catch (const std::exception& e) {
+         m_warnings.add(e.what(), line);
       }
       line_start = line_end + 1;
    }
-   return chunk_records;
+   return result;
+}
+
+template <Records::TSVRecord RecordType>
+inline void TSVFileReader<RecordType>::appendRecord(ChunkResult& result,
+                                                    RecordType&& record) {
+   Records& chunk_records{result.records};
+   chunk_records.push_back(std::move(record));
+   if constexpr (Hylord::Records::GenomicRecord<RecordType>) {
+      const auto num_records{chunk_records.size()};
+      if (num_records > 1 && chunk_records[num_records - 1].key() <
+                                 chunk_records[num_records - 2].key()) {
+         result.sorted = false;
+      }
+   }
+}
+
+template <Records::TSVRecord RecordType>
+inline void TSVFileReader<RecordType>::mergeStatistics(
+    const std::vector<ChunkResult>& chunk_results) {
+   if (!m_collect_statistics) return;
+   for (const auto& result : chunk_results) {
+      m_statistics.merge(result.statistics);
+   }
 }
 
 /**
- * Divides file into chunks by thread count, finds line boundaries,
- * and processes concurrently. Manages threads, tasks and results
- * while preserving order. Handles per-chunk exceptions gracefully.
+ * Compares the last record of each chunk with the first record of the next
+ * non-empty chunk. Together with the per chunk checks in processChunk(), this
+ * determines whether the whole file is sorted.
  */
 template <Records::TSVRecord RecordType>
-inline auto TSVFileReader<RecordType>::processFile(MapRange map_range) ->
-    typename TSVFileReader<RecordType>::ChunkResults {
-   std::vector<std::pair<const char*, const char*>> chunk_ranges{};
-   auto chunk_size{static_cast<std::ptrdiff_t>(m_file_descriptor.fileSize()) /
-                   m_num_threads};
-   const char* chunk_start{map_range.start};
-   const char* file_end{map_range.end};
-
-   for (int i{0}; i < m_num_threads; ++i) {
-      const char* chunk_end{(i == m_num_threads - 1)
-                                ? file_end
-                                : findChunkEnd(chunk_start, chunk_size)};
-      chunk_ranges.emplace_back(chunk_start, chunk_end);
-      chunk_start = chunk_end + 1;
+inline auto TSVFileReader<RecordType>::chunksAreSorted(
+    const std::vector<ChunkResult>& chunk_results) -> bool {
+   if constexpr (Hylord::Records::GenomicRecord<RecordType>) {
+      const RecordType* previous_last{nullptr};
+      for (const auto& result : chunk_results) {
+         if (!result.sorted) return false;
+         if (result.records.empty()) continue;
+         if (previous_last != nullptr &&
+             result.records.front().key() < previous_last->key()) {
+            return false;
+         }
+         previous_last = &result.records.back();
+      }
    }
+   return true;
+}
 
+/**
+ * Processes chunks (see splitIntoChunks()) concurrently. Manages threads,
+ * tasks and results while preserving order. Handles per-chunk exceptions
+ * gracefully. A single chunk is parsed on the calling thread. Chunks are
+ * pinned like the blocks of Parallel::forEachBlock().
+ */
+template <Records::TSVRecord RecordType>
+inline auto TSVFileReader<RecordType>::processChunks(
+    const std::vector<MapRange>& chunk_ranges) ->
+    typename TSVFileReader<RecordType>::ChunkResults {
    // Parallel processing of chunks
    std::vector<std::future<ChunkResult>> futures;
+   const auto policy{chunk_ranges.size() == 1 ? std::launch::deferred
+                                              : std::launch::async};
    for (std::size_t i{}; i < chunk_ranges.size(); ++i) {
+      const std::size_t core{Parallel::nestedCore(chunk_ranges.size(), i)};
       futures.push_back(
-          std::async(std::launch::async, [this, i, &chunk_ranges]() {
-             std::vector<RecordType> records{processChunk(
-                 {chunk_ranges[i].first, chunk_ranges[i].second})};
-             return ChunkResult{i, std::move(records)};
+          std::async(policy, [this, i, core, &chunk_ranges]() {
+             const Parallel::ScopedPin pin{core};
+             ChunkResult result{processChunk(chunk_ranges[i])};
+             result.chunk_index = i;
+             return result;
           }));
    }
 
@@ -312,11 +399,24 @@ inline auto TSVFileReader<RecordType>::processFile(MapRange map_range) ->
    return chunk_results;
 }
 
+template <Records::TSVRecord RecordType>
+inline void TSVFileReader<RecordType>::combineChunks(
+    ChunkResults& chunk_results,
+    Records& records) {
+   for (auto& result : chunk_results) {
+      records.insert(records.end(),
+                     std::make_move_iterator(result.records.begin()),
+                     std::make_move_iterator(result.records.end()));
+   }
+}
+
 /**
  * This method:
  * 1. Divides memory map into chunks
  * 2. Processes chunks in parallel
- * 3. Combines results
+ * 3. Checks sortedness across chunk boundaries
+ * 4. Merges the statistics of each chunk (if collected)
+ * 5. Combines results
  *
  * @throw HylordException if the file is already loaded.
  * @throw FileReadException if the file cannot be loaded or parsed.
@@ -327,7 +427,10 @@ void TSVFileReader<RecordType>::load() {
       throw HylordException("File is already loaded.");
    }
    try {
-      auto chunk_results{processFile(mappedRange())};
+      auto chunk_results{processChunks(splitIntoChunks(
+          mappedRange(), m_num_threads, m_index, m_key_ranges))};
+      m_sorted = chunksAreSorted(chunk_results);
+      mergeStatistics(chunk_results);
 
       // Performance enhancement, we don't know how long a line is going to
       // be, but this is a nice conservative estimate that isn't too large.
@@ -335,36 +438,56 @@ void TSVFileReader<RecordType>::load() {
       const std::size_t approximate_line_length{50};
       m_records.reserve(m_file_descriptor.fileSize() /
                         approximate_line_length);
-
-      // Insert chunks in the correct order
-      for (auto& result : chunk_results) {
-         m_records.insert(m_records.end(),
-                          std::make_move_iterator(result.records.begin()),
-                          std::make_move_iterator(result.records.end()));
-      }
+      combineChunks(chunk_results, m_records);
       m_loaded = true;
 
-      if (m_number_of_warning_messages != 0) {
-         std::cerr << "===\n"
-                   << m_number_of_warning_messages << " warning"
-                   << (m_number_of_warning_messages > 1 ? "s" : "")
-                   << " occurred whilst processing '" << m_file_path << "'.\n";
-         for (int i{}; i < std::min(m_max_warning_messages,
-                                    m_number_of_warning_messages);
-              ++i) {
-            std::cerr << m_warning_messages[static_cast<std::size_t>(i)]
-                      << '\n';
-         }
-         std::cerr << "These lines will be skipped.\n";
-         int remaining_messages{m_number_of_warning_messages -
-                                m_max_warning_messages};
-         if (remaining_messages > 0) {
-            std::cerr << remaining_messages << " warning message"
-                      << (remaining_messages > 1 ? "s were" : " was")
-                      << " surpressed.\n"
-                      << "===\n";
-         }
+      m_warnings.report(m_file_path);
+   } catch (const std::system_error& e) {
+      throw FileReadException(m_file_path,
+                              "Caught system_error with code " +
+                                  std::to_string(e.code().value()) + " [" +
+                                  e.what() + "].");
+   }
+}
+/**
+ * Each batch is split into chunks and processed in parallel exactly as in
+ * load(). Pages of batches that have been consumed are discarded, so resident
+ * memory is bounded by the batch size rather than the file size. Sortedness
+ * is only checked within batches.
+ *
+ * @throw HylordException if the file is already loaded.
+ * @throw FileReadException if the file cannot be read.
+ */
+template <Records::TSVRecord RecordType>
+template <typename Consumer>
+void TSVFileReader<RecordType>::stream(std::size_t batch_bytes,
+                                       Consumer&& consumer) {
+   if (m_loaded) {
+      throw HylordException("File is already loaded.");
+   }
+   try {
+      const MapRange map_range{mappedRange()};
+      const char* batch_start{map_range.start};
+      while (batch_start < map_range.end) {
+         const auto remaining{
+             static_cast<std::size_t>(map_range.end - batch_start)};
+         const char* batch_end{
+             remaining <= batch_bytes
+                 ? map_range.end
+                 : findLineEnd(batch_start + batch_bytes, map_range.end)};
+
+         auto chunk_results{processChunks(splitIntoChunks(
+             {batch_start, batch_end}, m_num_threads, std::nullopt, {}))};
+         m_sorted = m_sorted && chunksAreSorted(chunk_results);
+         mergeStatistics(chunk_results);
+         Records batch{};
+         combineChunks(chunk_results, batch);
+         consumer(std::move(batch));
+
+         m_memory_map.discard(batch_start, batch_end);
+         batch_start = batch_end + 1;
       }
+      m_warnings.report(m_file_path);
    } catch (const std::system_error& e) {
       throw FileReadException(m_file_path,
                               "Caught system_error with code " +
@@ -0,0 +1,183 @@
+/**
+ * @file    TrackWriter.cpp
+ * @brief   Defines writers for outputs with a line per CpG.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "io/TrackWriter.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "HylordException.hpp"
+#include "data/BedRecords.hpp"
+#include "io/writeMetrics.hpp"
+#include "parallel/ParallelFor.hpp"
+#include "types.hpp"
+
+namespace Hylord::IO {
+namespace {
+/// Rows formatted by each block per batch, which bounds the memory held by
+/// the buffers.
+constexpr std::size_t rows_per_block{std::size_t{1} << 14U};
+/// Upper bound of the characters of the BED4 fields (and their tabs).
+constexpr std::size_t max_key_chars{48};
+/// Upper bound of the characters of a value ("-100.00") and its tab.
+constexpr std::size_t max_value_chars{8};
+constexpr double percentage_base{100.0};
+
+/// Appends a tab and `proportion` as a percentage (limited to +-100%).
+auto appendPercent(char* out, char* last, double proportion) -> char* {
+   constexpr int precision{2};
+   constexpr double smallest_written{0.005};
+   *out++ = '\t';
+   double percent{std::clamp(
+       proportion * percentage_base, -percentage_base, percentage_base)};
+   // Avoids writing -0.00
+   if (std::abs(percent) < smallest_written) percent = 0.0;
+   return std::to_chars(
+              out, last, percent, std::chars_format::fixed, precision)
+       .ptr;
+}
+
+/**
+ * Formats rows [begin, end) into `buffer`: the BED4 fields of each key
+ * followed by the `values_per_row` values appended by
+ * `appendValues(row, out, last)`. Values are written with std::to_chars,
+ * which avoids the locale handling (and per value stream state) of writing
+ * through an ostream.
+ */
+template <typename AppendValues>
+void formatRows(const GenomicKeys& keys,
+                std::size_t values_per_row,
+                std::size_t begin,
+                std::size_t end,
+                std::string& buffer,
+                const AppendValues& appendValues) {
+   buffer.resize((end - begin) *
+                 (max_key_chars + max_value_chars * values_per_row));
+   char* out{buffer.data()};
+   char* const last{buffer.data() + buffer.size()};
+
+   int chromosome{-1};
+   std::string chromosome_name{};
+   for (std::size_t row{begin}; row < end; ++row) {
+      const BedRecords::Bed fields{BedRecords::unpackKey(keys[row])};
+      if (fields.chromosome != chromosome) {
+         chromosome = fields.chromosome;
+         chromosome_name = BedRecords::chromosomeName(chromosome);
+      }
+      out = std::ranges::copy(chromosome_name, out).out;
+      *out++ = '\t';
+      out = std::to_chars(out, last, fields.start).ptr;
+      *out++ = '\t';
+      out = std::to_chars(out, last, static_cast<long>(fields.start) + 1).ptr;
+      *out++ = '\t';
+      *out++ = fields.name;
+      out = appendValues(static_cast<Eigen::Index>(row), out, last);
+      *out++ = '\n';
+   }
+   buffer.resize(static_cast<std::size_t>(out - buffer.data()));
+}
+
+/**
+ * Formats rows concurrently into per block buffers (see formatRows()), which
+ * are then written in order, a batch of rows at a time.
+ */
+template <typename AppendValues>
+auto writeRows(const std::filesystem::path& out_path,
+               const GenomicKeys& keys,
+               std::size_t values_per_row,
+               int threads,
+               const AppendValues& appendValues) -> std::filesystem::path {
+   const std::filesystem::path final_path{resolveOutputPath(out_path)};
+   std::ofstream outfile(final_path, std::ios::binary);
+   if (!outfile) {
+      throw FileWriteException(final_path.string(),
+                               "Failed to open file for writing.");
+   }
+
+   const std::size_t rows{keys.size()};
+   const std::size_t rows_per_batch{
+       Parallel::numberOfBlocks(rows, threads) * rows_per_block};
+   std::vector<std::string> buffers(Parallel::numberOfBlocks(rows, threads));
+   for (std::size_t batch_begin{}; batch_begin < rows;
+        batch_begin += rows_per_batch) {
+      const std::size_t batch_size{
+          std::min(rows_per_batch, rows - batch_begin)};
+      const std::size_t num_blocks{
+          Parallel::numberOfBlocks(batch_size, threads)};
+      Parallel::forEachBlock(
+          batch_size, threads, [&](const Parallel::Block& block) {
+             formatRows(keys,
+                        values_per_row,
+                        batch_begin + block.begin,
+                        batch_begin + block.end,
+                        buffers[block.index],
+                        appendValues);
+          });
+      for (std::size_t i{}; i < num_blocks; ++i) {
+         outfile.write(buffers[i].data(),
+                       static_cast<std::streamsize>(buffers[i].size()));
+      }
+      if (!outfile) {
+         throw FileWriteException(final_path.string(),
+                                  "Failed to write to file.");
+      }
+   }
+
+   outfile.close();
+   if (!outfile) {
+      throw FileWriteException(final_path.string(),
+                               "Failed to properly close file.");
+   }
+   return final_path;
+}
+}  // namespace
+
+auto writeReferenceMatrix(const std::filesystem::path& out_path,
+                          const GenomicKeys& keys,
+                          const Eigen::Ref<const Matrix>& proportions,
+                          int threads) -> std::filesystem::path {
+   return writeRows(
+       out_path,
+       keys,
+       static_cast<std::size_t>(proportions.cols()),
+       threads,
+       [&](Eigen::Index row, char* out, char* last) {
+          for (Eigen::Index col{}; col < proportions.cols(); ++col) {
+             out = appendPercent(
+                 out, last, std::clamp(proportions(row, col), 0.0, 1.0));
+          }
+          return out;
+       });
+}
+
+auto writeResidualTrack(const std::filesystem::path& out_path,
+                        const GenomicKeys& keys,
+                        const Eigen::Ref<const Matrix>& reference_matrix,
+                        const Vector& cell_proportions,
+                        const Eigen::Ref<const Vector>& bulk_profile,
+                        int threads) -> std::filesystem::path {
+   constexpr std::size_t values_per_row{3};
+   return writeRows(
+       out_path,
+       keys,
+       values_per_row,
+       threads,
+       [&](Eigen::Index row, char* out, char* last) {
+          const double fitted{
+              reference_matrix.row(row).dot(cell_proportions.transpose())};
+          out = appendPercent(out, last, bulk_profile(row));
+          out = appendPercent(out, last, fitted);
+          return appendPercent(out, last, bulk_profile(row) - fitted);
+       });
+}
+}  // namespace Hylord::IO
@@ -0,0 +1,48 @@
+#ifndef TRACK_WRITER_H_
+#define TRACK_WRITER_H_
+
+/**
+ * @file    TrackWriter.hpp
+ * @brief   Declares writers for outputs with a line per CpG (reference
+ * matrices and residual tracks).
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <filesystem>
+
+#include "types.hpp"
+
+namespace Hylord::IO {
+/**
+ * Writes a reference matrix (rows keyed by `keys`, see BedRecords::packKey)
+ * as a BED4+X file that can be given back to HyLoRD with
+ * --reference-matrix. Proportions are written as percentages to two decimal
+ * places, the format expected by ReferenceMatrixReader.
+ *
+ * @return The path written to (see resolveOutputPath()).
+ * @throws FileWriteException if the file can't be opened or written to
+ */
+auto writeReferenceMatrix(const std::filesystem::path& out_path,
+                          const GenomicKeys& keys,
+                          const Eigen::Ref<const Matrix>& proportions,
+                          int threads) -> std::filesystem::path;
+
+/**
+ * Writes the bulk signal, fitted value (reference_matrix * cell_proportions)
+ * and residual (bulk - fitted) of each row as a BED4+3 file. Values are
+ * percentages to two decimal places. Fitted values are computed whilst
+ * formatting, so no extra matrix is allocated.
+ *
+ * @return The path written to (see resolveOutputPath()).
+ * @throws FileWriteException if the file can't be opened or written to
+ */
+auto writeResidualTrack(const std::filesystem::path& out_path,
+                        const GenomicKeys& keys,
+                        const Eigen::Ref<const Matrix>& reference_matrix,
+                        const Vector& cell_proportions,
+                        const Eigen::Ref<const Vector>& bulk_profile,
+                        int threads) -> std::filesystem::path;
+}  // namespace Hylord::IO
+
+#endif
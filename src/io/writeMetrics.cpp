@@ -8,19 +8,33 @@
 
 #include "io/writeMetrics.hpp"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
 #include <cassert>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "Eigen/src/Core/util/Meta.h"
 #include "HylordException.hpp"
 #include "cli.hpp"
+#include "core/BatchSolver.hpp"
 #include "core/Deconvolver.hpp"
+#include "core/Sweep.hpp"
 #include "data/BedRecords.hpp"
+#include "io/CDFFile.hpp"
+#include "io/FileDescriptor.hpp"
+#include "io/ParseStatistics.hpp"
 #include "io/TSVFileReader.hpp"
 #include "maths/percentage.hpp"
 
@@ -29,24 +43,29 @@ namespace Hylord::IO {
 /**
  * Creates a complete cell type name list
  *
- * 1. Reading known cell types from specified file (if provided)
+ * 1. Using the selected cell types (if --cell-types was given), otherwise
+ *    reading known cell types from specified file (if provided)
  * 2. Generating default names ("unknown_cell_type_N") for any remaining types
  * 3. Ensuring output size matches deconvolution results dimension
  * The function guarantees one-to-one correspondence between:
  * - Cell type names in returned vector
- * - Proportions in deconvolver's results
+ * - Proportions in deconvolver's results (or columns of the reference)
  */
-auto generateCellTypeList(const std::string_view cell_type_list_file,
-                          const Deconvolution::Deconvolver& deconvolver)
+auto generateCellTypeList(const CMD::HylordConfig& config,
+                          std::size_t number_of_cell_types)
     -> std::vector<BedRecords::CellType> {
    std::vector<BedRecords::CellType> cell_type_list{};
-   if (!cell_type_list_file.empty()) {
-      TSVFileReader<BedRecords::CellType> reader{cell_type_list_file};
+   if (!config.selected_cell_types.empty()) {
+      for (const auto& cell_type : config.selected_cell_types) {
+         cell_type_list.emplace_back(BedRecords::CellType{cell_type});
+      }
+   } else if (!config.cell_type_list_file.empty()) {
+      TSVFileReader<BedRecords::CellType> reader{config.cell_type_list_file};
       reader.load();
       cell_type_list = {reader.extractRecords()};
    }
-   int num_remaining_cell_types{static_cast<int>(
-       deconvolver.cellProportions().size() - cell_type_list.size())};
+   int num_remaining_cell_types{
+       static_cast<int>(number_of_cell_types - cell_type_list.size())};
    for (int i{1}; i <= num_remaining_cell_types; ++i) {
       cell_type_list.emplace_back(
           BedRecords::CellType{"unknown_cell_type_" + std::to_string(i)});
@@ -55,9 +74,29 @@ auto generateCellTypeList(const std::string_view cell_type_list_file,
 }
 
 /**
- * Safely writes buffer contents to a file with comprehensive error checking.
- *
- * Handles file writing with multiple safety checks and features:
+ * Names samples from the sample list (if provided), in the order of the
+ * columns of the bulk matrix, naming any remaining samples "sample_N".
+ */
+auto generateSampleNames(const CMD::HylordConfig& config,
+                         std::size_t number_of_samples)
+    -> std::vector<std::string> {
+   std::vector<std::string> sample_names{};
+   if (!config.sample_list_file.empty()) {
+      TSVFileReader<BedRecords::CellType> reader{config.sample_list_file};
+      reader.load();
+      for (auto& sample : reader.extractRecords()) {
+         sample_names.push_back(std::move(sample.cell_type));
+      }
+   }
+   for (std::size_t i{sample_names.size() + 1}; i <= number_of_samples; ++i) {
+      sample_names.push_back("sample_" + std::to_string(i));
+   }
+   sample_names.resize(number_of_samples);
+   return sample_names;
+}
+
+/**
+ * Validates an output path before anything is written to it:
  * 1. Path validation:
  *    - Rejects directory paths
  *    - Creates parent directories if needed
@@ -65,14 +104,10 @@ auto generateCellTypeList(const std::string_view cell_type_list_file,
  *    - Checks write permissions in target directory
  * 3. Collision handling:
  *    - Appends numbered suffixes to prevent overwriting existing files
- * 4. Atomic write operations:
- *    - Verifies successful open/write/close operations
- * 5. Error reporting:
- *    - Provides detailed error messages for all failure cases
- * @throws FileWriteException for any file system or I/O operation failure
+ * @throws FileWriteException if the path can't be written to
  */
-void writeToFile(const std::stringstream& buffer,
-                 const std::filesystem::path& out_path) {
+auto resolveOutputPath(const std::filesystem::path& out_path)
+    -> std::filesystem::path {
    if (std::filesystem::exists(out_path) &&
        std::filesystem::is_directory(out_path)) {
       throw FileWriteException(out_path.filename().string(),
@@ -121,31 +156,88 @@ void writeToFile(const std::stringstream& buffer,
       final_path = new_path;
    }
 
-   std::ofstream outfile(final_path, std::ios::binary);
-   if (!outfile) {
+   return final_path;
+}
+
+/**
+ * Safely writes buffer contents to a file with comprehensive error checking.
+ *
+ * Handles file writing with multiple safety checks and features:
+ * 1. Path validation, permission checks and collision handling (see
+ *    resolveOutputPath())
+ * 2. Atomic write operations:
+ *    - Verifies successful open/write/close operations
+ * 3. Error reporting:
+ *    - Provides detailed error messages for all failure cases
+ * Written with POSIX calls, as outputs are small and the latency of small
+ * runs is dominated by fixed costs.
+ * @throws FileWriteException for any file system or I/O operation failure
+ */
+void writeToFile(std::string_view buffer,
+                 const std::filesystem::path& out_path) {
+   const std::filesystem::path final_path{resolveOutputPath(out_path)};
+   if (buffer.empty()) {
+      throw FileWriteException(final_path.string(), "Nothing to write.");
+   }
+   const int file_descriptor{::open(final_path.c_str(),
+                                    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                                    0644)};
+   if (file_descriptor == -1) {
       throw FileWriteException(final_path.string(),
                                "Failed to open file for writing.");
    }
-   outfile << buffer.rdbuf();
-
-   if (!outfile) {
+   if (!writeAll(file_descriptor, buffer)) {
+      ::close(file_descriptor);
       throw FileWriteException(final_path.string(),
                                "Failed to write to file.");
    }
-   outfile.close();
-   if (!outfile) {
+   if (::close(file_descriptor) == -1) {
       throw FileWriteException(final_path.string(),
                                "Failed to properly close file.");
    }
 }
 
+void writeToFile(const std::stringstream& buffer,
+                 const std::filesystem::path& out_path) {
+   writeToFile(buffer.view(), out_path);
+}
+
+/**
+ * Formatted as std::ostream would (%g, 6 significant digits) without
+ * constructing a stream.
+ */
+auto formatProportions(const std::vector<BedRecords::CellType>& cell_type_list,
+                       const Vector& cell_proportions) -> std::string {
+   assert(cell_type_list.size() ==
+              static_cast<std::size_t>(cell_proportions.size()) &&
+          "Cell proportions vector and names of cell types must match in "
+          "size.");
+   std::string output_buffer;
+   std::array<char, 32> number{};
+   for (std::size_t i{}; i < cell_type_list.size(); ++i) {
+      char* end{std::to_chars(number.data(),
+                              number.data() + number.size(),
+                              Maths::convertToPercent(
+                                  cell_proportions[static_cast<Eigen::Index>(
+                                      i)]),
+                              std::chars_format::general,
+                              6)
+                    .ptr};
+      output_buffer += cell_type_list[i].cell_type;
+      output_buffer += '\t';
+      output_buffer.append(number.data(), end - number.data());
+      output_buffer += '\n';
+   }
+   return output_buffer;
+}
+
 /**
  * Formats and outputs cell type proportions with the following logic:
  * 1. Generates cell type names from either:
  *    - Provided cell type list file, or
  *    - Default naming scheme if no file provided (or not enough cell type
  *      names given)
- * 2. Formats proportions as percentages
+ * 2. Formats proportions as percentages (see formatProportions())
  * 3. Writes to either:
  *    - stdout if no output file specified, or
  *    - specified output file path
@@ -153,20 +245,73 @@ void writeToFile(const std::stringstream& buffer,
  */
 void writeMetrics(const CMD::HylordConfig& config,
                   const Deconvolution::Deconvolver& deconvolver) {
-   std::vector<BedRecords::CellType> cell_type_list{
-       generateCellTypeList(config.cell_type_list_file, deconvolver)};
-   assert(
-       cell_type_list.size() == deconvolver.cellProportions().size() &&
-       "Cell proportions vector and names of cell types must match in size.");
+   const auto num_cell_types{
+       static_cast<std::size_t>(deconvolver.cellProportions().size())};
+   const std::string output_buffer{formatProportions(
+       generateCellTypeList(config, num_cell_types),
+       deconvolver.cellProportions())};
+
+   if (config.out_file_path.empty()) {
+      std::fwrite(output_buffer.data(), 1, output_buffer.size(), stdout);
+      std::fflush(stdout);
+   } else {
+      writeToFile(output_buffer, config.out_file_path);
+   }
+}
+
+/**
+ * Each block starts with a "# <reference matrix>" line, followed by the cell
+ * types and their proportions (as in writeMetrics()). Blocks are separated by
+ * an empty line.
+ * @throws FileWriteException if file writing fails
+ */
+void writePanelResults(const CMD::HylordConfig& config,
+                       const std::vector<PanelResult>& results) {
+   std::string output_buffer;
+   for (std::size_t panel{}; panel < results.size(); ++panel) {
+      const PanelResult& result{results[panel]};
+      if (panel > 0) output_buffer += '\n';
+      output_buffer += "# " + result.reference_matrix_file + '\n' +
+                       formatProportions(result.cell_type_list,
+                                         result.cell_proportions);
+   }
+
+   if (config.out_file_path.empty()) {
+      std::fwrite(output_buffer.data(), 1, output_buffer.size(), stdout);
+      std::fflush(stdout);
+   } else {
+      writeToFile(output_buffer, config.out_file_path);
+   }
+}
+
+/**
+ * Outputs the number and percentage of reads assigned to each cell type,
+ * followed by the reads that couldn't be assigned (too few calls at reference
+ * CpG sites). Written to stdout if no output file is specified.
+ * @throws FileWriteException if file writing fails
+ */
+void writeReadCounts(const CMD::HylordConfig& config,
+                     const std::vector<BedRecords::CellType>& cell_type_list,
+                     const std::vector<std::size_t>& read_counts,
+                     std::size_t unassigned_reads) {
+   assert(cell_type_list.size() == read_counts.size() &&
+          "Read counts and names of cell types must match in size.");
+
+   std::size_t total_reads{unassigned_reads};
+   for (const auto count : read_counts) total_reads += count;
+   auto percentage{[total_reads](std::size_t count) -> double {
+      if (total_reads == 0) return 0.0;
+      return Maths::convertToPercent(static_cast<double>(count) /
+                                     static_cast<double>(total_reads));
+   }};
 
    std::stringstream output_buffer;
    for (std::size_t i{}; i < cell_type_list.size(); ++i) {
-      output_buffer
-          << cell_type_list[i].cell_type << '\t'
-          << Maths::convertToPercent(
-                 deconvolver.cellProportions()[static_cast<Eigen::Index>(i)])
-          << '\n';
+      output_buffer << cell_type_list[i].cell_type << '\t' << read_counts[i]
+                    << '\t' << percentage(read_counts[i]) << '\n';
    }
+   output_buffer << "unassigned\t" << unassigned_reads << '\t'
+                 << percentage(unassigned_reads) << '\n';
 
    if (config.out_file_path.empty()) {
       std::cout << output_buffer.str();
@@ -175,4 +320,120 @@ void writeMetrics(const CMD::HylordConfig& config,
    }
 }
 
+/// @throws FileWriteException if file writing fails
+void writeQCReport(const CMD::HylordConfig& config,
+                   const ParseStatistics& statistics) {
+   std::stringstream output_buffer;
+   statistics.write(output_buffer);
+   writeToFile(output_buffer, config.qc_report_file);
+}
+
+/// @throws FileWriteException if file writing fails
+void writeCDFs(const CMD::HylordConfig& config,
+               const std::vector<MarkCDF>& cdfs) {
+   const std::string output_buffer{formatCDFs(cdfs)};
+   if (config.out_file_path.empty()) {
+      std::cout << output_buffer;
+   } else {
+      writeToFile(output_buffer, config.out_file_path);
+   }
+}
+
+/**
+ * Outputs a header, then a row per configuration: its filters, the number of
+ * CpGs passing them, the objective and the percentage of each cell type.
+ * Configurations that no CpGs pass are given NA values.
+ * @throws FileWriteException if file writing fails
+ */
+void writeSweepResults(const CMD::HylordConfig& config,
+                       const std::vector<BedRecords::CellType>& cell_type_list,
+                       const std::vector<Sweep::Result>& results) {
+   std::stringstream output_buffer;
+   output_buffer << "min_read_depth\tmax_read_depth\tsignal\tcpgs\tobjective";
+   for (const auto& cell_type : cell_type_list) {
+      output_buffer << '\t' << cell_type.cell_type;
+   }
+   output_buffer << '\n';
+
+   for (const auto& result : results) {
+      const Sweep::Configuration& configuration{result.configuration};
+      output_buffer << configuration.min_read_depth << '\t';
+      if (configuration.max_read_depth == std::numeric_limits<int>::max()) {
+         output_buffer << "inf";
+      } else {
+         output_buffer << configuration.max_read_depth;
+      }
+      output_buffer << '\t'
+                    << (configuration.signal == '\0'
+                            ? std::string{"both"}
+                            : std::string(1, configuration.signal))
+                    << '\t' << result.cpgs;
+      if (result.cell_proportions.size() == 0) {
+         output_buffer << "\tNA";
+         for (std::size_t i{}; i < cell_type_list.size(); ++i) {
+            output_buffer << "\tNA";
+         }
+      } else {
+         output_buffer << '\t' << result.objective;
+         for (const double proportion : result.cell_proportions) {
+            output_buffer << '\t' << Maths::convertToPercent(proportion);
+         }
+      }
+      output_buffer << '\n';
+   }
+
+   if (config.out_file_path.empty()) {
+      std::cout << output_buffer.str();
+   } else {
+      writeToFile(output_buffer, config.out_file_path);
+   }
+}
+
+void writeBatchResults(const CMD::HylordConfig& config,
+                       const std::vector<BedRecords::CellType>& cell_type_list,
+                       const std::vector<std::string>& sample_names,
+                       const Deconvolution::BatchResult& result) {
+   assert(sample_names.size() ==
+          static_cast<std::size_t>(result.cell_proportions.cols()));
+   std::stringstream output_buffer;
+   output_buffer << "sample\tobjective";
+   for (const auto& cell_type : cell_type_list) {
+      output_buffer << '\t' << cell_type.cell_type;
+   }
+   output_buffer << '\n';
+
+   for (std::size_t sample{}; sample < sample_names.size(); ++sample) {
+      const auto column{static_cast<Eigen::Index>(sample)};
+      output_buffer << sample_names[sample] << '\t'
+                    << result.objectives(column);
+      for (const double proportion : result.cell_proportions.col(column)) {
+         output_buffer << '\t' << Maths::convertToPercent(proportion);
+      }
+      output_buffer << '\n';
+   }
+
+   if (config.out_file_path.empty()) {
+      std::cout << output_buffer.str();
+   } else {
+      writeToFile(output_buffer, config.out_file_path);
+   }
+}
+
+/// Unassigned reads are written with a cell type of "unassigned".
+void writeReadAssignments(
+    std::ostream& out,
+    const std::vector<ReadAssignment::Assignment>& assignments,
+    const std::vector<BedRecords::CellType>& cell_type_list) {
+   for (const auto& assignment : assignments) {
+      out << assignment.read_id << '\t'
+          << (assignment.cell_type == ReadAssignment::Assignment::unassigned
+                  ? "unassigned"
+                  : cell_type_list[static_cast<std::size_t>(
+                                       assignment.cell_type)]
+                        .cell_type)
+          << '\t' << assignment.posterior << '\t' << assignment.calls
+          << '\n';
+   }
+}
+
 }  // namespace Hylord::IO
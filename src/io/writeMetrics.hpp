@@ -9,14 +9,99 @@
  * file in the repository root or https://mit-license.org)
  */
 
+#include <cstddef>
+#include <filesystem>
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+#include <string>
+#include <string_view>
+
 #include "cli.hpp"
+#include "core/BatchSolver.hpp"
 #include "core/Deconvolver.hpp"
+#include "core/ReadAssigner.hpp"
+#include "core/Sweep.hpp"
+#include "data/BedRecords.hpp"
+#include "io/CDFFile.hpp"
+#include "io/ParseStatistics.hpp"
+#include "types.hpp"
 
 namespace Hylord::IO {
 /// Writes deconvolution results to stdout or file (given by user).
 void writeMetrics(const CMD::HylordConfig& config,
                   const Deconvolution::Deconvolver& deconvolver);
 
+/// Formats a "<cell type>\t<percentage>" line per cell type, as written by
+/// writeMetrics().
+auto formatProportions(const std::vector<BedRecords::CellType>& cell_type_list,
+                       const Vector& cell_proportions) -> std::string;
+
+/// Writes the number of reads assigned to each cell type to stdout or file.
+void writeReadCounts(const CMD::HylordConfig& config,
+                     const std::vector<BedRecords::CellType>& cell_type_list,
+                     const std::vector<std::size_t>& read_counts,
+                     std::size_t unassigned_reads);
+
+/// Writes a row per configuration of a sweep (see Sweep) to stdout or file.
+void writeSweepResults(const CMD::HylordConfig& config,
+                       const std::vector<BedRecords::CellType>& cell_type_list,
+                       const std::vector<Sweep::Result>& results);
+
+/// Writes a row per sample of a bulk matrix (see --bulk-matrix) to stdout or
+/// file.
+void writeBatchResults(const CMD::HylordConfig& config,
+                       const std::vector<BedRecords::CellType>& cell_type_list,
+                       const std::vector<std::string>& sample_names,
+                       const Deconvolution::BatchResult& result);
+
+/// Proportions found against one of several reference panels (see
+/// --reference-matrix).
+struct PanelResult {
+   std::string reference_matrix_file;
+   std::vector<BedRecords::CellType> cell_type_list;
+   Vector cell_proportions;
+};
+
+/// Writes a block of proportions per reference panel to stdout or file.
+void writePanelResults(const CMD::HylordConfig& config,
+                       const std::vector<PanelResult>& results);
+
+/// Writes the depth and methylation histograms gathered whilst parsing the
+/// bedmethyl data (see ParseStatistics::write()) to --qc-report.
+void writeQCReport(const CMD::HylordConfig& config,
+                   const ParseStatistics& statistics);
+
+/// Writes CDFs fitted by the fit-cdf subcommand (see formatCDFs()) to
+/// stdout or file.
+void writeCDFs(const CMD::HylordConfig& config,
+               const std::vector<MarkCDF>& cdfs);
+
+/// Writes one line per read (read_id, cell type, posterior, calls).
+void writeReadAssignments(
+    std::ostream& out,
+    const std::vector<ReadAssignment::Assignment>& assignments,
+    const std::vector<BedRecords::CellType>& cell_type_list);
+
+/// Names the cell types of the reference matrix (see implementation).
+auto generateCellTypeList(const CMD::HylordConfig& config,
+                          std::size_t number_of_cell_types)
+    -> std::vector<BedRecords::CellType>;
+
+/// Names the samples of a bulk matrix (see implementation).
+auto generateSampleNames(const CMD::HylordConfig& config,
+                         std::size_t number_of_samples)
+    -> std::vector<std::string>;
+
+/// Checks the output path can be written to, returning a path that won't
+/// overwrite an existing file.
+auto resolveOutputPath(const std::filesystem::path& out_path)
+    -> std::filesystem::path;
+
+/// Writes the buffer to a path resolved by resolveOutputPath().
+void writeToFile(std::string_view buffer,
+                 const std::filesystem::path& out_path);
 void writeToFile(const std::stringstream& buffer,
                  const std::filesystem::path& out_path);
 }  // namespace Hylord::IO
@@ -5,11 +5,10 @@
  * file in the repository root or https://mit-license.org)
  */
 
-#include <thread>
-
 #include "CLI/CLI.hpp"
 #include "cli.hpp"
 #include "core/hylord.hpp"
+#include "parallel/Affinity.hpp"
 
 int main(int argc, char** argv) {
    try {
@@ -20,8 +19,8 @@ int main(int argc, char** argv) {
       CLI11_PARSE(hylord_cli, argc, argv);
 
       if (config.num_threads == 0)
-         config.num_threads =
-             static_cast<int>(std::thread::hardware_concurrency());
+         config.num_threads = Hylord::Parallel::availableCores();
+      Hylord::Parallel::enableThreadPinning(config.pin_threads);
 
       return Hylord::run(config);
    } catch (...) {
@@ -7,10 +7,50 @@
 
 #include "maths/LinearAlgebra.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
 #include "HylordException.hpp"
+#include "parallel/ParallelFor.hpp"
+#include "simd/Dispatch.hpp"
 #include "types.hpp"
 
 namespace Hylord::LinearAlgebra {
+namespace {
+/// Rows processed at once, so the block of every column stays in cache whilst
+/// it is reused for each pair of columns.
+constexpr Eigen::Index row_block_size{256};
+
+template <typename Bulk>
+void checkRowsMatch(const Eigen::Ref<const Matrix>& reference_matrix,
+                    const Bulk& bulk_data) {
+   // Shouldn't happen under proper usage
+   if (reference_matrix.rows() != bulk_data.rows()) {
+      throw DeconvolutionException(
+          "Coefficient Vector Generation",
+          "CpGs in bulk_data must be equal to CpGs in reference data.");
+   }
+}
+
+/// Turns an accumulated upper triangle of Gram products into the QPP's
+/// Hessian.
+void finishHessian(Matrix& hessian) {
+   hessian.triangularView<Eigen::StrictlyLower>() = hessian.transpose();
+   hessian.diagonal().array() += gram_regularisation;
+}
+
+/// Turns accumulated upper triangle Gram and bulk products into the QPP's
+/// Hessian and linear terms.
+void finishQuadraticTerms(QuadraticTerms& terms) {
+   finishHessian(terms.hessian);
+   terms.linear_terms = -terms.linear_terms;
+}
+}  // namespace
+
 /**
  * Calculates the Gram matrix (X^T * X) and adds a small diagonal
  * regularization term. The regularization term (ε*I) helps ensure numerical
@@ -19,9 +59,9 @@ namespace Hylord::LinearAlgebra {
  */
 auto gramMatrix(const Matrix& matrix) -> Matrix {
    Matrix gram_matrix{matrix.transpose() * matrix};
-   static constexpr double epsilon{1e-8};
-   return gram_matrix +=
-          epsilon * Matrix::Identity(gram_matrix.rows(), gram_matrix.cols());
+   return gram_matrix += gram_regularisation *
+                         Matrix::Identity(gram_matrix.rows(),
+                                          gram_matrix.cols());
 }
 
 /**
@@ -32,37 +72,175 @@ auto gramMatrix(const Matrix& matrix) -> Matrix {
  */
 auto generateCoefficientVector(const Matrix& reference_matrix,
                                const Vector& bulk_data) -> Vector {
-   // Shouldn't happen under proper usage
-   if (reference_matrix.rows() != bulk_data.rows()) {
-      throw DeconvolutionException(
-          "Coefficient Vector Generation",
-          "CpGs in bulk_data must be equal to CpGs in reference data.");
-   }
+   checkRowsMatch(reference_matrix, bulk_data);
    return -(bulk_data.transpose() * reference_matrix);
 }
 
+/**
+ * Walks the reference matrix once in blocks of rows, accumulating every
+ * column pair product and the products with the bulk profile whilst the block
+ * is in cache. The inner products use the kernels of the instruction set
+ * selected at startup (see Simd::kernels()).
+ * @throws DeconvolutionException if row dimensions don't match
+ */
+auto quadraticTerms(const Eigen::Ref<const Matrix>& reference_matrix,
+                    const Eigen::Ref<const Vector>& bulk_data)
+    -> QuadraticTerms {
+   checkRowsMatch(reference_matrix, bulk_data);
+   const Eigen::Index rows{reference_matrix.rows()};
+   const Eigen::Index cols{reference_matrix.cols()};
+   QuadraticTerms terms{.hessian = Matrix::Zero(cols, cols),
+                        .linear_terms = Vector::Zero(cols)};
+
+   const auto& kernels{Simd::kernels()};
+   for (Eigen::Index block_start{}; block_start < rows;
+        block_start += row_block_size) {
+      kernels.accumulate_gram(reference_matrix.data() + block_start,
+                              reference_matrix.outerStride(),
+                              std::min(row_block_size, rows - block_start),
+                              cols,
+                              bulk_data.data() + block_start,
+                              terms.hessian.data(),
+                              terms.linear_terms.data());
+   }
+   finishQuadraticTerms(terms);
+   return terms;
+}
+
+/**
+ * The Hessian is a symmetric rank update (half of the products of a full
+ * matrix product) and the linear terms a single matrix product, split into
+ * blocks of bulk profiles that are multiplied concurrently.
+ * @throws DeconvolutionException if row dimensions don't match
+ */
+auto batchQuadraticTerms(const Eigen::Ref<const Matrix>& reference_matrix,
+                         const Eigen::Ref<const Matrix>& bulk_profiles,
+                         int threads) -> BatchQuadraticTerms {
+   checkRowsMatch(reference_matrix, bulk_profiles);
+   const Eigen::Index cols{reference_matrix.cols()};
+   BatchQuadraticTerms terms{
+       .hessian = Matrix::Zero(cols, cols),
+       .linear_terms = Matrix(cols, bulk_profiles.cols())};
+   terms.hessian.selfadjointView<Eigen::Upper>().rankUpdate(
+       reference_matrix.transpose());
+   finishHessian(terms.hessian);
+
+   Parallel::forEachBlock(
+       static_cast<std::size_t>(bulk_profiles.cols()),
+       threads,
+       [&](const Parallel::Block& block) {
+          const auto begin{static_cast<Eigen::Index>(block.begin)};
+          const auto size{static_cast<Eigen::Index>(block.end - block.begin)};
+          terms.linear_terms.middleCols(begin, size).noalias() =
+              -(reference_matrix.transpose() *
+                bulk_profiles.middleCols(begin, size));
+       });
+   return terms;
+}
+
+/// @throws DeconvolutionException if row dimensions don't match
+auto residualNorm(const Eigen::Ref<const Matrix>& reference_matrix,
+                  const Vector& cell_proportions,
+                  const Eigen::Ref<const Vector>& bulk_data) -> double {
+   checkRowsMatch(reference_matrix, bulk_data);
+   return std::sqrt(Simd::kernels().residual_squared_norm(
+       reference_matrix.data(),
+       reference_matrix.outerStride(),
+       reference_matrix.rows(),
+       reference_matrix.cols(),
+       cell_proportions.data(),
+       bulk_data.data()));
+}
+
 /**
  * Extends the reference matrix by solving for additional cell type profiles
  * using bulk data. Requires the reference matrix to have space allocated for
  * additional cell types. Uses pseudoinverse to solve for new profiles based on
- * residual bulk signal. See @ref reference-matrix-updating for a mathematical
+ * residual bulk signal, clamping them to [0, 1] so that they remain valid
+ * methylation levels. See @ref reference-matrix-updating for a mathematical
  * explanation of this.
- * @throws std::invalid_argument if additional_cell_types is not positive
+ *
+ * Each block of rows is updated, then fed to the Gram and residual kernels
+ * whilst it is still in cache, so an iteration reads the matrix once rather
+ * than three times (update, Hessian, objective). Blocks are split across
+ * threads, with the partial sums of each thread added in order.
+ * @throws std::invalid_argument if the novel cell types have (close to) zero
+ * proportions
  */
-void updateReferenceMatrix(Eigen::Ref<Matrix> reference_matrix,
+auto updateReferenceMatrix(Eigen::Ref<Matrix> reference_matrix,
                            const Vector& cell_proportions,
-                           const Vector& bulk_profile,
-                           int additional_cell_types) {
+                           const Eigen::Ref<const Vector>& bulk_profile,
+                           int additional_cell_types,
+                           int threads) -> ReferenceUpdate {
    assert(additional_cell_types > 0 &&
           "Reference matrix must be extended from original.");
-   const int total_cell_types{static_cast<int>(reference_matrix.cols())};
-   const int num_base_cell_types{total_cell_types - additional_cell_types};
+   checkRowsMatch(reference_matrix, bulk_profile);
+   const Eigen::Index rows{reference_matrix.rows()};
+   const Eigen::Index cols{reference_matrix.cols()};
+   const Eigen::Index num_base_cell_types{cols - additional_cell_types};
+   const Eigen::RowVectorXd novel_inverse{
+       pseudoInverse(cell_proportions.tail(additional_cell_types))};
 
-   auto r_k = reference_matrix.leftCols(num_base_cell_types);
-   auto p_k = cell_proportions.head(num_base_cell_types);
-   const auto p_l = cell_proportions.tail(additional_cell_types);
+   const auto& kernels{Simd::kernels()};
+   const auto num_rows{static_cast<std::size_t>(rows)};
+   std::vector<ReferenceUpdate> partials(
+       Parallel::numberOfBlocks(num_rows, threads));
+   Parallel::forEachBlock(
+       num_rows, threads, [&](const Parallel::Block& block) {
+          ReferenceUpdate& partial{partials[block.index]};
+          partial.terms = {.hessian = Matrix::Zero(cols, cols),
+                           .linear_terms = Vector::Zero(cols)};
+          std::array<double, row_block_size> residual_buffer{};
+          for (auto begin{static_cast<Eigen::Index>(block.begin)};
+               begin < static_cast<Eigen::Index>(block.end);
+               begin += row_block_size) {
+             const Eigen::Index size{
+                 std::min(row_block_size,
+                          static_cast<Eigen::Index>(block.end) - begin)};
+             Eigen::Map<Vector> residual{residual_buffer.data(), size};
+             residual = bulk_profile.segment(begin, size);
+             residual.noalias() -=
+                 reference_matrix.middleRows(begin, size).leftCols(
+                     num_base_cell_types) *
+                 cell_proportions.head(num_base_cell_types);
+             for (Eigen::Index novel{}; novel < additional_cell_types;
+                  ++novel) {
+                double* column{
+                    reference_matrix.col(num_base_cell_types + novel)
+                        .data() +
+                    begin};
+                for (Eigen::Index i{}; i < size; ++i) {
+                   column[i] = std::clamp(
+                       residual(i) * novel_inverse(novel), 0.0, 1.0);
+                }
+             }
 
-   reference_matrix.rightCols(additional_cell_types) =
-       (bulk_profile - r_k * p_k) * LinearAlgebra::pseudoInverse(p_l);
+             const double* block_start{reference_matrix.data() + begin};
+             kernels.accumulate_gram(block_start,
+                                     reference_matrix.outerStride(),
+                                     size,
+                                     cols,
+                                     bulk_profile.data() + begin,
+                                     partial.terms.hessian.data(),
+                                     partial.terms.linear_terms.data());
+             partial.objective += kernels.residual_squared_norm(
+                 block_start,
+                 reference_matrix.outerStride(),
+                 size,
+                 cols,
+                 cell_proportions.data(),
+                 bulk_profile.data() + begin);
+          }
+       });
+
+   ReferenceUpdate update{partials.front()};
+   for (std::size_t i{1}; i < partials.size(); ++i) {
+      update.terms.hessian += partials[i].terms.hessian;
+      update.terms.linear_terms += partials[i].terms.linear_terms;
+      update.objective += partials[i].objective;
+   }
+   finishQuadraticTerms(update.terms);
+   update.objective = std::sqrt(update.objective);
+   return update;
 }
 }  // namespace Hylord::LinearAlgebra
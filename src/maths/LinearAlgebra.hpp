@@ -14,6 +14,9 @@
 
 /// Eigen utilities for main HyLoRD QPP solving
 namespace Hylord::LinearAlgebra {
+/// Added to the diagonal of Gram matrices (see gramMatrix()).
+inline constexpr double gram_regularisation{1e-8};
+
 /// Computes the Gram matrix of the input matrix with added regularization.
 auto gramMatrix(const Matrix& matrix) -> Matrix;
 
@@ -21,6 +24,35 @@ auto gramMatrix(const Matrix& matrix) -> Matrix;
 auto generateCoefficientVector(const Matrix& reference_matrix,
                                const Vector& bulk_data) -> Vector;
 
+/// Hessian and linear terms of the deconvolution QPP
+struct QuadraticTerms {
+   Matrix hessian;
+   Vector linear_terms;
+};
+
+/// Computes gramMatrix() and generateCoefficientVector() in one pass.
+auto quadraticTerms(const Eigen::Ref<const Matrix>& reference_matrix,
+                    const Eigen::Ref<const Vector>& bulk_data)
+    -> QuadraticTerms;
+
+/// Hessian and linear terms (one column per bulk profile) of the QPPs of
+/// bulk profiles that cover the same rows of the reference matrix
+struct BatchQuadraticTerms {
+   Matrix hessian;
+   Matrix linear_terms;
+};
+
+/// Computes the Hessian once and the linear terms of every bulk profile
+/// (columns of `bulk_profiles`).
+auto batchQuadraticTerms(const Eigen::Ref<const Matrix>& reference_matrix,
+                         const Eigen::Ref<const Matrix>& bulk_profiles,
+                         int threads) -> BatchQuadraticTerms;
+
+/// Computes ||bulk - reference * proportions|| (the objective function).
+auto residualNorm(const Eigen::Ref<const Matrix>& reference_matrix,
+                  const Vector& cell_proportions,
+                  const Eigen::Ref<const Vector>& bulk_data) -> double;
+
 /**
  * Computes the pseudoinverse of a column vector.
  *
@@ -44,14 +76,23 @@ auto pseudoInverse(const Eigen::MatrixBase<Derived>& vec)
    return vec.transpose() / squared_norm;
 }
 
+/// Quadratic terms and objective of a reference matrix after an update.
+struct ReferenceUpdate {
+   QuadraticTerms terms;
+   double objective{};
+};
+
 /**
  * @brief Update process for unknown reference profiles (see @ref
- * reference-matrix-updating for more info).
+ * reference-matrix-updating for more info). The quadratic terms and the
+ * objective of the updated matrix are computed in the same pass (see
+ * quadraticTerms() and residualNorm()).
  */
-void updateReferenceMatrix(Eigen::Ref<Matrix> reference_matrix,
+auto updateReferenceMatrix(Eigen::Ref<Matrix> reference_matrix,
                            const Vector& cell_proportions,
-                           const Vector& bulk_profile,
-                           int additional_cell_types);
+                           const Eigen::Ref<const Vector>& bulk_profile,
+                           int additional_cell_types,
+                           int threads) -> ReferenceUpdate;
 
 }  // namespace Hylord::LinearAlgebra
 
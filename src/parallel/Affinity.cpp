@@ -0,0 +1,167 @@
+/**
+ * @file    Affinity.cpp
+ * @brief   Defines helpers for placing threads and memory on the CPUs that
+ * HyLoRD is allowed to use.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "parallel/Affinity.hpp"
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Hylord::Parallel {
+namespace {
+std::atomic<bool> pinning_enabled{false};
+/// CPUs of the affinity mask, found when pinning is enabled.
+std::vector<int> pinning_cpus{};
+/// Index of the CPU the thread was last pinned to (see currentCore()).
+thread_local std::size_t current_core{};
+
+/// CPUs in the affinity mask of the process.
+auto allowedCpus() -> std::vector<int> {
+   std::vector<int> cpus{};
+   cpu_set_t cpu_set;
+   CPU_ZERO(&cpu_set);
+   if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+      for (int cpu{}; cpu < CPU_SETSIZE; ++cpu) {
+         if (CPU_ISSET(cpu, &cpu_set)) cpus.push_back(cpu);
+      }
+   }
+   return cpus;
+}
+
+/// Rounds a quota (in microseconds per period) up to whole CPUs.
+auto quotaToCores(double quota, double period) -> std::optional<int> {
+   if (quota <= 0 || period <= 0) return std::nullopt;
+   return std::max(1, static_cast<int>((quota + period - 1) / period));
+}
+
+/// Reads a cgroup v2 cpu.max file ("max 100000" or "<quota> <period>").
+auto cgroupV2Quota(const std::string& path) -> std::optional<int> {
+   std::ifstream file(path);
+   std::string quota;
+   double period{};
+   if (!(file >> quota >> period) || quota == "max") return std::nullopt;
+   try {
+      return quotaToCores(std::stod(quota), period);
+   } catch (const std::exception&) {
+      return std::nullopt;
+   }
+}
+
+/// Reads the quota and period files of a cgroup v1 cpu controller.
+auto cgroupV1Quota(const std::string& directory) -> std::optional<int> {
+   std::ifstream quota_file(directory + "/cpu.cfs_quota_us");
+   std::ifstream period_file(directory + "/cpu.cfs_period_us");
+   double quota{};
+   double period{};
+   if (!(quota_file >> quota) || !(period_file >> period)) {
+      return std::nullopt;
+   }
+   return quotaToCores(quota, period);
+}
+
+/**
+ * Finds the CPU quota of the cgroup of the process. The cgroup v2 path is
+ * taken from /proc/self/cgroup, falling back to the root of the hierarchy
+ * (which is the container's own cgroup under a cgroup namespace).
+ */
+auto cgroupQuota() -> std::optional<int> {
+   std::ifstream cgroups("/proc/self/cgroup");
+   std::string line;
+   while (std::getline(cgroups, line)) {
+      if (line.starts_with("0::")) {
+         const std::string path{line.substr(3)};
+         const auto cores{cgroupV2Quota("/sys/fs/cgroup" + path + "/cpu.max")};
+         if (cores) return cores;
+      }
+   }
+   if (auto cores{cgroupV2Quota("/sys/fs/cgroup/cpu.max")}) return cores;
+   if (auto cores{cgroupV1Quota("/sys/fs/cgroup/cpu,cpuacct")}) return cores;
+   return cgroupV1Quota("/sys/fs/cgroup/cpu");
+}
+}  // namespace
+
+auto availableCores() -> int {
+   static const int cores{[] {
+      const auto cpus{allowedCpus()};
+      int available{cpus.empty()
+                        ? static_cast<int>(std::thread::hardware_concurrency())
+                        : static_cast<int>(cpus.size())};
+      if (const auto quota{cgroupQuota()}) {
+         available = std::min(available, *quota);
+      }
+      return std::max(available, 1);
+   }()};
+   return cores;
+}
+
+void enableThreadPinning(bool enable) {
+   pinning_cpus = enable ? allowedCpus() : std::vector<int>{};
+   pinning_enabled = enable && !pinning_cpus.empty();
+}
+
+void pinToCore(std::size_t core) noexcept {
+   current_core = core;
+   if (!pinning_enabled.load(std::memory_order_relaxed)) return;
+   cpu_set_t cpu_set;
+   CPU_ZERO(&cpu_set);
+   CPU_SET(pinning_cpus[core % pinning_cpus.size()], &cpu_set);
+   // Pinning is only a placement hint, so failures are ignored
+   sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+}
+
+auto currentCore() noexcept -> std::size_t { return current_core; }
+
+auto nestedCore(std::size_t num_blocks, std::size_t block_index) noexcept
+    -> std::size_t {
+   return current_core * num_blocks + block_index;
+}
+
+ScopedPin::ScopedPin(std::size_t core) noexcept :
+    m_previous_core{current_core} {
+   if (pinning_enabled.load(std::memory_order_relaxed)) {
+      m_restore_mask = sched_getaffinity(0,
+                                         sizeof(m_previous_mask),
+                                         &m_previous_mask) == 0;
+   }
+   pinToCore(core);
+}
+
+ScopedPin::~ScopedPin() {
+   if (m_restore_mask) {
+      sched_setaffinity(0, sizeof(m_previous_mask), &m_previous_mask);
+   }
+   current_core = m_previous_core;
+}
+
+/// Buffers smaller than a huge page (2 MiB on x86-64) are left alone.
+void adviseHugePages(void* data, std::size_t bytes) noexcept {
+   constexpr std::size_t huge_page_size{std::size_t{2} << 20U};
+   if (data == nullptr || bytes < huge_page_size) return;
+   const auto page_size{static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE))};
+   const auto begin{reinterpret_cast<std::uintptr_t>(data)};
+   const auto first_page{(begin + page_size - 1) & ~(page_size - 1)};
+   const auto last_page{(begin + bytes) & ~(page_size - 1)};
+   if (last_page <= first_page) return;
+#ifdef MADV_HUGEPAGE
+   madvise(reinterpret_cast<void*>(first_page),
+           last_page - first_page,
+           MADV_HUGEPAGE);
+#endif
+}
+}  // namespace Hylord::Parallel
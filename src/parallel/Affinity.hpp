@@ -0,0 +1,80 @@
+#ifndef AFFINITY_H_
+#define AFFINITY_H_
+
+/**
+ * @file    Affinity.hpp
+ * @brief   Declares helpers for placing threads and memory on the CPUs that
+ * HyLoRD is allowed to use.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <sched.h>
+
+#include <cstddef>
+
+namespace Hylord::Parallel {
+/**
+ * Number of CPUs this process can actually use: the CPUs in its affinity
+ * mask (e.g. a SLURM cpuset), capped by any cgroup CPU quota (e.g. a
+ * container limit). Unlike std::thread::hardware_concurrency(), this doesn't
+ * oversubscribe restricted jobs. Always at least one.
+ */
+auto availableCores() -> int;
+
+/**
+ * Turns pinning of the threads of forEachBlock() on or off (see
+ * pinToCore()). Should be called before any parallel work starts.
+ */
+void enableThreadPinning(bool enable);
+
+/**
+ * Pins the calling thread to the `core`-th CPU of the affinity mask
+ * (wrapping around), if pinning is enabled. Blocks with the same index then
+ * always run on the same CPU, so memory they first touch stays on its NUMA
+ * node. Prefer ScopedPin, which undoes this.
+ */
+void pinToCore(std::size_t core) noexcept;
+
+/// Index (as passed to pinToCore()) of the CPU the calling thread was last
+/// pinned to, 0 if it never was.
+auto currentCore() noexcept -> std::size_t;
+
+/**
+ * Index of the CPU for the `block_index`-th of `num_blocks` blocks started
+ * from the calling thread. Blocks started from within a block are offset by
+ * that block's index, so nested blocks of different outer blocks (e.g. the
+ * readers of several reference panels) don't share CPUs.
+ */
+auto nestedCore(std::size_t num_blocks, std::size_t block_index) noexcept
+    -> std::size_t;
+
+/**
+ * Pins the calling thread (see pinToCore()) for the lifetime of this object,
+ * then restores the affinity mask it had before. Threads started meanwhile
+ * inherit the pinned mask, so long lived helpers shouldn't be started here.
+ */
+class ScopedPin {
+  public:
+   explicit ScopedPin(std::size_t core) noexcept;
+   ~ScopedPin();
+
+   ScopedPin(const ScopedPin&) = delete;
+   auto operator=(const ScopedPin&) -> ScopedPin& = delete;
+   ScopedPin(ScopedPin&&) = delete;
+   auto operator=(ScopedPin&&) -> ScopedPin& = delete;
+
+  private:
+   cpu_set_t m_previous_mask{};
+   bool m_restore_mask{false};
+   std::size_t m_previous_core{};
+};
+
+/**
+ * Asks the kernel to back the whole pages of a large buffer with transparent
+ * huge pages. Has to be called before the buffer is first written to.
+ */
+void adviseHugePages(void* data, std::size_t bytes) noexcept;
+}  // namespace Hylord::Parallel
+
+#endif
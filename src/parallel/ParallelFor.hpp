@@ -0,0 +1,94 @@
+#ifndef PARALLEL_FOR_H_
+#define PARALLEL_FOR_H_
+
+/**
+ * @file    ParallelFor.hpp
+ * @brief   Defines helpers for splitting index ranges across threads.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <vector>
+
+#include "parallel/Affinity.hpp"
+
+/// Utilities for running work across multiple threads
+namespace Hylord::Parallel {
+/// Half open range of indexes processed by a single thread.
+struct Block {
+   std::size_t index{};
+   std::size_t begin{};
+   std::size_t end{};
+};
+
+/**
+ * Determines how many blocks a range of the given size is split into. Never
+ * returns more blocks than there are elements (and always at least one).
+ */
+inline auto numberOfBlocks(std::size_t size, int threads) -> std::size_t {
+   return std::clamp<std::size_t>(
+       static_cast<std::size_t>(std::max(threads, 1)),
+       1,
+       std::max<std::size_t>(size, 1));
+}
+
+/// Gets the bounds of the i-th block when splitting size elements evenly.
+inline auto blockBounds(std::size_t size,
+                        std::size_t num_blocks,
+                        std::size_t block_index) -> Block {
+   const std::size_t block_size{size / num_blocks};
+   const std::size_t remainder{size % num_blocks};
+   const std::size_t begin{block_index * block_size +
+                           std::min(block_index, remainder)};
+   const std::size_t end{begin + block_size +
+                         (block_index < remainder ? 1 : 0)};
+   return {.index = block_index, .begin = begin, .end = end};
+}
+
+/**
+ * Splits [0, size) into contiguous blocks (see numberOfBlocks()) and calls
+ * `function(block)` for each of them concurrently. The first block is
+ * processed on the calling thread. If any block throws, the first exception
+ * is rethrown once every block has finished. Each block's thread is pinned
+ * to a CPU when pinning is enabled (see nestedCore()), the calling thread
+ * only whilst it processes the first block.
+ */
+template <typename Function>
+void forEachBlock(std::size_t size, int threads, Function&& function) {
+   const std::size_t num_blocks{numberOfBlocks(size, threads)};
+   std::vector<std::future<void>> futures;
+   futures.reserve(num_blocks - 1);
+   for (std::size_t i{1}; i < num_blocks; ++i) {
+      futures.push_back(std::async(
+          std::launch::async,
+          [&function,
+           block = blockBounds(size, num_blocks, i),
+           core = nestedCore(num_blocks, i)]() {
+             const ScopedPin pin{core};
+             function(block);
+          }));
+   }
+
+   std::exception_ptr first_exception{};
+   try {
+      const ScopedPin pin{nestedCore(num_blocks, 0)};
+      function(blockBounds(size, num_blocks, 0));
+   } catch (...) {
+      first_exception = std::current_exception();
+   }
+   for (auto& future : futures) {
+      try {
+         future.get();
+      } catch (...) {
+         if (!first_exception) first_exception = std::current_exception();
+      }
+   }
+   if (first_exception) std::rethrow_exception(first_exception);
+}
+}  // namespace Hylord::Parallel
+
+#endif
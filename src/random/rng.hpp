@@ -26,7 +26,14 @@ inline auto generate() -> pcg32 {
    pcg32 rng(seed_source);
    return rng;
 }
-inline pcg32 rng{generate()};
+/**
+ * Generator used by HyLoRD. Seeded on first use, so runs that never draw
+ * random values (no novel cell types) don't pay for gathering entropy.
+ */
+inline auto rng() -> pcg32& {
+   static pcg32 generator{generate()};
+   return generator;
+}
 
 /**
  * Discrete CDF approximating the bimodal distribution of CpG methylation rates
@@ -71,6 +78,21 @@ static const inline CDF hydroxymethylation_cdf{0.23067502,
                                                0.99975449,
                                                1};
 
+/// CDFs that novel cell type profiles are drawn from.
+struct CDFs {
+   CDF methylation{methylation_cdf};
+   CDF hydroxymethylation{hydroxymethylation_cdf};
+};
+
+/**
+ * CDFs used by HyLoRD. The built in tables unless replaced at startup by
+ * fitted ones (see --cdf and the fit-cdf subcommand).
+ */
+inline auto cdfs() -> CDFs& {
+   static CDFs fitted{};
+   return fitted;
+}
+
 /**
  * Samples a random value from a given cumulative distribution function (CDF).
  *
@@ -81,7 +103,7 @@ static const inline CDF hydroxymethylation_cdf{0.23067502,
  */
 inline auto getRandomValueFromCDF(const CDF& cdf) -> double {
    const double random_value{
-       std::uniform_real_distribution<double>(0.0, 1.0)(rng)};
+       std::uniform_real_distribution<double>(0.0, 1.0)(rng())};
    auto cdf_lower_bound{std::ranges::lower_bound(cdf, random_value)};
    auto sampled_index{std::distance(cdf.begin(), cdf_lower_bound)};
 
@@ -0,0 +1,75 @@
+/**
+ * @file    Dispatch.cpp
+ * @brief   Defines runtime selection of instruction set specific kernels.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "simd/Dispatch.hpp"
+
+#include <string_view>
+
+#include "simd/Kernels.hpp"
+
+namespace Hylord::Simd {
+/**
+ * __builtin_cpu_supports also checks that the operating system saves the
+ * wider registers, so a supported instruction set is safe to use.
+ */
+auto detectIsa() -> Isa {
+#ifdef HYLORD_SIMD_X86
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx512f") &&
+       __builtin_cpu_supports("avx512bw") &&
+       __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("bmi2")) {
+      return Isa::avx512;
+   }
+   if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+       __builtin_cpu_supports("bmi")) {
+      return Isa::avx2;
+   }
+   if (__builtin_cpu_supports("sse2")) return Isa::sse2;
+#endif
+   return Isa::generic;
+}
+
+auto selectedIsa() -> Isa {
+   static const Isa isa{detectIsa()};
+   return isa;
+}
+
+auto isaName(Isa isa) -> std::string_view {
+   switch (isa) {
+      case Isa::sse2:
+         return "SSE2";
+      case Isa::avx2:
+         return "AVX2";
+      case Isa::avx512:
+         return "AVX-512";
+      case Isa::generic:
+         break;
+   }
+   return "generic";
+}
+
+auto kernelsFor([[maybe_unused]] Isa isa) -> const Kernels& {
+#ifdef HYLORD_SIMD_X86
+   switch (isa) {
+      case Isa::avx512:
+         return avx512Kernels();
+      case Isa::avx2:
+         return avx2Kernels();
+      case Isa::sse2:
+         return sse2Kernels();
+      case Isa::generic:
+         break;
+   }
+#endif
+   return genericKernels();
+}
+
+auto kernels() -> const Kernels& {
+   static const Kernels& selected{kernelsFor(selectedIsa())};
+   return selected;
+}
+}  // namespace Hylord::Simd
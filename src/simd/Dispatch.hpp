@@ -0,0 +1,74 @@
+#ifndef SIMD_DISPATCH_H_
+#define SIMD_DISPATCH_H_
+
+/**
+ * @file    Dispatch.hpp
+ * @brief   Declares runtime selection of instruction set specific kernels.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <cstddef>
+#include <string_view>
+
+/// Hot kernels with variants for several instruction sets
+namespace Hylord::Simd {
+/// Instruction sets kernels are provided for (in increasing order).
+enum class Isa { generic, sse2, avx2, avx512 };
+
+/**
+ * @brief Table of the kernels used by the parsing and maths hot loops.
+ *
+ * Release builds target a baseline CPU, so the wider instruction sets can't
+ * be used by the compiler directly. Instead, each kernel is compiled once per
+ * instruction set (see Kernels.hpp) and the best variant the CPU supports is
+ * chosen the first time kernels() is called.
+ */
+struct Kernels {
+   /// First tab or space in [begin, end), or end if there is none.
+   const char* (*find_delimiter)(const char* begin, const char* end);
+   /**
+    * Parses a fixed format decimal starting at cursor (see
+    * IO::parseFixedDecimal), returning where it ended or nullptr if the text
+    * isn't in that format. Bytes up to readable_end may be read.
+    */
+   const char* (*parse_fixed_decimal)(const char* cursor,
+                                      const char* readable_end,
+                                      double& value);
+   /**
+    * Accumulates the Gram matrix (upper triangle of the column-major
+    * cols x cols `gram`) and the products with `bulk` (`linear`) of `rows`
+    * rows of a column-major matrix with the given column stride.
+    */
+   void (*accumulate_gram)(const double* columns,
+                           std::ptrdiff_t stride,
+                           std::ptrdiff_t rows,
+                           std::ptrdiff_t cols,
+                           const double* bulk,
+                           double* gram,
+                           double* linear);
+   /// Squared norm of bulk - matrix * proportions over `rows` rows of a
+   /// column-major matrix with the given column stride.
+   double (*residual_squared_norm)(const double* columns,
+                                   std::ptrdiff_t stride,
+                                   std::ptrdiff_t rows,
+                                   std::ptrdiff_t cols,
+                                   const double* proportions,
+                                   const double* bulk);
+};
+
+/// Best instruction set supported by the CPU (and the operating system).
+auto detectIsa() -> Isa;
+/// Instruction set of the kernels returned by kernels().
+auto selectedIsa() -> Isa;
+auto isaName(Isa isa) -> std::string_view;
+/// Kernels for the selected instruction set.
+auto kernels() -> const Kernels&;
+/**
+ * Kernels for a specific instruction set, for comparing variants. The caller
+ * must check the instruction set is supported (isa <= detectIsa()).
+ */
+auto kernelsFor(Isa isa) -> const Kernels&;
+}  // namespace Hylord::Simd
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef SIMD_KERNELS_H_
+#define SIMD_KERNELS_H_
+
+/**
+ * @file    Kernels.hpp
+ * @brief   Declares the kernel tables of each instruction set, along with
+ * helpers shared between them.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ *
+ * Variants for wider instruction sets are compiled with per-function target
+ * attributes rather than per-file compiler flags. With per-file flags, inline
+ * functions from shared headers could be emitted with (for example) AVX2
+ * instructions and then picked by the linker for every caller.
+ */
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "io/DecimalParsing.hpp"
+#include "simd/Dispatch.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HYLORD_SIMD_X86 1
+#define HYLORD_TARGET_SSE2 __attribute__((target("sse2")))
+#define HYLORD_TARGET_AVX2 __attribute__((target("avx2,fma,bmi")))
+#define HYLORD_TARGET_AVX512 \
+   __attribute__((target("avx512f,avx512bw,avx512vl,bmi,bmi2")))
+#endif
+
+namespace Hylord::Simd {
+auto genericKernels() -> const Kernels&;
+#ifdef HYLORD_SIMD_X86
+auto sse2Kernels() -> const Kernels&;
+auto avx2Kernels() -> const Kernels&;
+auto avx512Kernels() -> const Kernels&;
+#endif
+
+/// 10^i as integers, for combining integer and fractional digits.
+inline constexpr auto integer_powers_of_ten{[] {
+   std::array<std::uint64_t, IO::Decimal::max_exact_digits + 1> powers{};
+   std::uint64_t power{1};
+   for (auto& entry : powers) {
+      entry = power;
+      power *= 10;
+   }
+   return powers;
+}()};
+
+/// Value of `count` (0-15) ASCII digits, all of which may be read.
+inline auto digitsValue(const char* digits, int count) -> std::uint64_t {
+   using IO::Decimal::digitsToInteger;
+   using IO::Decimal::loadBytes;
+   constexpr int octet{8};
+   if (count == 0) return 0;
+   if (count <= octet) {
+      return digitsToInteger(loadBytes(digits, digits + count), count);
+   }
+   return digitsToInteger(loadBytes(digits, digits + octet), octet) *
+              IO::Decimal::digit_scales[static_cast<std::size_t>(count -
+                                                                 octet)] +
+          digitsToInteger(loadBytes(digits + octet, digits + count),
+                          count - octet);
+}
+
+/**
+ * Finishes parsing a fixed format decimal once the digits of a 16 byte window
+ * starting at `digits` are known (bit i of digit_mask is set if byte i is a
+ * digit). Gives the same value as IO::Decimal's scalar parser, as the
+ * mantissa is the same exact integer.
+ *
+ * @return Where the number ended, nullptr if it isn't a fixed format decimal
+ * or `fallback` if the number may continue past the window.
+ */
+inline auto finishFixedDecimal(const char* digits,
+                               const char* readable_end,
+                               std::uint32_t digit_mask,
+                               bool negative,
+                               double& value,
+                               const char* fallback) -> const char* {
+   constexpr int window{16};
+   constexpr std::uint32_t window_end{1U << window};
+   const int integer_digits{std::countr_zero(~digit_mask | window_end)};
+   if (integer_digits == window) return fallback;
+
+   const char* cursor{digits + integer_digits};
+   int fraction_digits{};
+   if (cursor < readable_end && *cursor == '.') {
+      const int fraction_start{integer_digits + 1};
+      fraction_digits = std::countr_zero(
+          (~digit_mask | window_end) >> static_cast<unsigned>(fraction_start));
+      if (fraction_start + fraction_digits >= window) return fallback;
+      cursor += 1 + fraction_digits;
+   }
+   const int total_digits{integer_digits + fraction_digits};
+   if (total_digits == 0 || total_digits > IO::Decimal::max_exact_digits) {
+      return nullptr;
+   }
+   if (cursor < readable_end && (*cursor == 'e' || *cursor == 'E')) {
+      return nullptr;
+   }
+
+   const std::uint64_t mantissa{
+       digitsValue(digits, integer_digits) *
+           integer_powers_of_ten[static_cast<std::size_t>(fraction_digits)] +
+       digitsValue(digits + integer_digits + 1, fraction_digits)};
+   const double magnitude{static_cast<double>(mantissa) /
+                          IO::Decimal::powers_of_ten[static_cast<std::size_t>(
+                              fraction_digits)]};
+   value = negative ? -magnitude : magnitude;
+   return cursor;
+}
+
+/**
+ * Loop shared by the Gram kernels: every pair of columns (and every
+ * column with the bulk profile) is combined with `dot`, the instruction set
+ * specific part.
+ */
+template <double (*dot)(const double*, const double*, std::ptrdiff_t)>
+void accumulateGramWith(const double* columns,
+                        std::ptrdiff_t stride,
+                        std::ptrdiff_t rows,
+                        std::ptrdiff_t cols,
+                        const double* bulk,
+                        double* gram,
+                        double* linear) {
+   for (std::ptrdiff_t i{}; i < cols; ++i) {
+      const double* column_i{columns + i * stride};
+      linear[i] += dot(column_i, bulk, rows);
+      for (std::ptrdiff_t j{i}; j < cols; ++j) {
+         gram[i + j * cols] += dot(column_i, columns + j * stride, rows);
+      }
+   }
+}
+}  // namespace Hylord::Simd
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * @file    KernelsAvx2.cpp
+ * @brief   Defines the AVX2 (with FMA) kernels.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "simd/Kernels.hpp"
+
+#ifdef HYLORD_SIMD_X86
+#include <immintrin.h>
+
+#include <bit>
+#include <cstddef>
+
+#include "simd/Dispatch.hpp"
+
+namespace Hylord::Simd {
+namespace {
+constexpr std::ptrdiff_t bytes_per_vector{32};
+constexpr std::ptrdiff_t doubles_per_vector{4};
+
+HYLORD_TARGET_AVX2
+auto delimiterMask(__m128i bytes) -> unsigned {
+   return static_cast<unsigned>(_mm_movemask_epi8(
+       _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')),
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')))));
+}
+
+/**
+ * Scans 32 bytes at a time, then 16 at a time before finishing byte by byte
+ * (fields are usually short, so most scans end within the first 16 bytes).
+ */
+HYLORD_TARGET_AVX2
+auto findDelimiter(const char* begin, const char* end) -> const char* {
+   constexpr std::ptrdiff_t half_vector{bytes_per_vector / 2};
+   if (end - begin >= half_vector) {
+      const unsigned matches{delimiterMask(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)))};
+      if (matches != 0) return begin + std::countr_zero(matches);
+      begin += half_vector;
+   }
+   const __m256i tabs{_mm256_set1_epi8('\t')};
+   const __m256i spaces{_mm256_set1_epi8(' ')};
+   while (end - begin >= bytes_per_vector) {
+      const __m256i bytes{
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin))};
+      const auto matches{static_cast<unsigned>(
+          _mm256_movemask_epi8(_mm256_or_si256(
+              _mm256_cmpeq_epi8(bytes, tabs),
+              _mm256_cmpeq_epi8(bytes, spaces))))};
+      if (matches != 0) return begin + std::countr_zero(matches);
+      begin += bytes_per_vector;
+   }
+   if (end - begin >= half_vector) {
+      const unsigned matches{delimiterMask(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)))};
+      if (matches != 0) return begin + std::countr_zero(matches);
+      begin += half_vector;
+   }
+   while (begin < end && *begin != '\t' && *begin != ' ') ++begin;
+   return begin;
+}
+
+HYLORD_TARGET_AVX2
+auto horizontalSum(__m256d values) -> double {
+   const __m128d halves{_mm_add_pd(_mm256_castpd256_pd128(values),
+                                   _mm256_extractf128_pd(values, 1))};
+   return _mm_cvtsd_f64(_mm_add_sd(halves, _mm_unpackhi_pd(halves, halves)));
+}
+
+HYLORD_TARGET_AVX2
+auto dot(const double* a, const double* b, std::ptrdiff_t size) -> double {
+   __m256d sum_even{_mm256_setzero_pd()};
+   __m256d sum_odd{_mm256_setzero_pd()};
+   std::ptrdiff_t i{};
+   for (; i + 2 * doubles_per_vector <= size; i += 2 * doubles_per_vector) {
+      sum_even = _mm256_fmadd_pd(
+          _mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), sum_even);
+      sum_odd = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + doubles_per_vector),
+                                _mm256_loadu_pd(b + i + doubles_per_vector),
+                                sum_odd);
+   }
+   double sum{horizontalSum(_mm256_add_pd(sum_even, sum_odd))};
+   for (; i < size; ++i) sum += a[i] * b[i];
+   return sum;
+}
+
+HYLORD_TARGET_AVX2
+auto residualSquaredNorm(const double* columns,
+                         std::ptrdiff_t stride,
+                         std::ptrdiff_t rows,
+                         std::ptrdiff_t cols,
+                         const double* proportions,
+                         const double* bulk) -> double {
+   __m256d sums{_mm256_setzero_pd()};
+   std::ptrdiff_t row{};
+   for (; row + doubles_per_vector <= rows; row += doubles_per_vector) {
+      __m256d residuals{_mm256_loadu_pd(bulk + row)};
+      for (std::ptrdiff_t col{}; col < cols; ++col) {
+         residuals =
+             _mm256_fnmadd_pd(_mm256_broadcast_sd(proportions + col),
+                              _mm256_loadu_pd(columns + row + col * stride),
+                              residuals);
+      }
+      sums = _mm256_fmadd_pd(residuals, residuals, sums);
+   }
+   double sum{horizontalSum(sums)};
+   for (; row < rows; ++row) {
+      double residual{bulk[row]};
+      for (std::ptrdiff_t col{}; col < cols; ++col) {
+         residual -= proportions[col] * columns[row + col * stride];
+      }
+      sum += residual * residual;
+   }
+   return sum;
+}
+}  // namespace
+
+/**
+ * Numbers are rarely longer than 16 characters, so the decimal parser gains
+ * nothing from wider vectors and the SSE2 variant is used.
+ */
+auto avx2Kernels() -> const Kernels& {
+   static const Kernels kernels{
+       .find_delimiter = findDelimiter,
+       .parse_fixed_decimal = sse2Kernels().parse_fixed_decimal,
+       .accumulate_gram = accumulateGramWith<dot>,
+       .residual_squared_norm = residualSquaredNorm};
+   return kernels;
+}
+}  // namespace Hylord::Simd
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @file    KernelsAvx512.cpp
+ * @brief   Defines the AVX-512 (F, BW and VL) kernels.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "simd/Kernels.hpp"
+
+#ifdef HYLORD_SIMD_X86
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "simd/Dispatch.hpp"
+
+namespace Hylord::Simd {
+namespace {
+constexpr std::ptrdiff_t doubles_per_vector{8};
+constexpr std::ptrdiff_t decimal_window{16};
+
+/**
+ * Like the SSE2 variant, but the window is loaded with a mask so numbers
+ * close to the end of readable memory don't need the scalar fallback.
+ */
+HYLORD_TARGET_AVX512
+auto parseFixedDecimal(const char* cursor,
+                       const char* readable_end,
+                       double& value) -> const char* {
+   const char* digits{cursor};
+   const bool negative{digits < readable_end && *digits == '-'};
+   if (negative) ++digits;
+   if (digits >= readable_end) return nullptr;
+
+   const auto available{static_cast<unsigned>(
+       std::min(readable_end - digits, decimal_window))};
+   const auto in_range{static_cast<__mmask16>(_bzhi_u32(0xFFFFU, available))};
+   const __m128i offsets{
+       _mm_sub_epi8(_mm_maskz_loadu_epi8(in_range, digits),
+                    _mm_set1_epi8('0'))};
+   const std::uint32_t digit_mask{
+       _mm_cmple_epu8_mask(offsets, _mm_set1_epi8(9))};
+
+   const char* end{finishFixedDecimal(
+       digits, readable_end, digit_mask, negative, value, cursor)};
+   if (end == cursor) {
+      return genericKernels().parse_fixed_decimal(
+          cursor, readable_end, value);
+   }
+   return end;
+}
+
+/// Mask of the doubles of a vector that are within range (bzhi only uses
+/// the low byte of its index, so the count is clamped first).
+HYLORD_TARGET_AVX512
+auto tailMask(std::ptrdiff_t remaining) -> __mmask8 {
+   return static_cast<__mmask8>(_bzhi_u32(
+       0xFFU,
+       static_cast<unsigned>(std::min(remaining, doubles_per_vector))));
+}
+
+HYLORD_TARGET_AVX512
+auto dot(const double* a, const double* b, std::ptrdiff_t size) -> double {
+   __m512d sum_even{_mm512_setzero_pd()};
+   __m512d sum_odd{_mm512_setzero_pd()};
+   std::ptrdiff_t i{};
+   for (; i + 2 * doubles_per_vector <= size; i += 2 * doubles_per_vector) {
+      sum_even = _mm512_fmadd_pd(
+          _mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), sum_even);
+      sum_odd = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + doubles_per_vector),
+                                _mm512_loadu_pd(b + i + doubles_per_vector),
+                                sum_odd);
+   }
+   for (; i < size; i += doubles_per_vector) {
+      const __mmask8 mask{tailMask(size - i)};
+      sum_even = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + i),
+                                 _mm512_maskz_loadu_pd(mask, b + i),
+                                 sum_even);
+   }
+   return _mm512_reduce_add_pd(_mm512_add_pd(sum_even, sum_odd));
+}
+
+HYLORD_TARGET_AVX512
+auto residualSquaredNorm(const double* columns,
+                         std::ptrdiff_t stride,
+                         std::ptrdiff_t rows,
+                         std::ptrdiff_t cols,
+                         const double* proportions,
+                         const double* bulk) -> double {
+   __m512d sums{_mm512_setzero_pd()};
+   for (std::ptrdiff_t row{}; row < rows; row += doubles_per_vector) {
+      const __mmask8 mask{tailMask(rows - row)};
+      __m512d residuals{_mm512_maskz_loadu_pd(mask, bulk + row)};
+      for (std::ptrdiff_t col{}; col < cols; ++col) {
+         residuals = _mm512_fnmadd_pd(
+             _mm512_set1_pd(proportions[col]),
+             _mm512_maskz_loadu_pd(mask, columns + row + col * stride),
+             residuals);
+      }
+      sums = _mm512_fmadd_pd(residuals, residuals, sums);
+   }
+   return _mm512_reduce_add_pd(sums);
+}
+}  // namespace
+
+auto avx512Kernels() -> const Kernels& {
+   static const Kernels kernels{
+       // Masked byte loads measured twice as slow as the AVX2 scan on the
+       // short fields of bedmethyl files, so that variant is reused
+       .find_delimiter = avx2Kernels().find_delimiter,
+       .parse_fixed_decimal = parseFixedDecimal,
+       .accumulate_gram = accumulateGramWith<dot>,
+       .residual_squared_norm = residualSquaredNorm};
+   return kernels;
+}
+}  // namespace Hylord::Simd
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file    KernelsGeneric.cpp
+ * @brief   Defines the portable (scalar) kernels.
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include <cstddef>
+
+#include "io/DecimalParsing.hpp"
+#include "simd/Dispatch.hpp"
+#include "simd/Kernels.hpp"
+
+namespace Hylord::Simd {
+namespace {
+auto findDelimiter(const char* begin, const char* end) -> const char* {
+   while (begin < end && *begin != '\t' && *begin != ' ') ++begin;
+   return begin;
+}
+
+auto parseFixedDecimal(const char* cursor,
+                       const char* readable_end,
+                       double& value) -> const char* {
+   const auto parsed{
+       IO::Decimal::parseFixedDecimalScalar(cursor, readable_end)};
+   if (!parsed) return nullptr;
+   value = parsed->value;
+   return parsed->end;
+}
+
+auto dot(const double* a, const double* b, std::ptrdiff_t size) -> double {
+   double sum{};
+   for (std::ptrdiff_t i{}; i < size; ++i) sum += a[i] * b[i];
+   return sum;
+}
+
+auto residualSquaredNorm(const double* columns,
+                         std::ptrdiff_t stride,
+                         std::ptrdiff_t rows,
+                         std::ptrdiff_t cols,
+                         const double* proportions,
+                         const double* bulk) -> double {
+   double sum{};
+   for (std::ptrdiff_t row{}; row < rows; ++row) {
+      double residual{bulk[row]};
+      for (std::ptrdiff_t col{}; col < cols; ++col) {
+         residual -= proportions[col] * columns[row + col * stride];
+      }
+      sum += residual * residual;
+   }
+   return sum;
+}
+}  // namespace
+
+auto genericKernels() -> const Kernels& {
+   static const Kernels kernels{
+       .find_delimiter = findDelimiter,
+       .parse_fixed_decimal = parseFixedDecimal,
+       .accumulate_gram = accumulateGramWith<dot>,
+       .residual_squared_norm = residualSquaredNorm};
+   return kernels;
+}
+}  // namespace Hylord::Simd
@@ -0,0 +1,136 @@
+/**
+ * @file    KernelsSse2.cpp
+ * @brief   Defines the SSE2 kernels (the baseline of x86-64).
+ * @copyright 2025 Sam Fletcher. Licensed under the MIT License. (See LICENSE
+ * file in the repository root or https://mit-license.org)
+ */
+
+#include "simd/Kernels.hpp"
+
+#ifdef HYLORD_SIMD_X86
+#include <emmintrin.h>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "simd/Dispatch.hpp"
+
+namespace Hylord::Simd {
+namespace {
+constexpr std::ptrdiff_t bytes_per_vector{16};
+constexpr std::ptrdiff_t doubles_per_vector{2};
+
+HYLORD_TARGET_SSE2
+auto findDelimiter(const char* begin, const char* end) -> const char* {
+   const __m128i tabs{_mm_set1_epi8('\t')};
+   const __m128i spaces{_mm_set1_epi8(' ')};
+   while (end - begin >= bytes_per_vector) {
+      const __m128i bytes{
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin))};
+      const int matches{_mm_movemask_epi8(_mm_or_si128(
+          _mm_cmpeq_epi8(bytes, tabs), _mm_cmpeq_epi8(bytes, spaces)))};
+      if (matches != 0) {
+         return begin + std::countr_zero(static_cast<unsigned>(matches));
+      }
+      begin += bytes_per_vector;
+   }
+   while (begin < end && *begin != '\t' && *begin != ' ') ++begin;
+   return begin;
+}
+
+/**
+ * Finds the digits of a 16 byte window at once. A byte is a digit if
+ * subtracting '0' leaves a value of at most 9 (unsigned).
+ */
+HYLORD_TARGET_SSE2
+auto parseFixedDecimal(const char* cursor,
+                       const char* readable_end,
+                       double& value) -> const char* {
+   const char* digits{cursor};
+   const bool negative{digits < readable_end && *digits == '-'};
+   if (negative) ++digits;
+   if (readable_end - digits < bytes_per_vector) {
+      return genericKernels().parse_fixed_decimal(
+          cursor, readable_end, value);
+   }
+
+   const __m128i offsets{_mm_sub_epi8(
+       _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits)),
+       _mm_set1_epi8('0'))};
+   const __m128i is_digit{_mm_cmpeq_epi8(
+       _mm_min_epu8(offsets, _mm_set1_epi8(9)), offsets)};
+   const auto digit_mask{
+       static_cast<std::uint32_t>(_mm_movemask_epi8(is_digit))};
+
+   const char* end{finishFixedDecimal(
+       digits, readable_end, digit_mask, negative, value, cursor)};
+   if (end == cursor) {
+      return genericKernels().parse_fixed_decimal(
+          cursor, readable_end, value);
+   }
+   return end;
+}
+
+HYLORD_TARGET_SSE2
+auto dot(const double* a, const double* b, std::ptrdiff_t size) -> double {
+   __m128d sum_even{_mm_setzero_pd()};
+   __m128d sum_odd{_mm_setzero_pd()};
+   std::ptrdiff_t i{};
+   for (; i + 2 * doubles_per_vector <= size; i += 2 * doubles_per_vector) {
+      sum_even = _mm_add_pd(
+          sum_even, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+      sum_odd = _mm_add_pd(
+          sum_odd,
+          _mm_mul_pd(_mm_loadu_pd(a + i + doubles_per_vector),
+                     _mm_loadu_pd(b + i + doubles_per_vector)));
+   }
+   const __m128d sums{_mm_add_pd(sum_even, sum_odd)};
+   double sum{_mm_cvtsd_f64(sums) +
+              _mm_cvtsd_f64(_mm_unpackhi_pd(sums, sums))};
+   for (; i < size; ++i) sum += a[i] * b[i];
+   return sum;
+}
+
+HYLORD_TARGET_SSE2
+auto residualSquaredNorm(const double* columns,
+                         std::ptrdiff_t stride,
+                         std::ptrdiff_t rows,
+                         std::ptrdiff_t cols,
+                         const double* proportions,
+                         const double* bulk) -> double {
+   __m128d sums{_mm_setzero_pd()};
+   std::ptrdiff_t row{};
+   for (; row + doubles_per_vector <= rows; row += doubles_per_vector) {
+      __m128d residuals{_mm_loadu_pd(bulk + row)};
+      for (std::ptrdiff_t col{}; col < cols; ++col) {
+         residuals = _mm_sub_pd(
+             residuals,
+             _mm_mul_pd(_mm_set1_pd(proportions[col]),
+                        _mm_loadu_pd(columns + row + col * stride)));
+      }
+      sums = _mm_add_pd(sums, _mm_mul_pd(residuals, residuals));
+   }
+   double sum{_mm_cvtsd_f64(sums) +
+              _mm_cvtsd_f64(_mm_unpackhi_pd(sums, sums))};
+   for (; row < rows; ++row) {
+      double residual{bulk[row]};
+      for (std::ptrdiff_t col{}; col < cols; ++col) {
+         residual -= proportions[col] * columns[row + col * stride];
+      }
+      sum += residual * residual;
+   }
+   return sum;
+}
+}  // namespace
+
+auto sse2Kernels() -> const Kernels& {
+   static const Kernels kernels{
+       .find_delimiter = findDelimiter,
+       .parse_fixed_decimal = parseFixedDecimal,
+       .accumulate_gram = accumulateGramWith<dot>,
+       .residual_squared_norm = residualSquaredNorm};
+   return kernels;
+}
+}  // namespace Hylord::Simd
+#endif
@@ -9,6 +9,7 @@
  */
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
@@ -18,6 +19,8 @@
 namespace Hylord {
 using RowIndex = std::ptrdiff_t;
 using RowIndexes = std::vector<RowIndex>;
+using GenomicKey = std::uint64_t;
+using GenomicKeys = std::vector<GenomicKey>;
 using Fields = std::vector<std::string>;
 using Vector = Eigen::VectorXd;
 using Matrix = Eigen::MatrixXd;
@@ -29,6 +32,12 @@ struct MapRange {
    const char* start;
    const char* end;
 };
+/// Inclusive range of packed genomic keys (see BedRecords::packKey)
+struct KeyRange {
+   GenomicKey first;
+   GenomicKey last;
+};
+using KeyRanges = std::vector<KeyRange>;
 }  // namespace IO
 
 namespace RNG {
@@ -0,0 +1,89 @@
+#include "io/BatchJournal.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "HylordException.hpp"
+
+namespace Hylord {
+class BatchJournalTest : public ::testing::Test {
+  protected:
+   void SetUp() override {
+      std::filesystem::remove_all(m_directory);
+      std::filesystem::create_directories(m_directory);
+   }
+   void TearDown() override { std::filesystem::remove_all(m_directory); }
+
+   static auto getTestPath(const std::string& file_name) -> std::string {
+      static std::string test_dir{TEST_DATA_DIR};
+      return test_dir + '/' + file_name;
+   }
+
+   std::filesystem::path m_directory{getTestPath("batch")};
+};
+
+TEST_F(BatchJournalTest, ReadsManifestRelativeToItsDirectory) {
+   const std::filesystem::path manifest{m_directory / "manifest.tsv"};
+   std::ofstream(manifest) << "# sample\tbedmethyl\n"
+                           << "first\tfirst.bed\n"
+                           << "\n"
+                           << "second\t/data/second.bed\n";
+   const std::vector<IO::BatchSample> samples{IO::readManifest(manifest)};
+   ASSERT_EQ(samples.size(), 2);
+   EXPECT_EQ(samples[0].name, "first");
+   EXPECT_EQ(samples[0].bedmethyl_file, m_directory / "first.bed");
+   EXPECT_EQ(samples[1].bedmethyl_file, "/data/second.bed");
+
+   std::ofstream(manifest) << "first\ta.bed\nfirst\tb.bed\n";
+   EXPECT_THROW(IO::readManifest(manifest), FileReadException);
+   std::ofstream(manifest) << "../first\ta.bed\n";
+   EXPECT_THROW(IO::readManifest(manifest), FileReadException);
+}
+
+TEST_F(BatchJournalTest, CompletesOnlyWithSameInputsAndIntactOutput) {
+   const std::filesystem::path journal_file{m_directory / "journal.tsv"};
+   const std::filesystem::path out_path{m_directory / "first.tsv"};
+   const std::string output{"cell_one\t60\ncell_two\t40\n"};
+   IO::commitFile(output, out_path);
+   EXPECT_FALSE(std::filesystem::exists(m_directory / "first.tsv.partial"));
+   {
+      IO::BatchJournal journal{journal_file};
+      EXPECT_FALSE(journal.isComplete("first", 7));
+      journal.record({"first", 7, IO::contentHash(output), out_path});
+   }
+
+   const IO::BatchJournal reopened{journal_file};
+   EXPECT_TRUE(reopened.isComplete("first", 7));
+   EXPECT_FALSE(reopened.isComplete("first", 8));
+   EXPECT_FALSE(reopened.isComplete("second", 7));
+
+   // A partly written output is rerun
+   std::ofstream(out_path) << "cell_one\t60\n";
+   EXPECT_FALSE(reopened.isComplete("first", 7));
+}
+
+TEST_F(BatchJournalTest, IgnoresLineCutShort) {
+   const std::filesystem::path journal_file{m_directory / "journal.tsv"};
+   const std::filesystem::path out_path{m_directory / "first.tsv"};
+   IO::commitFile("cell_one\t100\n", out_path);
+   const std::uint64_t hash{IO::fileHash(out_path)};
+   {
+      IO::BatchJournal journal{journal_file};
+      journal.record({"first", 1, hash, out_path});
+   }
+   std::ofstream(journal_file, std::ios::app) << "second\t2\t";
+
+   IO::BatchJournal journal{journal_file};
+   EXPECT_EQ(journal.entries().size(), 1);
+   journal.record({"third", 3, hash, out_path});
+
+   const IO::BatchJournal reopened{journal_file};
+   EXPECT_EQ(reopened.entries().size(), 2);
+   EXPECT_TRUE(reopened.isComplete("first", 1));
+   EXPECT_TRUE(reopened.isComplete("third", 3));
+}
+}  // namespace Hylord
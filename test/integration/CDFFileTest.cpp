@@ -0,0 +1,65 @@
+#include "io/CDFFile.hpp"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "HylordException.hpp"
+#include "io/ParseStatistics.hpp"
+#include "random/rng.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class CDFFileTest : public ::testing::Test {
+  protected:
+   static auto getTestPath(const std::string& file_name) -> std::string {
+      static std::string test_dir{TEST_DATA_DIR};
+      return test_dir + '/' + file_name;
+   }
+};
+
+TEST_F(CDFFileTest, FitsWritesAndReadsBackCDFs) {
+   IO::ParseStatistics statistics{};
+   // Half of the rows unmethylated, a quarter at 34% and a quarter at 96%
+   for (int i{}; i < 4; ++i) statistics.add('m', 20, 0.0);
+   for (int i{}; i < 2; ++i) statistics.add('m', 20, 0.34);
+   for (int i{}; i < 2; ++i) statistics.add('m', 20, 0.96);
+   statistics.add('h', 20, 0.02);
+
+   const RNG::CDF methylation{IO::fitCDF(statistics.marks()[0], 10)};
+   const RNG::CDF expected{0.5, 0.5, 0.5, 0.75, 0.75, 0.75, 0.75,
+                      0.75, 0.75, 0.75, 1.0};
+   EXPECT_EQ(methylation, expected);
+   EXPECT_EQ(IO::fitCDF(statistics.marks()[1], 2), (RNG::CDF{1.0, 1.0, 1.0}));
+
+   const std::string cdf_path{getTestPath("fitted_cdf.tsv")};
+   std::ofstream(cdf_path) << IO::formatCDFs(
+       {{'m', methylation}, {'h', IO::fitCDF(statistics.marks()[1], 2)}});
+   const RNG::CDFs cdfs{IO::readCDFs(cdf_path)};
+   EXPECT_EQ(cdfs.methylation, expected);
+   EXPECT_EQ(cdfs.hydroxymethylation, (RNG::CDF{1.0, 1.0, 1.0}));
+
+   // Marks missing from the file keep the built in CDF
+   std::ofstream(cdf_path) << IO::formatCDFs({{'m', methylation}});
+   EXPECT_EQ(IO::readCDFs(cdf_path).hydroxymethylation,
+             RNG::hydroxymethylation_cdf);
+}
+
+TEST_F(CDFFileTest, ThrowsOnMalformedCDFs) {
+   const std::string cdf_path{getTestPath("malformed_cdf.tsv")};
+   // Decreasing
+   std::ofstream(cdf_path) << "m\t0\t0.6\nm\t50\t0.4\nm\t100\t1\n";
+   EXPECT_THROW(IO::readCDFs(cdf_path), FileReadException);
+   // Unevenly spaced
+   std::ofstream(cdf_path) << "m\t0\t0.2\nm\t20\t0.4\nm\t100\t1\n";
+   EXPECT_THROW(IO::readCDFs(cdf_path), FileReadException);
+   // Not ending at 1
+   std::ofstream(cdf_path) << "h\t0\t0.2\nh\t100\t0.9\n";
+   EXPECT_THROW(IO::readCDFs(cdf_path), FileReadException);
+   // Unknown mark
+   std::ofstream(cdf_path) << "a\t0\t0.2\na\t100\t1\n";
+   EXPECT_THROW(IO::readCDFs(cdf_path), FileReadException);
+}
+}  // namespace Hylord
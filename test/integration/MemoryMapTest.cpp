@@ -0,0 +1,63 @@
+#include "io/MemoryMap.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "io/FileDescriptor.hpp"
+
+namespace Hylord {
+class MemoryMapTest : public ::testing::Test {
+  protected:
+   static auto getTestPath(const std::string& file_name) -> std::string {
+      static std::string test_dir{TEST_DATA_DIR};
+      return test_dir + '/' + file_name;
+   }
+
+   void SetUp() override {
+      // Several pages, so that discard() has whole pages to release
+      for (int line{}; line < 20'000; ++line) {
+         m_contents += "chr1\t" + std::to_string(line) + "\tm\t10\n";
+      }
+      std::ofstream(m_path, std::ios::binary) << m_contents;
+   }
+
+   /// Checks the view holds the file, and still does after discarding part
+   /// of it (discarded pages of a private mapping are read again).
+   void expectContents(const IO::MemoryMap& memory_map) const {
+      ASSERT_TRUE(memory_map.valid());
+      ASSERT_EQ(memory_map.size(), m_contents.size());
+      EXPECT_EQ(std::string_view(memory_map.data(), memory_map.size()),
+                m_contents);
+      memory_map.discard(memory_map.data(),
+                         memory_map.data() + (memory_map.size() / 2));
+      EXPECT_EQ(std::string_view(memory_map.data(), memory_map.size()),
+                m_contents);
+   }
+
+   std::string m_path{getTestPath("valid/memory_map.txt")};
+   std::string m_contents;
+};
+
+TEST_F(MemoryMapTest, ReadsSmallFiles) {
+   const IO::FileDescriptor file_descriptor{m_path};
+   expectContents(IO::MemoryMap{file_descriptor});
+}
+
+TEST_F(MemoryMapTest, MapsLargeFiles) {
+   const IO::FileDescriptor file_descriptor{m_path};
+   // Any file above the threshold is mapped
+   expectContents(IO::MemoryMap{file_descriptor, 0});
+}
+
+TEST_F(MemoryMapTest, BothPathsHoldTheSameContents) {
+   const IO::FileDescriptor file_descriptor{m_path};
+   const IO::MemoryMap read{file_descriptor};
+   const IO::MemoryMap mapped{file_descriptor, 0};
+   EXPECT_EQ(std::string_view(read.data(), read.size()),
+             std::string_view(mapped.data(), mapped.size()));
+}
+}  // namespace Hylord
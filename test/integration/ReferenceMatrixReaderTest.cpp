@@ -0,0 +1,196 @@
+#include "io/ReferenceMatrixReader.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "HylordException.hpp"
+#include "data/BedData.hpp"
+#include "data/BedRecords.hpp"
+#include "data/DataProcessing.hpp"
+#include "io/TrackWriter.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class ReferenceMatrixReaderTest : public ::testing::Test {
+  protected:
+   static auto getTestPath(const std::string& file_name) -> std::string {
+      static std::string test_dir{TEST_DATA_DIR};
+      return test_dir + '/' + file_name;
+   }
+};
+
+TEST_F(ReferenceMatrixReaderTest, ReadsValuesIntoMatrix) {
+   std::string data_path{getTestPath("valid/reference.bed")};
+   std::ofstream(data_path) << "chr1\t10\t11\th\t1.25\t100\t12\n"
+                            << "chr1\t10\t11\tm\t50\t25.5\t0\n"
+                            << "chr2\t5\t6\tm\t3\t4\t5\n";
+
+   IO::ReferenceMatrixReader reader{data_path, {}, 2};
+   reader.load();
+   EXPECT_TRUE(reader.isSorted());
+   std::vector<BedRecords::Bed4> records{reader.extractRecords()};
+   Matrix proportions{reader.extractProportions()};
+
+   ASSERT_EQ(records.size(), 3);
+   EXPECT_EQ(records[2].chromosome, 2);
+   EXPECT_EQ(records[0].name, 'h');
+   ASSERT_EQ(proportions.rows(), 3);
+   ASSERT_EQ(proportions.cols(), 3);
+   EXPECT_DOUBLE_EQ(proportions(1, 1), 0.255);
+   EXPECT_DOUBLE_EQ(proportions(0, 0), 0.0125);
+   EXPECT_DOUBLE_EQ(proportions(2, 2), 0.05);
+}
+
+TEST_F(ReferenceMatrixReaderTest, SkipsFilteredAndMalformedLines) {
+   std::string data_path{getTestPath("valid/filtered_reference.bed")};
+   {
+      std::ofstream reference_file(data_path);
+      for (int i{}; i < 100; ++i) {
+         reference_file << "chr1\t" << i << '\t' << i + 1 << "\tm\t" << i
+                        << "\t1\n"
+                        << "chr1\t" << i << '\t' << i + 1 << "\th\t2\t3\n";
+      }
+      reference_file << "chr1\t200\t201\tm\tnot_a_number\t1\n";
+   }
+
+   IO::ReferenceMatrixReader reader{
+       data_path,
+       [](const Fields& fields) -> bool { return fields[3] == "m"; },
+       4};
+   reader.load();
+   std::vector<BedRecords::Bed4> records{reader.extractRecords()};
+   Matrix proportions{reader.extractProportions()};
+
+   ASSERT_EQ(records.size(), 100);
+   ASSERT_EQ(proportions.rows(), 100);
+   for (int i{}; i < 100; ++i) {
+      EXPECT_EQ(records[i].start, i);
+      EXPECT_DOUBLE_EQ(proportions(i, 0), i / 100.0);
+   }
+}
+
+TEST_F(ReferenceMatrixReaderTest, LoadsOnlySelectedColumns) {
+   std::string data_path{getTestPath("valid/selected_reference.bed")};
+   // Unselected columns aren't converted, so can't cause warnings
+   std::ofstream(data_path) << "chr1\t10\t11\tm\t10\tx\t30\t40\n"
+                            << "chr1\t12\t13\tm\t50\tx\t70\t80\n";
+
+   IO::ReferenceMatrixReader reader{data_path};
+   reader.selectColumns({3, 0});
+   reader.load();
+   Matrix proportions{reader.extractProportions()};
+
+   ASSERT_EQ(proportions.rows(), 2);
+   ASSERT_EQ(proportions.cols(), 2);
+   EXPECT_DOUBLE_EQ(proportions(0, 0), 0.4);
+   EXPECT_DOUBLE_EQ(proportions(0, 1), 0.1);
+   EXPECT_DOUBLE_EQ(proportions(1, 0), 0.8);
+   EXPECT_DOUBLE_EQ(proportions(1, 1), 0.5);
+}
+
+TEST_F(ReferenceMatrixReaderTest, ThrowsOnInconsistentWidths) {
+   std::string data_path{getTestPath("valid/ragged_reference.bed")};
+   std::ofstream(data_path) << "chr1\t10\t11\tm\t50\t25\n"
+                            << "chr1\t12\t13\tm\t50\n";
+
+   IO::ReferenceMatrixReader reader{data_path};
+   EXPECT_THROW(reader.load(), FileReadException);
+}
+
+TEST_F(ReferenceMatrixReaderTest, ReadsBackWrittenMatrix) {
+   const std::filesystem::path data_path{
+       getTestPath("valid/written_reference.bed")};
+   std::filesystem::remove(data_path);
+   GenomicKeys keys{};
+   for (int i{}; i < 1000; ++i) {
+      keys.push_back(BedRecords::packKey(1 + (i / 100) * 3, i, 'm'));
+   }
+   Matrix proportions{Matrix::Random(1000, 3).cwiseAbs()};
+   proportions(0, 0) = 1.0;
+
+   const std::filesystem::path written{
+       IO::writeReferenceMatrix(data_path, keys, proportions, 3)};
+   IO::ReferenceMatrixReader reader{written, {}, 2};
+   reader.load();
+   std::vector<BedRecords::Bed4> records{reader.extractRecords()};
+   Matrix read_proportions{reader.extractProportions()};
+
+   ASSERT_EQ(records.size(), keys.size());
+   for (std::size_t i{}; i < keys.size(); ++i) {
+      EXPECT_EQ(records[i].key(), keys[i]);
+   }
+   EXPECT_EQ(records.back().chromosome, 28);
+   EXPECT_EQ(records[800].chromosome, 25);
+   // Written to two decimal places of a percentage
+   EXPECT_LE((read_proportions - proportions).cwiseAbs().maxCoeff(), 5e-5);
+   EXPECT_DOUBLE_EQ(read_proportions(0, 0), 1.0);
+}
+
+TEST_F(ReferenceMatrixReaderTest, JoinsBulkMatrixWithReference) {
+   const std::string reference_path{getTestPath("valid/join_reference.bed")};
+   const std::string bulk_path{getTestPath("valid/bulk_matrix.bed")};
+   std::ofstream(reference_path) << "chr1\t10\t11\tm\t10\t90\n"
+                                 << "chr1\t20\t21\tm\t20\t80\n"
+                                 << "chr2\t5\t6\tm\t30\t70\n";
+   // Unsorted, with a row the reference doesn't have
+   std::ofstream(bulk_path) << "chr2\t5\t6\tm\t50\t60\t70\n"
+                            << "chr1\t15\t16\tm\t1\t2\t3\n"
+                            << "chr1\t10\t11\tm\t10\t20\t30\n";
+
+   BedData::ReferenceMatrixData reference_matrix{
+       Processing::readReferenceMatrix(reference_path, 2)};
+   BedData::ReferenceMatrixData bulk_matrix{
+       Processing::readReferenceMatrix(bulk_path, 2)};
+   BedData::CpGData cpg_list{};
+   Processing::preprocessBulkMatrix(
+       bulk_matrix, reference_matrix, cpg_list, 2);
+
+   ASSERT_EQ(bulk_matrix.records().size(), 2);
+   ASSERT_EQ(reference_matrix.records().size(), 2);
+   for (std::size_t i{}; i < 2; ++i) {
+      EXPECT_EQ(bulk_matrix.records()[i].key(),
+                reference_matrix.records()[i].key());
+   }
+   const Matrix& bulk_profiles{bulk_matrix.getAsEigenMatrix()};
+   ASSERT_EQ(bulk_profiles.cols(), 3);
+   EXPECT_DOUBLE_EQ(bulk_profiles(0, 2), 0.3);
+   EXPECT_DOUBLE_EQ(bulk_profiles(1, 0), 0.5);
+   EXPECT_DOUBLE_EQ(reference_matrix.getAsEigenMatrix()(1, 0), 0.3);
+}
+
+TEST_F(ReferenceMatrixReaderTest, JoinsBedmethylWithEachPanel) {
+   const std::string first_path{getTestPath("valid/first_panel.bed")};
+   const std::string second_path{getTestPath("valid/second_panel.bed")};
+   std::ofstream(first_path) << "chr1\t10\t11\tm\t10\t90\n"
+                             << "chr1\t20\t21\tm\t20\t80\n";
+   std::ofstream(second_path) << "chr1\t20\t21\tm\t60\n"
+                              << "chr2\t5\t6\tm\t70\n";
+   const BedData::BedMethylData bedmethyl{
+       {{{.chromosome = 1, .start = 10, .name = 'm'}, 30, 0.1},
+        {{.chromosome = 1, .start = 20, .name = 'm'}, 30, 0.2},
+        {{.chromosome = 2, .start = 5, .name = 'm'}, 30, 0.3}}};
+   const BedData::CpGData cpg_list{};
+
+   BedData::ReferenceMatrixData first_panel{
+       Processing::readReferenceMatrix(first_path, 2)};
+   BedData::ReferenceMatrixData second_panel{
+       Processing::readReferenceMatrix(second_path, 2)};
+   const BedData::BedMethylData first_rows{
+       Processing::joinWithPanel(bedmethyl, first_panel, cpg_list, 2)};
+   const BedData::BedMethylData second_rows{
+       Processing::joinWithPanel(bedmethyl, second_panel, cpg_list, 2)};
+
+   // The bedmethyl data is shared between panels, so is left alone
+   EXPECT_EQ(bedmethyl.records().size(), 3);
+   ASSERT_EQ(first_rows.records().size(), 2);
+   ASSERT_EQ(second_rows.records().size(), 2);
+   EXPECT_EQ(first_rows.records()[1].key(), first_panel.records()[1].key());
+   EXPECT_EQ(second_rows.records()[0].start, 20);
+   EXPECT_DOUBLE_EQ(second_rows.getAsEigenVector()(1), 0.3);
+   EXPECT_DOUBLE_EQ(second_panel.getAsEigenMatrix()(1, 0), 0.7);
+}
+}  // namespace Hylord
@@ -0,0 +1,62 @@
+#include "io/ScratchMatrix.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <utility>
+
+#include "HylordException.hpp"
+#include "maths/LinearAlgebra.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class ScratchMatrixTest : public ::testing::Test {
+  protected:
+   static auto getTestPath(const std::string& file_name) -> std::string {
+      static std::string test_dir{TEST_DATA_DIR};
+      return test_dir + '/' + file_name;
+   }
+};
+
+TEST_F(ScratchMatrixTest, StartsZeroedAndLeavesNoFileBehind) {
+   const std::filesystem::path directory{getTestPath("scratch")};
+   std::filesystem::create_directories(directory);
+
+   IO::ScratchMatrix scratch{1000, 3, directory};
+   EXPECT_EQ(scratch.matrix().rows(), 1000);
+   EXPECT_EQ(scratch.matrix().cols(), 3);
+   EXPECT_EQ(scratch.matrix().cwiseAbs().maxCoeff(), 0.0);
+   scratch.matrix()(999, 2) = 0.5;
+
+   const IO::ScratchMatrix moved{std::move(scratch)};
+   EXPECT_TRUE(std::filesystem::is_empty(directory));
+}
+
+TEST_F(ScratchMatrixTest, ThrowsOnMissingDirectory) {
+   EXPECT_THROW(IO::ScratchMatrix(10, 2, getTestPath("no/such/directory")),
+                FileWriteException);
+}
+
+TEST_F(ScratchMatrixTest, ReferenceUpdateMatchesInMemoryMatrix) {
+   const Eigen::Index rows{777};
+   Matrix in_memory{Matrix::Constant(rows, 3, 0.25)};
+   in_memory.col(0).setLinSpaced(0.0, 1.0);
+   const Vector bulk{Vector::LinSpaced(rows, 0.9, 0.1)};
+   Vector proportions(3);
+   proportions << 0.5, 0.3, 0.2;
+
+   IO::ScratchMatrix scratch{rows, 4, getTestPath("")};
+   Eigen::Map<Matrix> columns{scratch.matrix()};
+   columns.leftCols(3) = in_memory;
+   columns.col(3) = bulk;
+
+   const auto expected{LinearAlgebra::updateReferenceMatrix(
+       in_memory, proportions, bulk, 2, 2)};
+   const auto update{LinearAlgebra::updateReferenceMatrix(
+       columns.leftCols(3), proportions, columns.col(3), 2, 2)};
+   EXPECT_EQ(Matrix{columns.leftCols(3)}, in_memory);
+   EXPECT_EQ(update.terms.hessian, expected.terms.hessian);
+   EXPECT_DOUBLE_EQ(update.objective, expected.objective);
+}
+}  // namespace Hylord
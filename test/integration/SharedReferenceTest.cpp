@@ -0,0 +1,120 @@
+#include "io/SharedReference.hpp"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+
+#include "data/BedData.hpp"
+#include "data/BedRecords.hpp"
+#include "data/DataProcessing.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class SharedReferenceTest : public ::testing::Test {
+  protected:
+   void SetUp() override {
+      m_name = "hylord_test_" + std::to_string(getpid());
+      IO::SharedReference::remove(m_name);
+      for (int i{}; i < 100; ++i) {
+         m_keys.push_back(BedRecords::packKey(1, i, 'm'));
+      }
+      m_proportions = Matrix::Random(100, 3).cwiseAbs();
+   }
+   void TearDown() override { IO::SharedReference::remove(m_name); }
+
+   static auto getTestPath(const std::string& file_name) -> std::string {
+      static std::string test_dir{TEST_DATA_DIR};
+      return test_dir + '/' + file_name;
+   }
+
+   std::string m_name;
+   GenomicKeys m_keys;
+   Matrix m_proportions;
+};
+
+TEST_F(SharedReferenceTest, AttachesToPublishedMatrix) {
+   EXPECT_EQ(IO::SharedReference::attach(m_name, 7), nullptr);
+   ASSERT_TRUE(IO::SharedReference::publish(m_name, 7, m_keys, m_proportions));
+   EXPECT_FALSE(
+       IO::SharedReference::publish(m_name, 7, m_keys, m_proportions));
+
+   auto shared{IO::SharedReference::attach(m_name, 7)};
+   ASSERT_NE(shared, nullptr);
+   ASSERT_EQ(shared->keys().size(), m_keys.size());
+   EXPECT_TRUE(
+       std::equal(m_keys.begin(), m_keys.end(), shared->keys().begin()));
+   EXPECT_EQ(shared->matrix(), m_proportions);
+
+   BedData::ReferenceMatrixData reference_matrix{std::move(shared)};
+   EXPECT_EQ(reference_matrix.numberOfCellTypes(), 3);
+   EXPECT_EQ(reference_matrix.records()[5].start, 5);
+   // Gathering rows leaves the shared matrix alone
+   const BedData::ReferenceMatrixData gathered{
+       reference_matrix.gatherRows({9, 4})};
+   EXPECT_EQ(gathered.records()[0].start, 9);
+   EXPECT_EQ(gathered.getAsEigenMatrix().row(1), m_proportions.row(4));
+   EXPECT_EQ(reference_matrix.records().size(), 100);
+   reference_matrix.subsetRows({4, 9});
+   EXPECT_EQ(reference_matrix.getAsEigenMatrix().row(1),
+             m_proportions.row(9));
+}
+
+TEST_F(SharedReferenceTest, IgnoresMatrixFromOtherInputs) {
+   ASSERT_TRUE(IO::SharedReference::publish(m_name, 7, m_keys, m_proportions));
+   EXPECT_EQ(IO::SharedReference::attach(m_name, 8), nullptr);
+}
+
+TEST_F(SharedReferenceTest, StopsWaitingForRemovedSegment) {
+   // A segment that is never sized, as left by a publisher that failed
+   const int file_descriptor{shm_open(
+       ('/' + m_name).c_str(), O_CREAT | O_EXCL | O_RDWR, 0644)};
+   ASSERT_NE(file_descriptor, -1);
+   close(file_descriptor);
+
+   auto attached{std::async(std::launch::async, [this] {
+      return IO::SharedReference::attach(m_name, 7);
+   })};
+   std::this_thread::sleep_for(std::chrono::milliseconds{200});
+   IO::SharedReference::remove(m_name);
+   ASSERT_EQ(attached.wait_for(std::chrono::seconds{10}),
+             std::future_status::ready);
+   EXPECT_EQ(attached.get(), nullptr);
+
+   // The name is free to be published again
+   EXPECT_TRUE(IO::SharedReference::publish(m_name, 7, m_keys, m_proportions));
+}
+
+TEST_F(SharedReferenceTest, ReadsSameMatrixAsParsing) {
+   const std::string data_path{getTestPath("valid/shared_reference.bed")};
+   std::ofstream(data_path) << "chr2\t5\t6\tm\t30\t70\n"
+                            << "chr1\t10\t11\tm\t10\t90\n"
+                            << "chr1\t20\t21\th\t20\t80\n";
+
+   // Parses and publishes, then attaches
+   BedData::ReferenceMatrixData parsed{Processing::readSharedReferenceMatrix(
+       m_name, data_path, 2, {}, nullptr, {}, "")};
+   BedData::ReferenceMatrixData attached{
+       Processing::readSharedReferenceMatrix(
+           m_name, data_path, 2, {}, nullptr, {}, "")};
+   ASSERT_EQ(attached.records().size(), 3);
+   for (std::size_t i{}; i < 3; ++i) {
+      EXPECT_EQ(attached.records()[i].key(), parsed.records()[i].key());
+   }
+   RowIndexes rows(3);
+   std::iota(rows.begin(), rows.end(), 0);
+   attached.subsetRows(rows);
+   EXPECT_EQ(attached.getAsEigenMatrix(), parsed.getAsEigenMatrix());
+   EXPECT_DOUBLE_EQ(attached.getAsEigenMatrix()(2, 0), 0.3);
+}
+}  // namespace Hylord
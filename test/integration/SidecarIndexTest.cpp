@@ -0,0 +1,85 @@
+#include "io/SidecarIndex.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "data/BedRecords.hpp"
+#include "io/TSVFileReader.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class SidecarIndexTest : public ::testing::Test {
+  protected:
+   static auto getTestPath(const std::string& file_name) -> std::string {
+      static std::string test_dir{TEST_DATA_DIR};
+      return test_dir + '/' + file_name;
+   }
+   static void writeBedFile(const std::string& path, int rows_per_contig) {
+      std::ofstream bed_file(path);
+      for (int chromosome : {1, 2, 3}) {
+         for (int i{}; i < rows_per_contig; ++i) {
+            bed_file << "chr" << chromosome << '\t' << i * 10 << '\t'
+                     << i * 10 + 1 << "\tm\n";
+         }
+      }
+   }
+   static auto rangeOf(int chromosome, int first, int last) -> IO::KeyRange {
+      return {.first = BedRecords::packKey(chromosome, first, 'm'),
+              .last = BedRecords::packKey(chromosome, last, 'm')};
+   }
+};
+
+TEST_F(SidecarIndexTest, RoundTripsThroughSidecarFile) {
+   std::string data_path{getTestPath("valid/indexed.bed")};
+   writeBedFile(data_path, 100);
+
+   const IO::SidecarIndex index{IO::SidecarIndex::build(data_path, 16)};
+   index.write(data_path);
+   EXPECT_TRUE(std::filesystem::exists(IO::SidecarIndex::sidecarPath(
+       data_path)));
+   EXPECT_TRUE(index.isSorted());
+
+   IO::TSVFileReader<BedRecords::Bed4> reader{data_path, {}, {}, 4};
+   EXPECT_TRUE(reader.hasSidecarIndex());
+   reader.load();
+   EXPECT_EQ(reader.extractRecords().size(), 300);
+}
+
+TEST_F(SidecarIndexTest, IgnoresOutdatedIndex) {
+   std::string data_path{getTestPath("valid/outdated.bed")};
+   writeBedFile(data_path, 100);
+   IO::SidecarIndex::build(data_path, 16).write(data_path);
+
+   // Changes the size of the file, so the index no longer describes it
+   writeBedFile(data_path, 50);
+   IO::TSVFileReader<BedRecords::Bed4> reader{data_path, {}, {}, 4};
+   EXPECT_FALSE(reader.hasSidecarIndex());
+   reader.load();
+   EXPECT_EQ(reader.extractRecords().size(), 150);
+}
+
+TEST_F(SidecarIndexTest, OnlyReadsRequestedKeyRanges) {
+   std::string data_path{getTestPath("valid/seekable.bed")};
+   writeBedFile(data_path, 1000);
+   IO::SidecarIndex::build(data_path, 16).write(data_path);
+
+   IO::TSVFileReader<BedRecords::Bed4> reader{data_path, {}, {}, 2};
+   reader.limitToKeyRanges({rangeOf(2, 100, 200)});
+   reader.load();
+   std::vector<BedRecords::Bed4> rows{reader.extractRecords()};
+
+   // Reads whole strides around the range, but nothing from other contigs
+   ASSERT_FALSE(rows.empty());
+   EXPECT_LT(rows.size(), 1000);
+   for (const auto& row : rows) EXPECT_EQ(row.chromosome, 2);
+   int rows_in_range{};
+   for (const auto& row : rows) {
+      if (row.start >= 100 && row.start <= 200) ++rows_in_range;
+   }
+   EXPECT_EQ(rows_in_range, 11);
+}
+}  // namespace Hylord
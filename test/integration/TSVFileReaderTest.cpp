@@ -5,11 +5,15 @@
 #include <fstream>
 #include <iostream>
 #include <ratio>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "HylordException.hpp"
+#include "data/BedRecords.hpp"
+#include "data/DataProcessing.hpp"
 #include "io/TSVFileReader.hpp"
 #include "types.hpp"
 
@@ -125,6 +129,129 @@ TEST_F(TSVReaderIntegrationTest, SkipsMalformedLines) {
    EXPECT_EQ(rows[1].num2, 4);
 }
 
+TEST_F(TSVReaderIntegrationTest, DetectsUnsortedFiles) {
+   std::string sorted_path{getTestPath("valid/sorted.bed")};
+   std::string unsorted_path{getTestPath("valid/unsorted.bed")};
+   {
+      std::ofstream sorted_file(sorted_path);
+      std::ofstream unsorted_file(unsorted_path);
+      // Each half is sorted, so this can only be caught at chunk boundaries
+      for (int chromosome : {1, 2}) {
+         for (int i{}; i < 100; ++i) {
+            sorted_file << "chr" << chromosome << '\t' << i << '\t' << i + 1
+                        << "\tm\n";
+         }
+      }
+      for (int chromosome : {2, 1}) {
+         for (int i{}; i < 100; ++i) {
+            unsorted_file << "chr" << chromosome << '\t' << i << '\t'
+                          << i + 1 << "\tm\n";
+         }
+      }
+   }
+
+   IO::TSVFileReader<BedRecords::Bed4> sorted_reader{sorted_path, {}, {}, 2};
+   sorted_reader.load();
+   EXPECT_TRUE(sorted_reader.isSorted());
+
+   IO::TSVFileReader<BedRecords::Bed4> unsorted_reader{
+       unsorted_path, {}, {}, 2};
+   unsorted_reader.load();
+   EXPECT_FALSE(unsorted_reader.isSorted());
+}
+
+TEST_F(TSVReaderIntegrationTest, MergesBedGraphsByKey) {
+   const std::string methylation_path{getTestPath("valid/sample_m.bedgraph")};
+   const std::string hydroxy_path{getTestPath("valid/sample_h.bedgraph")};
+   std::ofstream(methylation_path) << "chr1\t10\t11\t0.8\t30\n"
+                                   << "chr1\t20\t21\t0.6\t5\n"
+                                   << "chr2\t5\t6\t0.4\t25\n";
+   std::ofstream(hydroxy_path) << "chr1\t10\t11\t0.1\t30\n"
+                               << "chr2\t5\t6\t0.05\t25\n";
+
+   const BedData::BedMethylData merged{Processing::readBedGraphs(
+       {{'m', methylation_path}, {'h', hydroxy_path}},
+       2,
+       [](const Fields& fields) { return std::stoi(fields[4]) > 10; })};
+   ASSERT_EQ(merged.records().size(), 4);
+   EXPECT_TRUE(merged.isSorted());
+   const std::vector<std::pair<int, char>> expected{
+       {10, 'h'}, {10, 'm'}, {5, 'h'}, {5, 'm'}};
+   for (std::size_t i{}; i < expected.size(); ++i) {
+      EXPECT_EQ(merged.records()[i].start, expected[i].first);
+      EXPECT_EQ(merged.records()[i].name, expected[i].second);
+   }
+   EXPECT_DOUBLE_EQ(merged.records()[0].methylation_proportion, 0.1);
+   EXPECT_EQ(merged.records()[3].read_depth, 25);
+}
+
+TEST_F(TSVReaderIntegrationTest, CollectsStatisticsOfEveryParsedRow) {
+   const std::string data_path{getTestPath("valid/statistics.bed")};
+   {
+      std::ofstream data_file(data_path);
+      // Depths 1 to 100 (fraction modified 25%) for m, depth 2000 for h
+      for (int i{1}; i <= 100; ++i) {
+         data_file << "chr1\t" << i << '\t' << i + 1 << "\tm\t" << i
+                   << "\t+\t0\t0\t0\t" << i << "\t25.0\t0\t0\t0\t0\t0\t0"
+                   << "\t0\n";
+      }
+      data_file << "chr2\t1\t2\th\t2000\t+\t0\t0\t0\t2000\t80.0\t0\t0\t0"
+                << "\t0\t0\t0\t0\n";
+   }
+
+   IO::TSVFileReader<BedRecords::Bed9Plus9> reader{
+       data_path,
+       {0, 1, 2, 3, 4, 10},
+       [](const Fields& fields) { return std::stoi(fields[4]) >= 50; },
+       3};
+   reader.collectStatistics();
+   reader.load();
+   EXPECT_EQ(reader.extractRecords().size(), 52);
+
+   // Rows dropped by the row filter are still counted
+   const IO::ParseStatistics& statistics{reader.statistics()};
+   ASSERT_EQ(statistics.marks().size(), 2);
+   const IO::MarkHistograms& methylation{statistics.marks()[0].mark == 'm'
+                                             ? statistics.marks()[0]
+                                             : statistics.marks()[1]};
+   EXPECT_EQ(methylation.rows, 100);
+   EXPECT_EQ(methylation.proportion[25], 100);
+   EXPECT_EQ(statistics.depthQuantile('m', 0.5), 50);
+   EXPECT_EQ(statistics.depthQuantile('m', 0.99), 99);
+   EXPECT_EQ(statistics.depthQuantile('h', 0.5),
+             IO::ParseStatistics::max_depth);
+
+   std::ostringstream report;
+   statistics.write(report);
+   EXPECT_NE(report.str().find("\nh\t1\t2000\t1000\t1000\t1000\t80\n"),
+             std::string::npos);
+   EXPECT_NE(report.str().find("\ndepth\th\t1000+\t1\n"), std::string::npos);
+}
+
+TEST_F(TSVReaderIntegrationTest, StreamsFileInBatches) {
+   std::string data_path{getTestPath("valid/streamed.tsv")};
+   {
+      std::ofstream data_file(data_path);
+      for (int i{}; i < 1000; ++i) data_file << i << '\t' << 2 * i << '\n';
+   }
+
+   IO::TSVFileReader<TwoNumbers> reader{data_path, {}, {}, 3};
+   std::vector<TwoNumbers> rows{};
+   int batches{};
+   // Small batches, so lines are regularly cut by the batch boundary
+   reader.stream(500, [&](std::vector<TwoNumbers>&& batch) {
+      ++batches;
+      rows.insert(rows.end(), batch.begin(), batch.end());
+   });
+
+   EXPECT_GT(batches, 1);
+   ASSERT_EQ(rows.size(), 1000);
+   for (int i{}; i < 1000; ++i) {
+      EXPECT_EQ(rows[i].num1, i);
+      EXPECT_EQ(rows[i].num2, 2 * i);
+   }
+}
+
 TEST_F(TSVReaderIntegrationTest, PerformanceCheck) {
    std::string data_path{getTestPath("valid/long_file.tsv")};
    constexpr int n_rows{250000};
@@ -0,0 +1,80 @@
+#include "io/TrackWriter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "data/BedRecords.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class TrackWriterTest : public ::testing::Test {
+  protected:
+   static auto getTestPath(const std::string& file_name) -> std::string {
+      static std::string test_dir{TEST_DATA_DIR};
+      return test_dir + '/' + file_name;
+   }
+
+   static auto readFile(const std::filesystem::path& path) -> std::string {
+      std::ifstream file(path);
+      std::stringstream contents;
+      contents << file.rdbuf();
+      return contents.str();
+   }
+};
+
+TEST_F(TrackWriterTest, WritesBulkFittedAndResiduals) {
+   const std::filesystem::path data_path{getTestPath("residuals.bed")};
+   std::filesystem::remove(data_path);
+   const GenomicKeys keys{BedRecords::packKey(1, 10, 'm'),
+                          BedRecords::packKey(23, 5, 'h')};
+   Matrix reference_matrix(2, 2);
+   reference_matrix << 0.5, 1.0, 0.0, 0.2;
+   Vector cell_proportions(2);
+   cell_proportions << 0.75, 0.25;
+   Vector bulk_profile(2);
+   bulk_profile << 0.7, 0.05;
+
+   const std::filesystem::path written{IO::writeResidualTrack(
+       data_path, keys, reference_matrix, cell_proportions, bulk_profile, 2)};
+   EXPECT_EQ(readFile(written),
+             "chr1\t10\t11\tm\t70.00\t62.50\t7.50\n"
+             "chrX\t5\t6\th\t5.00\t5.00\t0.00\n");
+}
+
+TEST_F(TrackWriterTest, OutputDoesNotDependOnThreads) {
+   // More rows than one batch of four blocks, so batches are written in turn
+   const Eigen::Index rows{70000};
+   GenomicKeys keys{};
+   for (Eigen::Index i{}; i < rows; ++i) {
+      keys.push_back(
+          BedRecords::packKey(1 + static_cast<int>(i / 5000), i, 'm'));
+   }
+   const Matrix reference_matrix{Matrix::Random(rows, 3).cwiseAbs()};
+   const Vector cell_proportions{Vector::Constant(3, 1.0 / 3.0)};
+   const Vector bulk_profile{Vector::LinSpaced(rows, 0.0, 1.0)};
+
+   const std::filesystem::path serial_path{getTestPath("serial.bed")};
+   const std::filesystem::path parallel_path{getTestPath("parallel.bed")};
+   std::filesystem::remove(serial_path);
+   std::filesystem::remove(parallel_path);
+   const std::string serial{readFile(IO::writeResidualTrack(serial_path,
+                                                            keys,
+                                                            reference_matrix,
+                                                            cell_proportions,
+                                                            bulk_profile,
+                                                            1))};
+   const std::string parallel{readFile(IO::writeResidualTrack(parallel_path,
+                                                              keys,
+                                                              reference_matrix,
+                                                              cell_proportions,
+                                                              bulk_profile,
+                                                              4))};
+   EXPECT_EQ(serial, parallel);
+   EXPECT_EQ(std::ranges::count(serial, '\n'), rows);
+}
+}  // namespace Hylord
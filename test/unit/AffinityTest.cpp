@@ -0,0 +1,71 @@
+#include "parallel/Affinity.hpp"
+
+#include <gtest/gtest.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "parallel/ParallelFor.hpp"
+
+namespace Hylord {
+TEST(AffinityTest, AvailableCoresWithinHardware) {
+   const int cores{Parallel::availableCores()};
+   EXPECT_GE(cores, 1);
+   const auto hardware_threads{
+       static_cast<int>(std::thread::hardware_concurrency())};
+   EXPECT_LE(cores, std::max(1, hardware_threads));
+}
+
+TEST(AffinityTest, PinsBlocksToAllowedCpus) {
+   cpu_set_t original;
+   ASSERT_EQ(sched_getaffinity(0, sizeof(original), &original), 0);
+
+   Parallel::enableThreadPinning(true);
+   std::vector<int> cpus(4, -1);
+   Parallel::forEachBlock(4, 4, [&](const Parallel::Block& block) {
+      cpus[block.index] = sched_getcpu();
+   });
+   Parallel::enableThreadPinning(false);
+
+   for (const int cpu : cpus) {
+      ASSERT_GE(cpu, 0);
+      EXPECT_TRUE(CPU_ISSET(cpu, &original));
+   }
+   // Blocks wrap around the allowed CPUs in order
+   if (CPU_COUNT(&original) >= 2) {
+      EXPECT_NE(cpus[0], cpus[1]);
+   }
+}
+
+TEST(AffinityTest, RestoresCallersMask) {
+   cpu_set_t original;
+   ASSERT_EQ(sched_getaffinity(0, sizeof(original), &original), 0);
+
+   Parallel::enableThreadPinning(true);
+   Parallel::forEachBlock(4, 4, [](const Parallel::Block&) {});
+   cpu_set_t after;
+   ASSERT_EQ(sched_getaffinity(0, sizeof(after), &after), 0);
+   const std::size_t core_after{Parallel::currentCore()};
+   Parallel::enableThreadPinning(false);
+
+   EXPECT_TRUE(CPU_EQUAL(&original, &after));
+   EXPECT_EQ(core_after, 0);
+}
+
+TEST(AffinityTest, OffsetsNestedBlocks) {
+   Parallel::enableThreadPinning(true);
+   std::vector<std::size_t> cores(6);
+   Parallel::forEachBlock(2, 2, [&](const Parallel::Block& outer) {
+      Parallel::forEachBlock(3, 3, [&](const Parallel::Block& inner) {
+         cores[(outer.index * 3) + inner.index] = Parallel::currentCore();
+      });
+   });
+   Parallel::enableThreadPinning(false);
+
+   // Inner blocks of different outer blocks never share a CPU index
+   EXPECT_EQ(cores, (std::vector<std::size_t>{0, 1, 2, 3, 4, 5}));
+}
+}  // namespace Hylord
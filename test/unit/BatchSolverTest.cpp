@@ -0,0 +1,61 @@
+#include "core/BatchSolver.hpp"
+
+#include <gtest/gtest.h>
+
+#include "HylordException.hpp"
+#include "core/Deconvolver.hpp"
+#include "maths/LinearAlgebra.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class BatchSolverTest : public ::testing::Test {
+  protected:
+   void SetUp() override {
+      m_reference_matrix = Matrix::Random(500, 4).cwiseAbs();
+      Matrix proportions{Matrix::Random(4, 7).cwiseAbs()};
+      proportions.array().rowwise() /= proportions.colwise().sum().array();
+      m_bulk_profiles = m_reference_matrix * proportions +
+                        0.01 * Matrix::Random(500, 7);
+   }
+
+   Matrix m_reference_matrix;
+   Matrix m_bulk_profiles;
+};
+
+TEST_F(BatchSolverTest, TermsMatchSingleProfileTerms) {
+   const LinearAlgebra::BatchQuadraticTerms terms{
+       LinearAlgebra::batchQuadraticTerms(
+           m_reference_matrix, m_bulk_profiles, 3)};
+   for (Eigen::Index profile{}; profile < m_bulk_profiles.cols(); ++profile) {
+      const LinearAlgebra::QuadraticTerms expected{
+          LinearAlgebra::quadraticTerms(m_reference_matrix,
+                                        m_bulk_profiles.col(profile))};
+      EXPECT_TRUE(terms.hessian.isApprox(expected.hessian, 1e-12));
+      EXPECT_TRUE(terms.linear_terms.col(profile).isApprox(
+          expected.linear_terms, 1e-12));
+   }
+}
+
+TEST_F(BatchSolverTest, MatchesSeparateDeconvolutions) {
+   const Deconvolution::BatchResult result{
+       Deconvolution::solveBatch(m_reference_matrix, m_bulk_profiles, 3)};
+   ASSERT_EQ(result.cell_proportions.cols(), m_bulk_profiles.cols());
+
+   for (Eigen::Index profile{}; profile < m_bulk_profiles.cols(); ++profile) {
+      Deconvolution::Deconvolver deconvolver{4, m_bulk_profiles.col(profile)};
+      deconvolver.runQpmad(m_reference_matrix);
+      EXPECT_TRUE(result.cell_proportions.col(profile).isApprox(
+          deconvolver.cellProportions(), 1e-6));
+      EXPECT_NEAR(
+          result.objectives(profile),
+          deconvolver.evaluateObjectiveFunctionL2Norm(m_reference_matrix),
+          1e-6);
+   }
+}
+
+TEST_F(BatchSolverTest, ThrowsOnMismatchedRows) {
+   EXPECT_THROW(Deconvolution::solveBatch(
+                    m_reference_matrix, m_bulk_profiles.topRows(10), 1),
+                DeconvolutionException);
+}
+}  // namespace Hylord
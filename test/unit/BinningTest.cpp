@@ -0,0 +1,105 @@
+#include "data/Binning.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "HylordException.hpp"
+#include "data/BedRecords.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class BinningTest : public ::testing::Test {
+  protected:
+   static auto createRow(int chromosome,
+                         int start,
+                         char name,
+                         int read_depth,
+                         double methylation_proportion)
+       -> BedRecords::Bed9Plus9 {
+      BedRecords::Bed9Plus9 row{};
+      row.chromosome = chromosome;
+      row.start = start;
+      row.name = name;
+      row.read_depth = read_depth;
+      row.methylation_proportion = methylation_proportion;
+      return row;
+   }
+
+   void SetUp() override {
+      m_rows = {createRow(1, 10, 'h', 1, 0.0),
+                createRow(1, 10, 'm', 1, 1.0),
+                createRow(1, 50, 'm', 3, 0.0),
+                createRow(1, 150, 'm', 0, 0.2),
+                createRow(1, 160, 'm', 0, 0.4),
+                createRow(2, 10, 'm', 2, 0.5)};
+      m_reference_matrix.resize(6, 2);
+      m_reference_matrix << 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0,
+          0.0, 0.1;
+   }
+
+   std::vector<BedRecords::Bed9Plus9> m_rows;
+   Matrix m_reference_matrix;
+};
+
+TEST_F(BinningTest, PoolsFixedBinsBySignal) {
+   const Binning::BinnedRows binned{Binning::pool(
+       m_rows, m_reference_matrix, Binning::fixedBins(m_rows, 100), 2)};
+
+   // (chr1 0-100 h), (chr1 0-100 m), (chr1 100-200 m), (chr2 0-100 m)
+   ASSERT_EQ(binned.bulk_profile.size(), 4);
+   ASSERT_EQ(binned.reference_matrix.rows(), 4);
+   EXPECT_DOUBLE_EQ(binned.bulk_profile(0), 0.0);
+   // Weighted by read depth
+   EXPECT_DOUBLE_EQ(binned.bulk_profile(1), 0.25);
+   // No read depth, so the plain mean
+   EXPECT_DOUBLE_EQ(binned.bulk_profile(2), 0.3);
+   EXPECT_DOUBLE_EQ(binned.bulk_profile(3), 0.5);
+   EXPECT_DOUBLE_EQ(binned.reference_matrix(0, 0), 0.1);
+   EXPECT_DOUBLE_EQ(binned.reference_matrix(1, 0), 0.4);
+   EXPECT_DOUBLE_EQ(binned.reference_matrix(2, 1), 0.9);
+   EXPECT_DOUBLE_EQ(binned.reference_matrix(3, 1), 0.1);
+}
+
+TEST_F(BinningTest, DropsRowsOutsideOfRegions) {
+   const std::vector<BedRecords::Region> regions{
+       {{.chromosome = 1, .start = 40}, 151},
+       {{.chromosome = 2, .start = 0}, 11}};
+   const Binning::BinIndexes bins{Binning::regionBins(m_rows, regions)};
+   EXPECT_EQ(bins,
+             (Binning::BinIndexes{
+                 Binning::no_bin, Binning::no_bin, 0, 0, Binning::no_bin, 1}));
+
+   const Binning::BinnedRows binned{
+       Binning::pool(m_rows, m_reference_matrix, bins, 1)};
+   ASSERT_EQ(binned.bulk_profile.size(), 2);
+   EXPECT_DOUBLE_EQ(binned.bulk_profile(0), 0.0);
+   EXPECT_DOUBLE_EQ(binned.reference_matrix(0, 0), 0.6);
+}
+
+TEST_F(BinningTest, DrawsNovelProfilesForEachBin) {
+   Binning::BinnedRows binned{Binning::pool(
+       m_rows, m_reference_matrix, Binning::fixedBins(m_rows, 100), 1)};
+   ASSERT_EQ(binned.rows.size(), 4);
+   EXPECT_EQ(binned.rows[0].name, 'h');
+   EXPECT_EQ(binned.rows[2].start, 150);
+
+   Binning::addMoreCellTypes(binned, 50);
+   ASSERT_EQ(binned.reference_matrix.cols(), 52);
+   EXPECT_DOUBLE_EQ(binned.reference_matrix(1, 0), 0.4);
+   // Single draws sit on the levels of the CDF (multiples of 0.1), averages
+   // of several draws generally don't
+   const Matrix novel{binned.reference_matrix.rightCols(50)};
+   for (const double value : novel.reshaped()) {
+      EXPECT_NEAR(value * 10, std::round(value * 10), 1e-9);
+   }
+   EXPECT_GT(novel.row(1).maxCoeff() - novel.row(1).minCoeff(), 0.2);
+}
+
+TEST_F(BinningTest, ThrowsWhenNothingIsBinned) {
+   const Binning::BinIndexes bins(m_rows.size(), Binning::no_bin);
+   EXPECT_THROW(Binning::pool(m_rows, m_reference_matrix, bins, 1),
+                PreprocessingException);
+}
+}  // namespace Hylord
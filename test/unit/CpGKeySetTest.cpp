@@ -0,0 +1,119 @@
+#include "data/CpGKeySet.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "data/BedRecords.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class CpGKeySetTest : public ::testing::Test {
+  protected:
+   /// Sorted, unique keys spread over a few chromosomes (with both marks
+   /// at some sites, one at others).
+   static auto randomKeys(std::size_t sites) -> GenomicKeys {
+      std::mt19937 generator{7};
+      std::uniform_int_distribution<int> chromosome{1, 4};
+      std::uniform_int_distribution<int> start{0, 5'000'000};
+      std::uniform_int_distribution<int> marks{0, 2};
+      GenomicKeys keys{};
+      for (std::size_t site{}; site < sites; ++site) {
+         const int site_chromosome{chromosome(generator)};
+         const int site_start{start(generator)};
+         const int site_marks{marks(generator)};
+         if (site_marks != 1) {
+            keys.push_back(
+                BedRecords::packKey(site_chromosome, site_start, 'm'));
+         }
+         if (site_marks != 0) {
+            keys.push_back(
+                BedRecords::packKey(site_chromosome, site_start, 'h'));
+         }
+      }
+      std::ranges::sort(keys);
+      const auto duplicates{std::ranges::unique(keys)};
+      keys.erase(duplicates.begin(), duplicates.end());
+      return keys;
+   }
+};
+
+TEST_F(CpGKeySetTest, HoldsExactlyTheKeysGiven) {
+   const GenomicKeys keys{randomKeys(10'000)};
+   const BedData::CpGKeySet set{keys};
+   EXPECT_EQ(set.size(), keys.size());
+   EXPECT_EQ(set.keys(), keys);
+
+   for (const GenomicKey key : keys) {
+      ASSERT_TRUE(set.contains(key));
+      // Neighbouring sites and the other mark aren't necessarily present
+      for (const GenomicKey near :
+           {key + (GenomicKey{1} << BedRecords::KeyLayout::start_shift),
+            key - (GenomicKey{1} << BedRecords::KeyLayout::start_shift),
+            key ^ ('m' ^ 'h')}) {
+         EXPECT_EQ(set.contains(near), std::ranges::binary_search(keys, near));
+      }
+   }
+}
+
+TEST_F(CpGKeySetTest, CursorMatchesMembership) {
+   const GenomicKeys keys{randomKeys(5'000)};
+   const BedData::CpGKeySet set{keys};
+
+   // Every other key of the set mixed with keys that aren't in it
+   GenomicKeys queries{};
+   for (std::size_t i{}; i < keys.size(); i += 2) {
+      queries.push_back(keys[i]);
+      queries.push_back(keys[i] +
+                        (GenomicKey{3} << BedRecords::KeyLayout::start_shift));
+   }
+   std::ranges::sort(queries);
+   BedData::CpGKeySet::Cursor cursor{set.cursor()};
+   for (const GenomicKey query : queries) {
+      EXPECT_EQ(cursor.contains(query), set.contains(query));
+   }
+   // Past the end
+   EXPECT_FALSE(cursor.contains(BedRecords::packKey(30, 0, 'm')));
+}
+
+TEST_F(CpGKeySetTest, SortsKeysAddedOutOfOrder) {
+   const GenomicKeys keys{randomKeys(1'000)};
+   GenomicKeys shuffled{keys};
+   shuffled.insert(shuffled.end(), keys.begin(), keys.begin() + 10);
+   std::ranges::shuffle(shuffled, std::mt19937{3});
+   shuffled.push_back(BedRecords::packKey(1, 10, 'a'));
+
+   BedData::CpGKeySet::Builder builder{};
+   for (const GenomicKey key : shuffled) builder.add(key);
+   EXPECT_FALSE(builder.isSorted());
+   const BedData::CpGKeySet set{std::move(builder).build()};
+
+   GenomicKeys expected{keys};
+   expected.push_back(BedRecords::packKey(1, 10, 'a'));
+   std::ranges::sort(expected);
+   EXPECT_EQ(set.keys(), expected);
+   EXPECT_TRUE(set.contains(BedRecords::packKey(1, 10, 'a')));
+   EXPECT_FALSE(set.contains(BedRecords::packKey(1, 10, 'b')));
+}
+
+TEST_F(CpGKeySetTest, FindsKeyRangesAndStaysSmall) {
+   const GenomicKeys keys{randomKeys(100'000)};
+   const BedData::CpGKeySet set{keys};
+
+   ASSERT_EQ(set.keyRanges().size(), 4);
+   EXPECT_EQ(set.keyRanges().front().first, keys.front());
+   EXPECT_EQ(set.keyRanges().back().last, keys.back());
+   for (const auto& range : set.keyRanges()) {
+      EXPECT_EQ(BedRecords::chromosomeOfKey(range.first),
+                BedRecords::chromosomeOfKey(range.last));
+   }
+
+   // Gaps of ~200 bases take two bytes, so well under the 8 bytes of a key
+   EXPECT_LT(set.memoryUsage() * 8, keys.size() * 32);
+   EXPECT_TRUE(BedData::CpGKeySet{}.empty());
+   EXPECT_FALSE(BedData::CpGKeySet{}.cursor().contains(keys.front()));
+}
+}  // namespace Hylord
@@ -0,0 +1,63 @@
+#include "io/DecimalParsing.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Hylord {
+class DecimalParsingTest : public ::testing::Test {
+  protected:
+   static auto parse(const std::string& text) -> double {
+      return IO::parseDecimal(text.data(), text.data() + text.size());
+   }
+};
+
+TEST_F(DecimalParsingTest, MatchesStrtodForFixedFormatValues) {
+   const std::vector<std::string> values{"0",
+                                         "100",
+                                         "65.16",
+                                         "0.01",
+                                         "-3.5",
+                                         "12345678.9",
+                                         "0.123456789012345",
+                                         "99.999",
+                                         "7."};
+   for (const auto& value : values) {
+      EXPECT_EQ(parse(value), std::strtod(value.c_str(), nullptr)) << value;
+   }
+}
+
+TEST_F(DecimalParsingTest, MatchesStrtodForRandomPercentages) {
+   std::mt19937 generator{42};
+   std::uniform_real_distribution<double> percentage{0.0, 100.0};
+   for (int i{}; i < 10000; ++i) {
+      const std::string value{std::to_string(percentage(generator))};
+      EXPECT_EQ(parse(value), std::strtod(value.c_str(), nullptr)) << value;
+   }
+}
+
+TEST_F(DecimalParsingTest, FallsBackForOtherFormats) {
+   EXPECT_FALSE(IO::parseFixedDecimal("1e3", "1e3" + 3).has_value());
+   EXPECT_DOUBLE_EQ(parse("1e3"), 1000.0);
+   EXPECT_DOUBLE_EQ(parse("1234567890.1234567890"), 1234567890.1234567890);
+}
+
+TEST_F(DecimalParsingTest, StopsAtEndOfNumber) {
+   const std::string line{"12.5\t7"};
+   const auto parsed{
+       IO::parseFixedDecimal(line.data(), line.data() + line.size())};
+   ASSERT_TRUE(parsed.has_value());
+   EXPECT_DOUBLE_EQ(parsed->value, 12.5);
+   EXPECT_EQ(*parsed->end, '\t');
+}
+
+TEST_F(DecimalParsingTest, ThrowsOnNonNumbers) {
+   EXPECT_THROW(parse(""), std::invalid_argument);
+   EXPECT_THROW(parse("abc"), std::invalid_argument);
+   EXPECT_THROW(parse("12.5x"), std::invalid_argument);
+}
+}  // namespace Hylord
@@ -0,0 +1,91 @@
+#include "core/ReadAssigner.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "data/BedData.hpp"
+#include "data/BedRecords.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class ReadAssignmentTest : public ::testing::Test {
+  protected:
+   // Two cell types, one methylated and one unmethylated at every site
+   static auto createReference(int sites) -> BedData::ReferenceMatrixData {
+      std::vector<BedRecords::Bed4> records{};
+      Matrix proportions{sites, 2};
+      for (int i{}; i < sites; ++i) {
+         BedRecords::Bed4 record{};
+         record.chromosome = 1;
+         record.start = 100 * i;
+         record.name = 'm';
+         records.push_back(record);
+         proportions.row(i) << 0.9, 0.1;
+      }
+      return BedData::ReferenceMatrixData{std::move(records), proportions};
+   }
+
+   static auto createCall(const std::string& read_id,
+                          int start,
+                          char call_code,
+                          char strand = '+') -> BedRecords::ReadCall {
+      BedRecords::ReadCall call{};
+      call.read_id = read_id;
+      call.chromosome = 1;
+      call.start = start;
+      call.name = call_code;
+      call.strand = strand;
+      return call;
+   }
+};
+
+TEST_F(ReadAssignmentTest, AssignsReadsToMostLikelyCellType) {
+   const ReadAssignment::ReadAssigner assigner{createReference(5), 3};
+   std::vector<BedRecords::ReadCall> calls{};
+   for (int i{}; i < 5; ++i) calls.push_back(createCall("a", 100 * i, 'm'));
+   // Reverse strand calls are reported one base after the C
+   for (int i{}; i < 5; ++i) {
+      calls.push_back(createCall("b", 100 * i + 1, '-', '-'));
+   }
+
+   const auto assignments{assigner.assign(calls, 2)};
+   ASSERT_EQ(assignments.size(), 2);
+   EXPECT_EQ(assignments[0].read_id, "a");
+   EXPECT_EQ(assignments[0].cell_type, 0);
+   EXPECT_EQ(assignments[0].calls, 5);
+   EXPECT_GT(assignments[0].posterior, 0.99);
+   EXPECT_EQ(assignments[1].cell_type, 1);
+   EXPECT_EQ(assignments[1].calls, 5);
+}
+
+TEST_F(ReadAssignmentTest, LeavesReadsWithFewCallsUnassigned) {
+   const ReadAssignment::ReadAssigner assigner{createReference(5), 3};
+   // Only two calls are at reference sites
+   const std::vector<BedRecords::ReadCall> calls{createCall("a", 0, 'm'),
+                                                 createCall("a", 50, 'm'),
+                                                 createCall("a", 100, 'm')};
+
+   const auto assignments{assigner.assign(calls, 1)};
+   ASSERT_EQ(assignments.size(), 1);
+   EXPECT_EQ(assignments[0].cell_type,
+             ReadAssignment::Assignment::unassigned);
+   EXPECT_EQ(assignments[0].calls, 2);
+}
+
+TEST_F(ReadAssignmentTest, SplitsOffLastRead) {
+   std::vector<BedRecords::ReadCall> calls{createCall("a", 0, 'm'),
+                                           createCall("b", 0, 'm'),
+                                           createCall("b", 100, 'm')};
+   const auto last_read{ReadAssignment::splitOffLastRead(calls)};
+   ASSERT_EQ(calls.size(), 1);
+   EXPECT_EQ(calls[0].read_id, "a");
+   ASSERT_EQ(last_read.size(), 2);
+   EXPECT_EQ(last_read[1].start, 100);
+
+   std::vector<BedRecords::ReadCall> single_read{createCall("c", 0, 'm')};
+   EXPECT_EQ(ReadAssignment::splitOffLastRead(single_read).size(), 1);
+   EXPECT_TRUE(single_read.empty());
+}
+}  // namespace Hylord
@@ -76,13 +76,15 @@ TEST(ReferenceMatrixRowParsingTest, ThrowsOnTooFewFields) {
 }
 
 TEST(BedMethylRowParsing, BasicFunctionality) {
-   const BedRecords::Bed9Plus9 expected_parsed_fields{1, 1000, 'h', 0.1};
+   const BedRecords::Bed9Plus9 expected_parsed_fields{1, 1000, 'h', 100, 0.1};
    const Fields input_fields{"chr1", "1000", "1001", "h", "100", "10"};
    BedRecords::Bed9Plus9 actual_parsed_fields{
        BedRecords::Bed9Plus9::fromFields(input_fields)};
    EXPECT_EQ(actual_parsed_fields.name, expected_parsed_fields.name);
    EXPECT_EQ(actual_parsed_fields.start, expected_parsed_fields.start);
    EXPECT_EQ(actual_parsed_fields.name, expected_parsed_fields.name);
+   EXPECT_EQ(actual_parsed_fields.read_depth,
+             expected_parsed_fields.read_depth);
    EXPECT_EQ(actual_parsed_fields.methylation_proportion,
              expected_parsed_fields.methylation_proportion);
 }
@@ -100,4 +102,21 @@ TEST(BedMethylRowParsing, ThrowsOnTooFewFields) {
                 std::out_of_range);
 }
 
+TEST(BedGraphRowParsing, TagsRowWithMark) {
+   const Fields input_fields{"chr2", "1000", "1001", "0.25", "40"};
+   const BedRecords::Bed9Plus9 tagged{
+       BedRecords::BedGraph::fromFields(input_fields).tag('m')};
+   EXPECT_EQ(tagged.chromosome, 2);
+   EXPECT_EQ(tagged.start, 1000);
+   EXPECT_EQ(tagged.name, 'm');
+   EXPECT_EQ(tagged.read_depth, 40);
+   EXPECT_DOUBLE_EQ(tagged.methylation_proportion, 0.25);
+}
+
+TEST(BedGraphRowParsing, ThrowsOnTooFewFields) {
+   const Fields input_fields{"chr2", "1000", "1001", "0.25"};
+   EXPECT_THROW(BedRecords::BedGraph::fromFields(input_fields),
+                std::out_of_range);
+}
+
 }  // namespace Hylord
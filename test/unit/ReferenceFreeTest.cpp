@@ -0,0 +1,97 @@
+#include "core/ReferenceFree.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "core/Deconvolver.hpp"
+#include "data/BedRecords.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class ReferenceFreeTest : public ::testing::Test {
+  protected:
+   // Alternating methylation and hydroxymethylation rows
+   static auto createRows(int sites) -> std::vector<BedRecords::Bed9Plus9> {
+      std::vector<BedRecords::Bed9Plus9> rows{};
+      for (int i{}; i < sites; ++i) {
+         BedRecords::Bed9Plus9 row{};
+         row.chromosome = 1;
+         row.start = 100 * (i / 2);
+         row.name = i % 2 == 0 ? 'm' : 'h';
+         row.methylation_proportion = (i % 7) / 7.0;
+         rows.push_back(row);
+      }
+      return rows;
+   }
+
+   static auto bulkOf(const std::vector<BedRecords::Bed9Plus9>& rows)
+       -> Vector {
+      Vector bulk(std::ssize(rows));
+      for (Eigen::Index i{}; i < bulk.size(); ++i) {
+         bulk(i) = rows[static_cast<std::size_t>(i)].methylation_proportion;
+      }
+      return bulk;
+   }
+};
+
+TEST_F(ReferenceFreeTest, InitialProfilesAreValidMethylationLevels) {
+   const auto rows{createRows(1000)};
+   const Matrix profiles{ReferenceFree::initialProfiles(rows, 3)};
+   EXPECT_EQ(profiles.rows(), 1000);
+   EXPECT_EQ(profiles.cols(), 3);
+   EXPECT_GE(profiles.minCoeff(), 0.0);
+   EXPECT_LE(profiles.maxCoeff(), 1.0);
+}
+
+TEST_F(ReferenceFreeTest, UpdateReducesResidualAndKeepsProfilesInRange) {
+   const auto rows{createRows(1000)};
+   const Vector bulk{bulkOf(rows)};
+   Matrix profiles{ReferenceFree::initialProfiles(rows, 3)};
+   Vector proportions(3);
+   proportions << 0.5, 0.3, 0.2;
+
+   const double before{(bulk - profiles * proportions).squaredNorm()};
+   const double after{
+       ReferenceFree::updateProfiles(profiles, proportions, bulk, 1)};
+   EXPECT_LT(after, before);
+   EXPECT_NEAR(after, (bulk - profiles * proportions).squaredNorm(), 1e-9);
+   EXPECT_GE(profiles.minCoeff(), 0.0);
+   EXPECT_LE(profiles.maxCoeff(), 1.0);
+}
+
+TEST_F(ReferenceFreeTest, UpdateDoesNotDependOnThreads) {
+   const auto rows{createRows(1337)};
+   const Vector bulk{bulkOf(rows)};
+   Matrix serial{ReferenceFree::initialProfiles(rows, 4)};
+   Matrix parallel{serial};
+   Vector proportions(4);
+   proportions << 0.1, 0.2, 0.3, 0.4;
+
+   const double serial_residual{
+       ReferenceFree::updateProfiles(serial, proportions, bulk, 1)};
+   const double parallel_residual{
+       ReferenceFree::updateProfiles(parallel, proportions, bulk, 4)};
+   EXPECT_EQ(serial, parallel);
+   EXPECT_NEAR(serial_residual, parallel_residual, 1e-12);
+}
+
+TEST_F(ReferenceFreeTest, FactorisationFitsBulkWithValidProportions) {
+   const auto rows{createRows(500)};
+   const Vector bulk{bulkOf(rows)};
+   Matrix profiles{ReferenceFree::initialProfiles(rows, 3)};
+   Deconvolution::Deconvolver deconvolver{3, bulk};
+
+   const ReferenceFree::Result result{ReferenceFree::factorise(
+       deconvolver,
+       profiles,
+       bulk,
+       {.max_iterations = 10, .convergence_threshold = 1e-8, .threads = 2})};
+   EXPECT_GE(result.iterations, 1);
+   EXPECT_LE(result.iterations, 10);
+   EXPECT_LT(result.objective, 1e-2);
+   EXPECT_NEAR(deconvolver.cellProportions().sum(), 1.0, 1e-9);
+   EXPECT_GE(deconvolver.cellProportions().minCoeff(), -1e-12);
+}
+}  // namespace Hylord
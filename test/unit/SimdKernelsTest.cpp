@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "maths/LinearAlgebra.hpp"
+#include "simd/Dispatch.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class SimdKernelsTest : public ::testing::Test {
+  protected:
+   /// Every instruction set this CPU can run (beyond the generic kernels).
+   static auto supportedIsas() -> std::vector<Simd::Isa> {
+      std::vector<Simd::Isa> isas{};
+      for (auto isa : {Simd::Isa::sse2, Simd::Isa::avx2, Simd::Isa::avx512}) {
+         if (isa <= Simd::detectIsa()) isas.push_back(isa);
+      }
+      return isas;
+   }
+
+   static auto randomMatrix(Eigen::Index rows, Eigen::Index cols) -> Matrix {
+      std::mt19937 generator{42};
+      std::uniform_real_distribution<double> proportion{0.0, 1.0};
+      Matrix matrix{rows, cols};
+      for (auto& value : matrix.reshaped()) value = proportion(generator);
+      return matrix;
+   }
+};
+
+TEST_F(SimdKernelsTest, FindsSameDelimitersAsGenericKernel) {
+   const auto& generic{Simd::kernelsFor(Simd::Isa::generic)};
+   std::mt19937 generator{42};
+   std::uniform_int_distribution<int> character{0, 30};
+   for (auto isa : supportedIsas()) {
+      const auto& kernels{Simd::kernelsFor(isa)};
+      for (std::size_t length{}; length < 200; ++length) {
+         // Sized exactly, so kernels must not rely on reading past the end
+         std::vector<char> text(length);
+         for (auto& byte : text) {
+            const int choice{character(generator)};
+            byte = choice == 0 ? '\t' : (choice == 1 ? ' ' : 'a');
+         }
+         const char* end{text.data() + text.size()};
+         for (const char* start{text.data()}; start < end; ++start) {
+            EXPECT_EQ(kernels.find_delimiter(start, end),
+                      generic.find_delimiter(start, end))
+                << Simd::isaName(isa);
+         }
+      }
+   }
+}
+
+TEST_F(SimdKernelsTest, ParsesSameDecimalsAsGenericKernel) {
+   const auto& generic{Simd::kernelsFor(Simd::Isa::generic)};
+   std::vector<std::string> numbers{"0",
+                                    "65.16",
+                                    "-3.5",
+                                    "7.",
+                                    ".5",
+                                    "-",
+                                    "1e3",
+                                    "123456789012345",
+                                    "1234567890123456",
+                                    "0.123456789012345",
+                                    "12345678.9012345",
+                                    "abc"};
+   std::mt19937 generator{42};
+   std::uniform_real_distribution<double> percentage{0.0, 100.0};
+   for (int i{}; i < 1000; ++i) {
+      numbers.push_back(std::to_string(percentage(generator)));
+   }
+
+   for (auto isa : supportedIsas()) {
+      const auto& kernels{Simd::kernelsFor(isa)};
+      for (const auto& number : numbers) {
+         // Both followed by other fields and at the very end of memory
+         for (const std::string& text :
+              {number + "\t42.5\t17\tchr1\t", number}) {
+            std::vector<char> bytes(text.begin(), text.end());
+            const char* end{bytes.data() + bytes.size()};
+            double value{};
+            double expected_value{};
+            const char* parsed_end{
+                kernels.parse_fixed_decimal(bytes.data(), end, value)};
+            const char* expected_end{generic.parse_fixed_decimal(
+                bytes.data(), end, expected_value)};
+            ASSERT_EQ(parsed_end, expected_end)
+                << Simd::isaName(isa) << ": " << number;
+            if (expected_end != nullptr) {
+               EXPECT_EQ(value, expected_value)
+                   << Simd::isaName(isa) << ": " << number;
+            }
+         }
+      }
+   }
+}
+
+TEST_F(SimdKernelsTest, MathsKernelsMatchEigen) {
+   // Odd sizes, so every kernel has a remainder to handle
+   const Matrix reference{randomMatrix(1001, 7)};
+   const Vector bulk{randomMatrix(1001, 1)};
+   const Vector proportions{Vector::Constant(7, 1.0 / 7)};
+   const Matrix expected_gram{reference.transpose() * reference};
+   const Vector expected_linear{reference.transpose() * bulk};
+   const double expected_residual{
+       (bulk - reference * proportions).squaredNorm()};
+
+   for (auto isa : supportedIsas()) {
+      const auto& kernels{Simd::kernelsFor(isa)};
+      Matrix gram{Matrix::Zero(7, 7)};
+      Vector linear{Vector::Zero(7)};
+      kernels.accumulate_gram(reference.data(),
+                              reference.outerStride(),
+                              reference.rows(),
+                              reference.cols(),
+                              bulk.data(),
+                              gram.data(),
+                              linear.data());
+      EXPECT_TRUE(gram.triangularView<Eigen::Upper>().toDenseMatrix().isApprox(
+          expected_gram.triangularView<Eigen::Upper>().toDenseMatrix()))
+          << Simd::isaName(isa);
+      EXPECT_TRUE(linear.isApprox(expected_linear)) << Simd::isaName(isa);
+      EXPECT_NEAR(kernels.residual_squared_norm(reference.data(),
+                                                reference.outerStride(),
+                                                reference.rows(),
+                                                reference.cols(),
+                                                proportions.data(),
+                                                bulk.data()),
+                  expected_residual,
+                  1e-9 * expected_residual)
+          << Simd::isaName(isa);
+   }
+}
+
+TEST_F(SimdKernelsTest, QuadraticTermsMatchSeparateComputations) {
+   const Matrix reference{randomMatrix(1000, 5)};
+   const Vector bulk{reference * Vector::Constant(5, 0.2)};
+
+   const auto terms{LinearAlgebra::quadraticTerms(reference, bulk)};
+   EXPECT_TRUE(terms.hessian.isApprox(LinearAlgebra::gramMatrix(reference)));
+   EXPECT_TRUE(terms.linear_terms.isApprox(
+       LinearAlgebra::generateCoefficientVector(reference, bulk)));
+   EXPECT_NEAR(LinearAlgebra::residualNorm(
+                   reference, Vector::Constant(5, 0.2), bulk),
+               0.0,
+               1e-12);
+}
+
+TEST_F(SimdKernelsTest, FusedReferenceUpdateMatchesSeparatePasses) {
+   const Matrix original{randomMatrix(1000, 5)};
+   const Vector bulk{randomMatrix(1000, 1)};
+   Vector proportions(5);
+   proportions << 0.3, 0.2, 0.1, 0.25, 0.15;
+
+   // Unclamped novel profiles fall both below 0 and above 1 here
+   Matrix expected{original};
+   const Vector residual{bulk - original.leftCols(3) * proportions.head(3)};
+   expected.rightCols(2) =
+       (residual * LinearAlgebra::pseudoInverse(proportions.tail(2)))
+           .cwiseMax(0.0)
+           .cwiseMin(1.0);
+   const auto expected_terms{LinearAlgebra::quadraticTerms(expected, bulk)};
+
+   for (const int threads : {1, 3}) {
+      Matrix reference{original};
+      const auto update{LinearAlgebra::updateReferenceMatrix(
+          reference, proportions, bulk, 2, threads)};
+      EXPECT_TRUE(reference.isApprox(expected)) << threads;
+      EXPECT_TRUE(update.terms.hessian.isApprox(expected_terms.hessian))
+          << threads;
+      EXPECT_TRUE(
+          update.terms.linear_terms.isApprox(expected_terms.linear_terms))
+          << threads;
+      EXPECT_NEAR(update.objective,
+                  LinearAlgebra::residualNorm(expected, proportions, bulk),
+                  1e-9);
+   }
+}
+}  // namespace Hylord
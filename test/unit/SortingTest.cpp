@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "data/BedData.hpp"
+#include "data/BedRecords.hpp"
+#include "data/Sorting.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class SortingTest : public ::testing::Test {
+  protected:
+   static auto createBed9Plus9(int chromosome, int start, char name)
+       -> BedRecords::Bed9Plus9 {
+      BedRecords::Bed9Plus9 record;
+      record.chromosome = chromosome;
+      record.start = start;
+      record.name = name;
+      return record;
+   }
+
+   static auto randomKeys(std::size_t size) -> GenomicKeys {
+      std::mt19937 generator{42};
+      std::uniform_int_distribution<int> chromosome{1, 25};
+      std::uniform_int_distribution<int> start{0, 1000};
+      std::bernoulli_distribution is_methylation{0.5};
+      GenomicKeys keys(size);
+      for (auto& key : keys) {
+         key = BedRecords::packKey(chromosome(generator),
+                                   start(generator),
+                                   is_methylation(generator) ? 'm' : 'h');
+      }
+      return keys;
+   }
+
+   static auto expectedPermutation(const GenomicKeys& keys) -> RowIndexes {
+      RowIndexes permutation(keys.size());
+      std::iota(permutation.begin(), permutation.end(), RowIndex{});
+      std::ranges::stable_sort(
+          permutation, {}, [&](RowIndex i) { return keys[i]; });
+      return permutation;
+   }
+};
+
+TEST_F(SortingTest, PackedKeysPreserveFieldOrdering) {
+   EXPECT_LT(BedRecords::packKey(1, 200, 'm'),
+             BedRecords::packKey(2, 100, 'h'));
+   EXPECT_LT(BedRecords::packKey(1, 100, 'm'),
+             BedRecords::packKey(1, 200, 'h'));
+   EXPECT_LT(BedRecords::packKey(1, 100, 'h'),
+             BedRecords::packKey(1, 100, 'm'));
+}
+
+TEST_F(SortingTest, RadixSortMatchesStableSort) {
+   const GenomicKeys keys{randomKeys(5000)};
+   EXPECT_EQ(Sorting::sortedPermutation(keys, 1), expectedPermutation(keys));
+}
+
+TEST_F(SortingTest, ParallelRadixSortMatchesStableSort) {
+   const GenomicKeys keys{randomKeys(200000)};
+   EXPECT_EQ(Sorting::sortedPermutation(keys, 4), expectedPermutation(keys));
+}
+
+TEST_F(SortingTest, HandlesTrivialInputs) {
+   EXPECT_TRUE(Sorting::sortedPermutation({}, 4).empty());
+   const GenomicKeys identical_keys(10, BedRecords::packKey(1, 1, 'm'));
+   EXPECT_EQ(Sorting::sortedPermutation(identical_keys, 4),
+             expectedPermutation(identical_keys));
+}
+
+TEST_F(SortingTest, UnsortedCollectionsAreDetectedAndSorted) {
+   BedData::BedMethylData bedmethyl{{createBed9Plus9(2, 100, 'm'),
+                                     createBed9Plus9(1, 200, 'm'),
+                                     createBed9Plus9(1, 200, 'h'),
+                                     createBed9Plus9(1, 100, 'm')}};
+   ASSERT_FALSE(bedmethyl.isSorted());
+   bedmethyl.sortRows(2);
+   EXPECT_TRUE(bedmethyl.isSorted());
+   EXPECT_TRUE(BedData::isSortedByKey(bedmethyl.records()));
+   EXPECT_EQ(bedmethyl.records().front().start, 100);
+   EXPECT_EQ(bedmethyl.records().back().chromosome, 2);
+}
+}  // namespace Hylord
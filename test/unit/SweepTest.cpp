@@ -0,0 +1,100 @@
+#include "core/Sweep.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "cli.hpp"
+#include "data/Filters.hpp"
+#include "types.hpp"
+
+namespace Hylord {
+class SweepTest : public ::testing::Test {
+  protected:
+   static auto createColumns() -> Sweep::FilterColumns {
+      Sweep::FilterColumns columns{};
+      for (int i{}; i < 60; ++i) {
+         columns.read_depths.push_back(i % 30);
+         columns.names.push_back(i % 2 == 0 ? 'm' : 'h');
+      }
+      return columns;
+   }
+};
+
+TEST_F(SweepTest, SelectsSameRowsAsRowFilter) {
+   const Sweep::FilterColumns columns{createColumns()};
+   CMD::HylordConfig config{};
+   config.sweep_min_read_depths = {0, 5, std::numeric_limits<int>::max()};
+   config.sweep_max_read_depths = {20, std::numeric_limits<int>::max()};
+   config.sweep_signals = {"m", "h", "both"};
+   const std::vector<Sweep::Configuration> configurations{
+       Sweep::configurations(config)};
+   ASSERT_EQ(configurations.size(), 18);
+
+   for (const auto& configuration : configurations) {
+      config.min_read_depth = configuration.min_read_depth;
+      config.max_read_depth = configuration.max_read_depth;
+      config.use_only_methylation_signal = configuration.signal == 'm';
+      config.use_only_hydroxy_signal = configuration.signal == 'h';
+      const IO::RowFilter row_filter{
+          Filters::generateBedmethylRowFilter(config)};
+
+      RowIndexes expected_rows{};
+      for (std::size_t i{}; i < columns.names.size(); ++i) {
+         const Fields fields{"chr1",
+                             std::to_string(i),
+                             std::to_string(i + 1),
+                             std::string(1, columns.names[i]),
+                             std::to_string(columns.read_depths[i]),
+                             "50"};
+         if (!row_filter || row_filter(fields)) {
+            expected_rows.push_back(static_cast<RowIndex>(i));
+         }
+      }
+      EXPECT_EQ(Sweep::selectRows(columns, configuration), expected_rows);
+   }
+}
+
+TEST_F(SweepTest, UsesConfiguredFiltersWhenNotSwept) {
+   CMD::HylordConfig config{};
+   config.min_read_depth = 7;
+   config.use_only_hydroxy_signal = true;
+   config.sweep_max_read_depths = {10, 20};
+   const std::vector<Sweep::Configuration> configurations{
+       Sweep::configurations(config)};
+
+   ASSERT_EQ(configurations.size(), 2);
+   EXPECT_EQ(configurations[1].min_read_depth, 7);
+   EXPECT_EQ(configurations[1].max_read_depth, 20);
+   EXPECT_EQ(configurations[1].signal, 'h');
+}
+
+TEST_F(SweepTest, SolvesEachConfigurationOnItsRows) {
+   const Sweep::FilterColumns columns{createColumns()};
+   Matrix reference_matrix(60, 2);
+   reference_matrix.col(0).setLinSpaced(0.0, 1.0);
+   reference_matrix.col(1).setLinSpaced(1.0, 0.0);
+   // Methylation rows are 75% cell type 0, hydroxymethylation rows 25%
+   Vector bulk_profile(60);
+   for (Eigen::Index i{}; i < 60; ++i) {
+      const double weight{i % 2 == 0 ? 0.75 : 0.25};
+      bulk_profile(i) = weight * reference_matrix(i, 0) +
+                        (1 - weight) * reference_matrix(i, 1);
+   }
+   const std::vector<Sweep::Configuration> configurations{
+       {.signal = 'm'}, {.signal = 'h'}, {.min_read_depth = 100}};
+
+   const std::vector<Sweep::Result> results{Sweep::solve(
+       reference_matrix, bulk_profile, columns, configurations, 3)};
+   ASSERT_EQ(results.size(), 3);
+   EXPECT_EQ(results[0].cpgs, 30);
+   EXPECT_NEAR(results[0].cell_proportions(0), 0.75, 1e-6);
+   EXPECT_NEAR(results[0].objective, 0.0, 1e-6);
+   EXPECT_NEAR(results[1].cell_proportions(0), 0.25, 1e-6);
+   EXPECT_EQ(results[2].cpgs, 0);
+   EXPECT_EQ(results[2].cell_proportions.size(), 0);
+}
+}  // namespace Hylord